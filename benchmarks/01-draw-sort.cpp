@@ -0,0 +1,113 @@
+// Compares the cost of ordering a frame's draw commands by sorting (program, vertex array, uniform, command) tuples
+// with std::sort against an LSD radix sort of packed 64-bit draw keys.
+
+#include "simple_renderer/radix_sort.hpp"
+
+#include "glm/mat4x4.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using Simple::Renderer::SortItem;
+
+struct FakeCommand
+{
+    std::uint32_t count;
+};
+
+using Tuple = std::tuple<std::uint32_t, std::uint32_t, const glm::mat4 *, const FakeCommand *>;
+
+struct Frame
+{
+    std::vector<glm::mat4> uniforms;
+    std::vector<FakeCommand> commands;
+    std::vector<Tuple> tuples;
+    std::vector<SortItem> sort_items;
+};
+
+Frame makeFrame(std::size_t draw_count, std::mt19937 &random)
+{
+    Frame frame;
+    frame.uniforms.resize(draw_count, glm::mat4(1.0f));
+    frame.commands.resize(draw_count);
+
+    std::uniform_int_distribution<std::uint32_t> program_distribution{1, 16};
+    std::uniform_int_distribution<std::uint32_t> vertex_array_distribution{1, std::max<std::uint32_t>(1, draw_count / 8)};
+    std::uniform_int_distribution<std::uint32_t> depth_distribution{0, 0xFFFF};
+
+    for (std::size_t i = 0; i < draw_count; i++)
+    {
+        const std::uint32_t program = program_distribution(random);
+        const std::uint32_t vertex_array = vertex_array_distribution(random);
+
+        frame.tuples.emplace_back(program, vertex_array, &frame.uniforms[i], &frame.commands[i]);
+        frame.sort_items.push_back({std::uint64_t(program) << 36 | std::uint64_t(vertex_array) << 16
+                                    | depth_distribution(random),
+                                    static_cast<std::uint32_t>(i)});
+    }
+
+    // draws are collected by command type, not in any meaningful order
+    std::shuffle(frame.tuples.begin(), frame.tuples.end(), random);
+    std::shuffle(frame.sort_items.begin(), frame.sort_items.end(), random);
+
+    return frame;
+}
+
+/// Run @p func on a fresh copy of @p input several times and return the median duration in microseconds.
+template<typename T, typename Func>
+double measure(const std::vector<T> &input, Func &&func)
+{
+    constexpr int repetitions = 21;
+
+    std::vector<double> durations;
+    std::vector<T> values;
+
+    for (int i = 0; i < repetitions; i++)
+    {
+        values = input;
+
+        const auto start = std::chrono::steady_clock::now();
+        func(values);
+        const auto end = std::chrono::steady_clock::now();
+
+        durations.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    std::nth_element(durations.begin(), durations.begin() + repetitions / 2, durations.end());
+    return durations[repetitions / 2];
+}
+
+int main()
+{
+    std::mt19937 random{42};
+
+    std::cout << std::setw(10) << "draws"
+              << std::setw(20) << "tuple sort (us)"
+              << std::setw(20) << "radix sort (us)"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (std::size_t draw_count: {1000u, 10000u, 100000u})
+    {
+        const Frame frame = makeFrame(draw_count, random);
+
+        const double tuple_time = measure(frame.tuples, [](std::vector<Tuple> &tuples)
+        { std::sort(tuples.begin(), tuples.end()); });
+
+        std::vector<SortItem> scratch;
+        const double radix_time = measure(frame.sort_items, [&scratch](std::vector<SortItem> &items)
+        { Simple::Renderer::radixSort(items, scratch); });
+
+        std::cout << std::setw(10) << draw_count
+                  << std::setw(20) << std::fixed << std::setprecision(1) << tuple_time
+                  << std::setw(20) << radix_time
+                  << std::setw(9) << std::setprecision(2) << tuple_time / radix_time << "x\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Compares executing a sequence of draw commands through virtual calls on base class pointers against dispatching
+// on a compact type tag with TypeSet::visit, which calls each command with its type known at compile time.
+// The commands mirror the RendererCommandSet hierarchy, but accumulate their arguments instead of calling OpenGL.
+
+#include "simple_renderer/type_set.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+std::uint64_t sink = 0;
+
+struct Command
+{
+    virtual void operator()() const = 0;
+    std::uint32_t mode{4};
+};
+
+struct ArraysCommand : Command
+{
+    void operator()() const override
+    { sink += mode + first + count; }
+
+    std::uint32_t first{0};
+    std::uint32_t count{36};
+};
+
+struct ElementsCommand : Command
+{
+    void operator()() const override
+    { sink += mode + count + offset; }
+
+    std::uint32_t count{36};
+    std::uintptr_t offset{0};
+};
+
+struct ArraysInstancedCommand : ArraysCommand
+{
+    void operator()() const override
+    { sink += mode + first + count * instance_count; }
+
+    std::uint32_t instance_count{27};
+};
+
+struct ElementsInstancedCommand : ElementsCommand
+{
+    void operator()() const override
+    { sink += mode + offset + count * instance_count; }
+
+    std::uint32_t instance_count{27};
+};
+
+using CommandSet = Simple::TypeSet<ArraysCommand, ElementsCommand, ArraysInstancedCommand, ElementsInstancedCommand>;
+
+struct TaggedCommand
+{
+    std::uint8_t type;
+    const Command *command;
+};
+
+struct Sequence
+{
+    std::vector<ArraysCommand> arrays;
+    std::vector<ElementsCommand> elements;
+    std::vector<ArraysInstancedCommand> arrays_instanced;
+    std::vector<ElementsInstancedCommand> elements_instanced;
+
+    std::vector<const Command *> pointers;
+    std::vector<TaggedCommand> tagged;
+};
+
+template<typename T>
+void addCommands(std::vector<T> &commands, std::size_t count, Sequence &sequence)
+{
+    commands.resize(count);
+    for (const T &command: commands)
+    {
+        sequence.pointers.push_back(&command);
+        sequence.tagged.push_back({static_cast<std::uint8_t>(CommandSet::type_index<T>), &command});
+    }
+}
+
+void fillSequence(Sequence &sequence, std::size_t command_count, std::mt19937 &random)
+{
+    // mostly non-instanced commands, as in a typical scene
+    addCommands(sequence.arrays, command_count / 4, sequence);
+    addCommands(sequence.elements, command_count / 2, sequence);
+    addCommands(sequence.arrays_instanced, command_count / 8, sequence);
+    addCommands(sequence.elements_instanced, command_count - sequence.pointers.size(), sequence);
+
+    // after sorting by program and vertex array, command types are interleaved unpredictably
+    std::vector<std::size_t> order(sequence.pointers.size());
+    for (std::size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), random);
+
+    std::vector<const Command *> pointers;
+    std::vector<TaggedCommand> tagged;
+    for (std::size_t i: order)
+    {
+        pointers.push_back(sequence.pointers[i]);
+        tagged.push_back(sequence.tagged[i]);
+    }
+
+    sequence.pointers = std::move(pointers);
+    sequence.tagged = std::move(tagged);
+}
+
+void executeVirtual(const Sequence &sequence)
+{
+    for (const Command *command: sequence.pointers)
+        (*command)();
+}
+
+void executeTagged(const Sequence &sequence)
+{
+    for (const auto &[type, command]: sequence.tagged)
+    {
+        CommandSet::visit(type, [command = command](auto type_tag)
+        {
+            using T = typename decltype(type_tag)::Type;
+            static_cast<const T &>(*command).T::operator()();
+        });
+    }
+}
+
+/// Median duration of @p func, in microseconds.
+template<typename Func>
+double measure(const Sequence &sequence, Func &&func)
+{
+    constexpr int repetitions = 51;
+    std::vector<double> durations;
+
+    for (int i = 0; i < repetitions; i++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        func(sequence);
+        const auto end = std::chrono::steady_clock::now();
+
+        durations.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+
+    std::nth_element(durations.begin(), durations.begin() + repetitions / 2, durations.end());
+    return durations[repetitions / 2];
+}
+
+int main()
+{
+    std::mt19937 random{42};
+
+    std::cout << std::setw(10) << "commands"
+              << std::setw(18) << "virtual (us)"
+              << std::setw(18) << "type tag (us)"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (std::size_t command_count: {1000u, 10000u, 100000u})
+    {
+        Sequence sequence;
+        fillSequence(sequence, command_count, random);
+
+        const double virtual_time = measure(sequence, executeVirtual);
+        const double tagged_time = measure(sequence, executeTagged);
+
+        std::cout << std::setw(10) << command_count
+                  << std::setw(18) << std::fixed << std::setprecision(1) << virtual_time
+                  << std::setw(18) << tagged_time
+                  << std::setw(9) << std::setprecision(2) << virtual_time / tagged_time << "x\n";
+    }
+
+    return sink == 0;
+}
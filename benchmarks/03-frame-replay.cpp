@@ -0,0 +1,86 @@
+// Replays a frame captured with RenderQueue::captureNextFrame() in a loop, and reports the average time spent in each
+// phase of RenderQueue::finishFrame(). Uses an invisible window, so it also runs under a software OpenGL implementation.
+//
+// usage: 03-frame-replay <capture file> [frame count] [immediate|indirect]
+
+#include "simple_renderer/render_queue.hpp"
+#include "simple_renderer/frame_capture.hpp"
+
+#include "glutils/gl.hpp"
+
+#include "GLFW/glfw3.h"
+
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace Simple::Renderer;
+
+void printStats(const char *name, const FrameStats &stats)
+{
+    std::cout << std::setw(8) << name << std::fixed << std::setprecision(3)
+              << std::setw(10) << stats.getPhase(FramePhase::cull)
+              << std::setw(10) << stats.getPhase(FramePhase::build)
+              << std::setw(10) << stats.getPhase(FramePhase::sort)
+              << std::setw(10) << stats.getPhase(FramePhase::upload)
+              << std::setw(10) << stats.getPhase(FramePhase::submit)
+              << std::setw(10) << stats.cpu_ms
+              << std::setw(10) << stats.gpu_ms << "\n";
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv[0] << " <capture file> [frame count] [immediate|indirect]\n";
+        return EXIT_FAILURE;
+    }
+
+    const int frame_count = argc > 2 ? std::stoi(argv[2]) : 1000;
+    const bool use_indirect = argc > 3 && std::string(argv[3]) == "indirect";
+
+    glfwInit();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    const auto window = glfwCreateWindow(1024, 768, "Frame replay", nullptr, nullptr);
+    if (!window)
+    {
+        std::cerr << "window creation failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    glfwMakeContextCurrent(window);
+    GL::loadContext(glfwGetProcAddress);
+
+    try
+    {
+        const FrameReplay replay(FrameCapture::load(argv[1]));
+
+        RenderQueue render_queue;
+        render_queue.setSubmissionMode(use_indirect ? SubmissionMode::multi_draw_indirect : SubmissionMode::immediate);
+        render_queue.setProfiling(true);
+
+        for (int i = 0; i < frame_count; i++)
+        {
+            replay.draw(render_queue);
+            render_queue.finishFrame(replay.getCamera());
+            glfwSwapBuffers(window);
+        }
+
+        std::cout << std::setw(8) << "ms" << std::setw(10) << "cull" << std::setw(10) << "build"
+                  << std::setw(10) << "sort" << std::setw(10) << "upload" << std::setw(10) << "submit"
+                  << std::setw(10) << "cpu" << std::setw(10) << "gpu" << "\n";
+        printStats("last", render_queue.getFrameStats());
+        printStats("average", render_queue.getAverageFrameStats());
+    }
+    catch (const std::exception &exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
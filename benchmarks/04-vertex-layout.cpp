@@ -0,0 +1,178 @@
+// Compares the GPU time of drawing a vertex-bound mesh with planar and interleaved vertex layouts (see MeshLayout),
+// each with float and compact vertex encodings (see VertexEncoding).
+// The mesh has many vertices, referenced in a random order by its indices so that the post-transform cache rarely
+// hits, and is drawn to a one pixel viewport so that rasterization is negligible. Uses an invisible window.
+//
+// usage: 04-vertex-layout [vertex count] [frame count]
+
+#include "simple_renderer/memory_tracker.hpp"
+#include "simple_renderer/renderer.hpp"
+#include "simple_renderer/render_queue.hpp"
+
+#include "glutils/gl.hpp"
+
+#include "GLFW/glfw3.h"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Simple::Renderer;
+
+constexpr auto vert_src = R"glsl(
+out vec3 f_color;
+
+void main()
+{
+    gl_Position = proj_matrix * view_matrix * model_matrix * vec4(vertex_position, 1.0f);
+    f_color = vertex_normal * 0.5f + vec3(vertex_uv, 0.0f);
+}
+)glsl";
+
+// normals of compact meshes are octahedral encoded
+constexpr auto compact_vert_src = R"glsl(
+out vec3 f_color;
+
+void main()
+{
+    gl_Position = proj_matrix * view_matrix * model_matrix * vec4(vertex_position, 1.0f);
+    f_color = decode_octahedral_normal(vertex_normal.xy) * 0.5f + vec3(vertex_uv, 0.0f);
+}
+)glsl";
+
+constexpr auto frag_src = R"glsl(
+in vec3 f_color;
+
+void main()
+{
+    frag_color = vec4(f_color, 1.0f);
+}
+)glsl";
+
+struct MeshData
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> uvs;
+    std::vector<unsigned int> indices;
+};
+
+MeshData makeMeshData(std::size_t vertex_count)
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    MeshData data;
+    for (std::size_t i = 0; i < vertex_count; i++)
+    {
+        data.positions.emplace_back(distribution(random), distribution(random), distribution(random));
+        data.normals.emplace_back(distribution(random), distribution(random), distribution(random));
+        data.uvs.emplace_back(distribution(random), distribution(random));
+    }
+
+    // every vertex is used by three triangles, in a random order
+    for (int pass = 0; pass < 3; pass++)
+    {
+        std::vector<unsigned int> order(vertex_count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::shuffle(order.begin(), order.end(), random);
+        data.indices.insert(data.indices.end(), order.begin(), order.end() - vertex_count % 3);
+    }
+
+    return data;
+}
+
+double measure(const Mesh &mesh, const ShaderProgram &program, const Camera &camera, int frame_count,
+               GLFWwindow *window)
+{
+    RenderQueue render_queue;
+    render_queue.setProfiling(true);
+
+    for (int i = 0; i < frame_count; i++)
+    {
+        render_queue.draw(mesh, program, glm::mat4(1.0f));
+        render_queue.finishFrame(camera);
+        glfwSwapBuffers(window);
+    }
+
+    return render_queue.getAverageFrameStats().gpu_ms;
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t vertex_count = argc > 1 ? std::stoul(argv[1]) : 4'000'000;
+    const int frame_count = argc > 2 ? std::stoi(argv[2]) : 200;
+
+    glfwInit();
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    const auto window = glfwCreateWindow(64, 64, "Vertex layout", nullptr, nullptr);
+    if (!window)
+    {
+        std::cerr << "window creation failed" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    glfwMakeContextCurrent(window);
+    GL::loadContext(glfwGetProcAddress);
+
+    try
+    {
+        const MeshData data = makeMeshData(vertex_count);
+
+        const ShaderProgram program{vert_src, frag_src};
+        const ShaderProgram compact_program{compact_vert_src, frag_src};
+        const Camera camera;
+        setViewport(glm::ivec2(0), glm::ivec2(1));
+
+        struct Case
+        {
+            const char *name;
+            MeshLayout layout;
+            VertexEncoding encoding;
+        };
+
+        const Case cases[] {
+                {"planar", MeshLayout::planar, {}},
+                {"interleaved", MeshLayout::interleaved, {}},
+                {"planar compact", MeshLayout::planar, VertexEncoding::compact()},
+                {"interleaved compact", MeshLayout::interleaved, VertexEncoding::compact()},
+        };
+
+        std::cout << vertex_count << " vertices, " << data.indices.size() / 3 << " triangles\n"
+                  << std::setw(20) << "" << std::setw(12) << "MiB" << std::setw(10) << "gpu ms" << "\n"
+                  << std::fixed << std::setprecision(3);
+
+        for (const Case &c: cases)
+        {
+            const std::size_t usage = MemoryTracker::get().getUsage(MemoryCategory::vertex);
+            const Mesh mesh{data.positions, data.normals, data.uvs, data.indices, c.layout, c.encoding};
+            const double mib = double(MemoryTracker::get().getUsage(MemoryCategory::vertex) - usage) / (1 << 20);
+
+            const ShaderProgram &mesh_program = c.encoding.isCompressed() ? compact_program : program;
+
+            // the first run warms up the driver
+            measure(mesh, mesh_program, camera, frame_count / 10 + 1, window);
+
+            std::cout << std::setw(20) << c.name << std::setw(12) << mib
+                      << std::setw(10) << measure(mesh, mesh_program, camera, frame_count, window) << "\n";
+        }
+    }
+    catch (const std::exception &exception)
+    {
+        std::cerr << exception.what() << std::endl;
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
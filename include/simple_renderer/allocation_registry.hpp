@@ -1,17 +1,38 @@
 #ifndef PROCEDURALPLACEMENTLIB_ALLOCATION_REGISTRY_HPP
 #define PROCEDURALPLACEMENTLIB_ALLOCATION_REGISTRY_HPP
 
-#include <vector>
+#include <array>
+#include <cstdint>
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace Simple {
 
-/// Keeps track of allocated memory, usually used for GPU buffers.
+/**
+ * @brief Keeps track of allocated memory, usually used for GPU buffers.
+ * Free blocks are kept in segregated lists, one for each size class, with a bitmap of the non-empty classes; this
+ * makes allocation and deallocation take constant time regardless of the number of blocks. Freed blocks are merged
+ * with free neighbours right away.
+ */
 class AllocationRegistry final
 {
 public:
     using uintptr = std::size_t;
 
+    /// Summary of how the free space of a registry is split.
+    struct FragmentationReport
+    {
+        uintptr free_bytes{0};
+        uintptr largest_free_block{0};
+        std::size_t free_block_count{0};
+        std::size_t used_block_count{0};
+
+        /// 1 - largest_free_block / free_bytes: 0 when all free space is contiguous, approaching 1 as it is split into
+        /// many small blocks. Zero if there is no free space.
+        double external_fragmentation{0.0};
+    };
+
     /// Base-2 exponent of the alignment value.
     static constexpr uintptr alignment_exp = 2;
 
@@ -33,34 +54,93 @@ public:
     /// Same as deallocate(), but returns false on failure instead of throwing an axception.
     bool tryDeallocate(uintptr offset) noexcept;
 
+    /// Move the allocated block at @p offset to the start of the free block right before it, if there is one.
+    /**
+     * The free space moves after the block, and is merged with the free block that follows, if any. Used to compact
+     * the memory tracked by the registry; moving the contents of the block is up to the caller.
+     * @return the new offset of the block, or an empty optional if @p offset is not allocated or isn't preceded by
+     * free space.
+     */
+    std::optional<uintptr> tryMoveDown(uintptr offset);
+
+    /// Check whether tryMoveDown() would succeed for @p offset.
+    [[nodiscard]] bool canMoveDown(uintptr offset) const noexcept;
+
     /// Return the biggest block that could be allocated.
     [[nodiscard]] uintptr getMaxAllocation() const noexcept;
 
+    [[nodiscard]] FragmentationReport getFragmentationReport() const noexcept;
+
 private:
+    using BlockIndex = std::uint32_t;
+
+    static constexpr BlockIndex s_no_block = -1u;
 
-    class Block
+    /// A contiguous range of memory, either used or free. Blocks are linked to their neighbours in memory, and free
+    /// blocks are also linked to the other free blocks of their size class.
+    struct Block
     {
-    public:
-        // here an alignment of at least 2 is assumed
-        constexpr Block(uintptr offset, bool is_used) noexcept : m_tagged_size((offset & s_size_mask) | is_used) {}
+        uintptr offset;
+        uintptr size;
+        BlockIndex prev_physical{s_no_block};
+        BlockIndex next_physical{s_no_block};
+        BlockIndex prev_free{s_no_block};
+        BlockIndex next_free{s_no_block};
+        bool is_free{false};
+    };
 
-        [[nodiscard]] constexpr bool isFree() const noexcept { return m_tagged_size & s_tag_mask; }
-        [[nodiscard]] constexpr uintptr getSize() const noexcept { return m_tagged_size & s_size_mask; }
+    // Size classes: sizes below s_class_subdivisions have a class each; above that, each power of two range is
+    // divided into s_class_subdivisions classes of equal width.
+    static constexpr unsigned s_class_subdivision_bits = 3;
+    static constexpr uintptr s_class_subdivisions = 1 << s_class_subdivision_bits;
+    static constexpr std::size_t s_class_group_count = sizeof(uintptr) * 8 - s_class_subdivision_bits + 1;
+    static constexpr std::size_t s_class_count = s_class_group_count * s_class_subdivisions;
 
-        constexpr void setIsFree(bool tag) noexcept { m_tagged_size = getSize() | tag; }
-        constexpr void setSize(uintptr offset) noexcept { m_tagged_size = (offset & s_size_mask) | isFree(); }
+    static_assert(s_class_subdivisions <= 8, "class bitmaps are 8 bits wide");
+    static_assert(s_class_group_count <= 64, "the group bitmap is 64 bits wide");
 
-    private:
-        static constexpr uintptr s_tag_mask = 0x1;
-        static constexpr uintptr s_size_mask = ~s_tag_mask;
+    /// Size class which holds blocks of @p size bytes.
+    static std::size_t s_getSizeClass(uintptr size) noexcept;
 
-        uintptr m_tagged_size;
-    };
+    /// Smallest size class whose blocks all have at least @p size bytes; may be s_class_count if there is none.
+    static std::size_t s_getFittingSizeClass(uintptr size) noexcept;
 
-    [[nodiscard]] auto m_findFreeBlock(uintptr size) noexcept;
+    /// Lowest non-empty size class greater or equal to @p size_class, or s_class_count if there is none.
+    [[nodiscard]] std::size_t m_findNonEmptyClass(std::size_t size_class) const noexcept;
 
+    /// Find a free block of at least @p size bytes, or return s_no_block.
+    [[nodiscard]] BlockIndex m_findFreeBlock(uintptr size) const noexcept;
+
+    void m_insertFreeBlock(BlockIndex index) noexcept;
+    void m_removeFreeBlock(BlockIndex index) noexcept;
+
+    /// Get an unused slot in m_blocks.
+    BlockIndex m_createBlock(const Block &block);
+
+    /// Merge the block at @p next into its free predecessor @p index, and release the slot of @p next.
+    void m_mergeWithNext(BlockIndex index, BlockIndex next) noexcept;
+
+    /// all blocks, free and used, in no particular order.
     std::vector<Block> m_blocks;
+
+    /// slots of m_blocks released by merging, reused by m_createBlock().
+    std::vector<BlockIndex> m_unused_blocks;
+
+    /// used blocks, by offset.
+    std::unordered_map<uintptr, BlockIndex> m_used_blocks;
+
+    /// first free block of each size class.
+    std::array<BlockIndex, s_class_count> m_free_lists;
+
+    /// bit i is set if group i has a non-empty class; each group holds s_class_subdivisions consecutive classes.
+    std::uint64_t m_group_bitmap{0};
+
+    /// bit j of element i is set if class i * s_class_subdivisions + j is non-empty.
+    std::array<std::uint8_t, s_class_group_count> m_class_bitmaps{};
+
     uintptr m_size;
+    uintptr m_free_bytes;
+    std::size_t m_free_block_count{0};
 };
 
 } // simple
@@ -0,0 +1,42 @@
+#ifndef SIMPLERENDERER_BOUNDING_BOX_HPP
+#define SIMPLERENDERER_BOUNDING_BOX_HPP
+
+#include "glm/vec3.hpp"
+#include "glm/common.hpp"
+
+namespace Simple::Renderer {
+
+/// An axis aligned box, given by its minimum and maximum corners.
+struct AxisAlignedBox
+{
+    glm::vec3 min{0.0f};
+    glm::vec3 max{0.0f};
+
+    [[nodiscard]] glm::vec3 getCenter() const
+    { return (min + max) * 0.5f; }
+
+    /// Half the size of the box along each axis.
+    [[nodiscard]] glm::vec3 getExtents() const
+    { return (max - min) * 0.5f; }
+
+    /// Grow the box so that it contains @p point.
+    void expand(const glm::vec3 &point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    /// Create a box which contains all points in [@p begin, @p end), which must not be empty.
+    template<typename Iterator>
+    static AxisAlignedBox fromPoints(Iterator begin, Iterator end)
+    {
+        AxisAlignedBox box{*begin, *begin};
+        for (; begin != end; ++begin)
+            box.expand(*begin);
+        return box;
+    }
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_BOUNDING_BOX_HPP
@@ -2,9 +2,13 @@
 #define SIMPLERENDERER_BUFFER_HPP
 
 #include "glutils/buffer.hpp"
+#include "memory_tracker.hpp"
 #include "typed_offset.hpp"
 #include "typed_range.hpp"
 
+#include <cstddef>
+#include <functional>
+
 namespace Simple::Renderer {
 
 template<typename>
@@ -146,6 +150,9 @@ class Buffer final
 public:
     using size_t = std::size_t;
 
+    /// Writes the initial contents of a buffer into write-only memory of the buffer's size.
+    using Initializer = std::function<void(std::byte *data)>;
+
     /// Creates an invalid Buffer object, which is not associated with any GPU buffer.
     constexpr Buffer() = default;
 
@@ -153,9 +160,17 @@ public:
      * @brief Construct a buffer of the specified size.
      * @param size The size of the buffer, in bytes.
      * @param data The data to initialize the buffer with. If null, the buffer's contents will be left uninitialized.
+     * @param category What the buffer is used for, for memory accounting.
      * If buffer allocation fails an empty buffer object will be created.
      */
-    explicit Buffer(size_t size, const void *data = nullptr);
+    explicit Buffer(size_t size, const void *data = nullptr, MemoryCategory category = MemoryCategory::vertex);
+
+    /**
+     * @brief Construct a buffer of the specified size, whose contents are written in place by @p initializer.
+     * The buffer's storage is mapped write-only and passed to @p initializer, so the data is never staged in host
+     * memory. Throws std::runtime_error if the storage can't be mapped, or if its contents were lost while mapped.
+     */
+    Buffer(size_t size, const Initializer &initializer, MemoryCategory category = MemoryCategory::vertex);
 
     /**
      * @brief Retrieve the size of the underlying buffer object.
@@ -219,6 +234,14 @@ public:
              static_cast<BufferRange<std::byte>>(to));
     }
 
+    /**
+     * @brief Record @p size bytes of the buffer under @p category instead of the buffer's own category, e.g. for the
+     * indices of a buffer that also holds vertices. The bytes are recorded under @p category for as long as the
+     * returned TrackedMemory exists, which should be as long as the buffer. Throws std::logic_error if @p size exceeds
+     * the memory still recorded under the buffer's category.
+     */
+    [[nodiscard]] TrackedMemory splitTrackedMemory(MemoryCategory category, size_t size);
+
     /// Returns the OpenGL handle for the GPU buffer.
     [[nodiscard]] GL::BufferHandle getGLHandle() const
     { return m_buffer; }
@@ -226,6 +249,7 @@ public:
 private:
     GL::Buffer m_buffer{GL::BufferHandle()};
     size_t m_size{0};   ///< size of the buffer in bytes
+    TrackedMemory m_memory;
 };
 
 template<>
@@ -20,6 +20,9 @@ public:
     [[nodiscard]] constexpr std::size_t getSize() const
     { return m_size; }
 
+    [[nodiscard]] constexpr GL::BufferHandle getBuffer() const
+    { return m_buffer; }
+
 protected:
     GL::BufferHandle m_buffer{};
     GLintptr m_offset{0};
@@ -1,6 +1,8 @@
 #ifndef SIMPLERENDERER_CAMERA_HPP
 #define SIMPLERENDERER_CAMERA_HPP
 
+#include "simple_renderer/memory_tracker.hpp"
+
 #include <glutils/buffer.hpp>
 #include <glutils/guard.hpp>
 
@@ -8,6 +10,8 @@
 
 namespace Simple::Renderer {
 
+class StreamBuffer;
+
 /// Encapsulates camera related data.
 class Camera
 {
@@ -16,16 +20,38 @@ class Camera
 public:
     Camera();
 
+    Camera(Camera &&) noexcept = default;
+    Camera &operator=(Camera &&other) noexcept;
+
+    ~Camera();
+
     /// Set the view transform, which is accesible as 'view_matrix' in shaders.
-    void setViewMatrix(const glm::mat4 &matrix) const;
+    void setViewMatrix(const glm::mat4 &matrix);
 
     /// Set the projection transform, which is accesible as 'proj_matrix' in shaders.
-    void setProjectionMatrix(const glm::mat4 &matrix) const;
+    void setProjectionMatrix(const glm::mat4 &matrix);
+
+    /// Same as setViewMatrix(const glm::mat4 &), but uploads the matrix through @p stream_buffer.
+    void setViewMatrix(const glm::mat4 &matrix, StreamBuffer &stream_buffer);
+
+    /// Same as setProjectionMatrix(const glm::mat4 &), but uploads the matrix through @p stream_buffer.
+    void setProjectionMatrix(const glm::mat4 &matrix, StreamBuffer &stream_buffer);
+
+    /// Get the view transform last set with setViewMatrix().
+    [[nodiscard]] const glm::mat4 &getViewMatrix() const
+    { return m_view_matrix; }
+
+    /// Get the projection transform last set with setProjectionMatrix().
+    [[nodiscard]] const glm::mat4 &getProjectionMatrix() const
+    { return m_projection_matrix; }
 
 private:
     void bindUniformBlock() const;
 
     GL::Buffer m_buffer;
+    TrackedMemory m_memory;
+    glm::mat4 m_view_matrix{1.0f};         ///< host copy of the view matrix, used for draw sorting and culling.
+    glm::mat4 m_projection_matrix{1.0f};   ///< host copy of the projection matrix, used for culling.
 };
 
 } // Simple::Renderer
@@ -0,0 +1,103 @@
+#ifndef SIMPLERENDERER_COMMAND_SEQUENCE_HPP
+#define SIMPLERENDERER_COMMAND_SEQUENCE_HPP
+
+#include "simple_renderer/draw_command.hpp"
+#include "simple_renderer/radix_sort.hpp"
+
+#include "glutils/program.hpp"
+#include "glutils/buffer.hpp"
+#include "glutils/vertex_array.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/// Index of @p Command in RendererCommandSet, stored alongside each command in a CommandSequence.
+template<typename Command>
+constexpr auto command_type_tag = static_cast<std::uint8_t>(RendererCommandSet::type_index<Command>);
+
+static_assert(RendererCommandSet::type_count <= 256, "command type tags are 8 bits wide");
+
+/**
+ * @brief A list of draw commands together with the state they require, executed in the order given by draw keys.
+ * Commands are referenced, not copied: they must stay valid and unmodified until the sequence is cleared.
+ */
+class CommandSequence
+{
+public:
+    struct Entry
+    {
+        GL::ProgramHandle program;
+        GL::VertexArrayHandle vertex_array;
+        std::uint32_t uniform_index;    ///< index of the model matrix in the bound model matrix block.
+        std::uint8_t command_type;      ///< index of the command type in RendererCommandSet, giving that of *command.
+        const DrawCommand *command;
+    };
+
+    CommandSequence() = default;
+
+    CommandSequence(const CommandSequence &) = delete;
+    CommandSequence &operator=(const CommandSequence &) = delete;
+
+    ~CommandSequence();
+
+    /// Append a command to be executed in the position determined by @p key; equal keys keep insertion order.
+    void push(std::uint64_t key, const Entry &entry);
+
+    /// Remove all commands.
+    void clear();
+
+    /// Order commands by key. Must be called after pushing commands and before executing them.
+    void sort();
+
+    /**
+     * @brief Group runs of sorted commands which may be submitted with a single multi draw indirect call, and upload
+     * their records. Does nothing if batches are already built; they are discarded by clear() and sort().
+     */
+    void buildIndirectBatches();
+
+    /**
+     * @brief Issue the draw calls, binding programs and vertex arrays as needed.
+     * The model matrices referenced by the commands must be bound to the model matrix block.
+     * @param use_indirect_batches Submit batches built by buildIndirectBatches() with multi draw indirect calls.
+     */
+    void execute(bool use_indirect_batches) const;
+
+    [[nodiscard]] bool empty() const
+    { return m_entries.empty(); }
+
+    [[nodiscard]] std::size_t size() const
+    { return m_entries.size(); }
+
+private:
+    /// holds commands in the order they were pushed; referenced by the payload of each sort item.
+    std::vector<Entry> m_entries;
+
+    /// draw keys, sorted to obtain the order in which commands will be executed.
+    std::vector<SortItem> m_sort_items;
+    std::vector<SortItem> m_sort_scratch;
+
+    /// A run of sorted commands submitted with a single multi draw indirect call.
+    struct IndirectBatch
+    {
+        std::size_t first_item;     ///< index of the first command's sort item.
+        std::size_t item_count;
+        std::size_t first_record;   ///< index of the first record in either m_elements_records or m_arrays_records.
+        bool indexed;
+    };
+
+    bool m_indirect_batches_built{false};
+    std::vector<IndirectBatch> m_indirect_batches;
+    std::vector<DrawElementsIndirectRecord> m_elements_records;
+    std::vector<DrawArraysIndirectRecord> m_arrays_records;
+    GL::Buffer m_indirect_buffer;
+
+    void m_clearIndirectBatches();
+
+    void m_executeIndirectBatch(const IndirectBatch &batch) const;
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_COMMAND_SEQUENCE_HPP
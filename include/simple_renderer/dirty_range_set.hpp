@@ -0,0 +1,52 @@
+#ifndef SIMPLERENDERER_DIRTY_RANGE_SET_HPP
+#define SIMPLERENDERER_DIRTY_RANGE_SET_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief A set of modified byte ranges, e.g. of a host copy of buffer data which must be uploaded.
+ * Ranges are kept sorted; overlapping or adjacent ranges are merged as they are added.
+ */
+class DirtyRangeSet
+{
+public:
+    /// Half-open range [begin, end).
+    struct Range
+    {
+        std::size_t begin{0};
+        std::size_t end{0};
+
+        [[nodiscard]] std::size_t size() const noexcept
+        { return end - begin; }
+    };
+
+    /// Mark [@p begin, @p end) as dirty; empty ranges are ignored.
+    void add(std::size_t begin, std::size_t end);
+
+    /// Merge ranges separated by at most @p gap bytes, so that fewer, larger writes upload them. Clean bytes between
+    /// merged ranges become dirty.
+    void coalesce(std::size_t gap);
+
+    /// The dirty ranges, sorted and disjoint.
+    [[nodiscard]] const std::vector<Range> &getRanges() const noexcept
+    { return m_ranges; }
+
+    /// Total number of dirty bytes.
+    [[nodiscard]] std::size_t getSize() const noexcept;
+
+    [[nodiscard]] bool empty() const noexcept
+    { return m_ranges.empty(); }
+
+    void clear() noexcept
+    { m_ranges.clear(); }
+
+private:
+    std::vector<Range> m_ranges;
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_DIRTY_RANGE_SET_HPP
@@ -32,6 +32,20 @@ enum class IndexType
     unsigned_int = 0x1405
 };
 
+/// Size in bytes of each index type.
+constexpr std::uint32_t getIndexTypeSize(IndexType type)
+{
+    switch (type)
+    {
+        case IndexType::unsigned_byte:
+            return 1;
+        case IndexType::unsigned_short:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
 /// base class for drawing commands
 struct DrawCommand
 {
@@ -57,6 +71,9 @@ struct DrawArraysCommand : DrawCommand
 
     void operator()() const override;
 
+    /// Invoke as a single instance draw starting at instance @p base_instance.
+    void operator()(std::uint32_t base_instance) const;
+
     std::uint32_t first{0};
     std::uint32_t count{0};
 };
@@ -73,11 +90,37 @@ struct DrawElementsCommand : DrawCommand
 
     void operator()() const override;
 
+    /// Invoke as a single instance draw starting at instance @p base_instance.
+    void operator()(std::uint32_t base_instance) const;
+
     std::uint32_t count{0};
     IndexType type{IndexType::unsigned_int};
     std::uintptr_t offset{0};
 };
 
+/// glDrawElementsBaseVertex: each index has @p base_vertex added to it, so that geometry sharing a vertex buffer can
+/// keep indices relative to its own first vertex.
+struct DrawElementsBaseVertexCommand : DrawElementsCommand
+{
+    DrawElementsBaseVertexCommand() = default;
+
+    DrawElementsBaseVertexCommand(DrawMode draw_mode, std::uint32_t index_count, IndexType index_type,
+                                  std::uintptr_t index_buffer_offset, std::int32_t base_vertex)
+            : DrawElementsCommand(draw_mode, index_count, index_type, index_buffer_offset), base_vertex(base_vertex)
+    {}
+
+    DrawElementsBaseVertexCommand(const DrawElementsCommand &draw_elements, std::int32_t base_vertex)
+            : DrawElementsCommand(draw_elements), base_vertex(base_vertex)
+    {}
+
+    void operator()() const override;
+
+    /// Invoke as a single instance draw starting at instance @p base_instance.
+    void operator()(std::uint32_t base_instance) const;
+
+    std::int32_t base_vertex{0};
+};
+
 /// Base class for instanced drawing commands. Exists mostly as a "tag" class.
 struct InstancedDrawCommand
 {
@@ -123,7 +166,27 @@ struct DrawElementsInstancedCommand : DrawElementsCommand, InstancedDrawCommand
     void operator()() const override;
 };
 
-using RendererCommandSet = TypeSet<DrawArraysCommand, DrawElementsCommand, DrawArraysInstancedCommand, DrawElementsInstancedCommand>;
+/// Layout of the records read by glMultiDrawArraysIndirect.
+struct DrawArraysIndirectRecord
+{
+    std::uint32_t count{0};
+    std::uint32_t instance_count{0};
+    std::uint32_t first{0};
+    std::uint32_t base_instance{0};
+};
+
+/// Layout of the records read by glMultiDrawElementsIndirect.
+struct DrawElementsIndirectRecord
+{
+    std::uint32_t count{0};
+    std::uint32_t instance_count{0};
+    std::uint32_t first_index{0};
+    std::int32_t base_vertex{0};
+    std::uint32_t base_instance{0};
+};
+
+using RendererCommandSet = TypeSet<DrawArraysCommand, DrawElementsCommand, DrawArraysInstancedCommand, DrawElementsInstancedCommand,
+                                   DrawElementsBaseVertexCommand>;
 
 } // simple
 
@@ -3,10 +3,16 @@
 
 #include "draw_command.hpp"
 #include "command_collector.hpp"
+#include "bounding_box.hpp"
+#include "upload_queue.hpp"
 
 #include "glutils/program.hpp"
 #include "glutils/vertex_array.hpp"
 
+#include "glm/mat4x4.hpp"
+
+#include <optional>
+
 namespace Simple::Renderer {
 
 /// Base class for all objects which may be drawn by the renderer.
@@ -15,9 +21,53 @@ class Drawable
     friend class RenderQueue;
 public:
     using CommandCollector = RendererCommandSet::Instantiate<CommandCollector>;
+
+    /// Model space bounds of the drawn primitives, used for culling. Drawables without bounds are never culled. When
+    /// the drawable has a vertex transform, these are the bounds of the transformed vertices.
+    [[nodiscard]] const std::optional<AxisAlignedBox> &getBounds() const
+    { return m_bounds; }
+
+    void setBounds(const std::optional<AxisAlignedBox> &bounds)
+    { m_bounds = bounds; }
+
+    /// Transformation from the vertex positions found in the drawable's buffers to model space, if any.
+    [[nodiscard]] const std::optional<glm::mat4> &getVertexTransform() const
+    { return m_vertex_transform; }
+
+    /**
+     * @brief Set a transformation applied to vertex positions before the model transform, e.g. to dequantize
+     * compressed positions. Render queues and render lists fold it into the model_matrix of every draw of the
+     * drawable, so shaders need not know about it.
+     */
+    void setVertexTransform(const std::optional<glm::mat4> &vertex_transform)
+    { m_vertex_transform = vertex_transform; }
+
+    /// The model_matrix seen by shaders when the drawable is drawn with @p model_transform.
+    [[nodiscard]] glm::mat4 getModelMatrix(const glm::mat4 &model_transform) const
+    { return m_vertex_transform ? model_transform * *m_vertex_transform : model_transform; }
+
+    /// Mark the drawable as not ready until @p ticket of @p upload_queue completes, e.g. because its geometry is still
+    /// being uploaded; render queues skip it until then. @p upload_queue must outlive the upload.
+    void setPendingUpload(const UploadQueue &upload_queue, UploadQueue::Ticket ticket)
+    {
+        m_upload_queue = &upload_queue;
+        m_upload_ticket = ticket;
+    }
+
+    /// Is the upload set with setPendingUpload() still in progress?
+    [[nodiscard]] bool isUploading() const
+    { return m_upload_queue && !m_upload_queue->isComplete(m_upload_ticket); }
+
 protected:
     /// Issue the OpenGL commands required to draw the primitives for this object.
     virtual void collectDrawCommands(const CommandCollector& collector) const = 0;
+
+private:
+    std::optional<AxisAlignedBox> m_bounds;
+    std::optional<glm::mat4> m_vertex_transform;
+
+    const UploadQueue *m_upload_queue{nullptr};
+    UploadQueue::Ticket m_upload_ticket{};
 };
 
 } // simple
@@ -0,0 +1,189 @@
+#ifndef SIMPLERENDERER_DYNAMIC_VERTEX_BUFFER_HPP
+#define SIMPLERENDERER_DYNAMIC_VERTEX_BUFFER_HPP
+
+#include "simple_renderer/buffer.hpp"
+#include "simple_renderer/vertex_array.hpp"
+#include "simple_renderer/vertex_buffer.hpp"
+
+#include "glutils/buffer.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief A GPU buffer whose contents may be appended, updated and erased, with storage that grows as needed.
+ * When the contents outgrow the storage, a new buffer with at least twice the capacity is allocated and the contents
+ * are copied by the GPU. Vertex arrays that source data from the buffer through bindVertexBuffer() or
+ * bindElementBuffer() are rebound to the new storage automatically.
+ *
+ * Sizes and offsets are in bytes; see DynamicVertexBuffer for a typed interface.
+ */
+class DynamicBuffer
+{
+public:
+    using size_t = std::size_t;
+
+    /// An empty buffer; storage is allocated by the first call to reserve() or append(). @p category is what the
+    /// buffer is used for, for memory accounting.
+    explicit DynamicBuffer(MemoryCategory category = MemoryCategory::vertex) : m_memory(category, 0)
+    {}
+
+    DynamicBuffer(const DynamicBuffer &) = delete;
+    DynamicBuffer &operator=(const DynamicBuffer &) = delete;
+
+    DynamicBuffer(DynamicBuffer &&) noexcept = default;
+
+    ~DynamicBuffer();
+
+    /// Size of the contents, in bytes.
+    [[nodiscard]] size_t getSize() const noexcept
+    { return m_size; }
+
+    /// Size of the storage, in bytes.
+    [[nodiscard]] size_t getCapacity() const noexcept
+    { return m_capacity; }
+
+    /// The current storage; it changes when the buffer grows.
+    [[nodiscard]] GL::BufferHandle getGLHandle() const noexcept
+    { return m_buffer; }
+
+    /// Ensure the storage can hold at least @p capacity bytes, reallocating it if necessary.
+    void reserve(size_t capacity);
+
+    /// Add @p size bytes at the end of the contents, written in place by @p initializer.
+    /// @return the offset of the new bytes.
+    size_t append(size_t size, const Buffer::Initializer &initializer);
+
+    /// Overwrite @p size bytes starting at @p offset, in place, with @p initializer.
+    void update(size_t offset, size_t size, const Buffer::Initializer &initializer);
+
+    /// Remove @p size bytes starting at @p offset; the bytes after them are moved down by the GPU.
+    void erase(size_t offset, size_t size);
+
+    /// Remove all contents, keeping the storage.
+    void clear() noexcept
+    { m_size = 0; }
+
+    /**
+     * @brief Bind the buffer to binding index @p index of @p vertex_array, and keep it bound when the storage is
+     * reallocated. The vertex array must be passed to unbindVertexArray() before it is destroyed.
+     */
+    void bindVertexBuffer(const VertexArray &vertex_array, BufferIndex index, GLsizei stride);
+
+    /// Same as bindVertexBuffer(), but binds the buffer as the element buffer of @p vertex_array.
+    void bindElementBuffer(const VertexArray &vertex_array);
+
+    /// Stop keeping @p vertex_array bound to the buffer; its current bindings are left untouched.
+    void unbindVertexArray(const VertexArray &vertex_array);
+
+private:
+    /// A binding point that sources data from the buffer; element buffers have no binding index.
+    struct Binding
+    {
+        GLuint vertex_array;
+        GLuint index;
+        GLsizei stride;
+        bool element_buffer;
+    };
+
+    GL::Buffer m_buffer{GL::BufferHandle()};
+    size_t m_size{0};
+    size_t m_capacity{0};
+    TrackedMemory m_memory;
+    std::vector<Binding> m_bindings;
+
+    /// Map @p size bytes at @p offset write-only and pass them to @p initializer.
+    void m_write(size_t offset, size_t size, const Buffer::Initializer &initializer) const;
+
+    void m_bind(const Binding &binding) const;
+};
+
+/// Typed interface for DynamicBuffer: an array of elements of type @p T which may grow, shrink and change.
+template<typename T>
+class DynamicVertexBuffer final
+{
+public:
+    static_assert(is_gpu_compatible<T>);
+    static_assert(!std::is_const_v<T>, "unexpected const qualifier");
+
+    using size_t = std::size_t;
+    using VertexType = T;
+    using BufferRangeType = BufferRange<T>;
+    using RangeType = typename BufferRangeType::Range;
+    using OffsetType = typename RangeType::Offset;
+    static constexpr size_t stride = sizeof(T);
+
+    DynamicVertexBuffer() = default;
+
+    /// An empty buffer, accounted as @p category memory; e.g. MemoryCategory::index for element buffers.
+    explicit DynamicVertexBuffer(MemoryCategory category) : m_buffer(category)
+    {}
+
+    explicit DynamicVertexBuffer(VertexDataInitializer<T> initializer)
+    { append(initializer); }
+
+    /// Number of elements in the buffer.
+    [[nodiscard]] size_t size() const noexcept
+    { return m_buffer.getSize() / stride; }
+
+    /// Number of elements the current storage can hold.
+    [[nodiscard]] size_t capacity() const noexcept
+    { return m_buffer.getCapacity() / stride; }
+
+    [[nodiscard]] bool empty() const noexcept
+    { return size() == 0; }
+
+    /// Ensure the buffer can hold @p element_count elements without reallocating its storage.
+    void reserve(size_t element_count)
+    { m_buffer.reserve(element_count * stride); }
+
+    /// Add elements at the end of the buffer; returns the index of the first one.
+    size_t append(const VertexDataInitializer<T> &initializer)
+    {
+        return m_buffer.append(initializer.size() * stride, [&initializer](std::byte *data)
+        { initializer(reinterpret_cast<T *>(data)); }) / stride;
+    }
+
+    /// Overwrite the elements starting at index @p first with the contents of @p initializer.
+    void update(size_t first, const VertexDataInitializer<T> &initializer)
+    {
+        m_buffer.update(first * stride, initializer.size() * stride, [&initializer](std::byte *data)
+        { initializer(reinterpret_cast<T *>(data)); });
+    }
+
+    /// Remove @p count elements starting at index @p first; later elements are moved down to fill the gap.
+    void erase(size_t first, size_t count)
+    { m_buffer.erase(first * stride, count * stride); }
+
+    void clear() noexcept
+    { m_buffer.clear(); }
+
+    /// Range of the current contents; invalidated by any change of size or storage.
+    [[nodiscard]] BufferRangeType getBufferRange() const noexcept
+    { return {m_buffer.getGLHandle(), {OffsetType(0), size()}}; }
+
+    /// Bind as the source of binding index @p index of @p vertex_array, and rebind whenever the storage changes.
+    void bindTo(const VertexArray &vertex_array, BufferIndex index)
+    { m_buffer.bindVertexBuffer(vertex_array, index, static_cast<GLsizei>(stride)); }
+
+    /// Bind as the element buffer of @p vertex_array, and rebind whenever the storage changes.
+    void bindAsElementBuffer(const VertexArray &vertex_array)
+    { m_buffer.bindElementBuffer(vertex_array); }
+
+    /// Must be called before a vertex array bound with bindTo() or bindAsElementBuffer() is destroyed.
+    void unbind(const VertexArray &vertex_array)
+    { m_buffer.unbindVertexArray(vertex_array); }
+
+    /// Direct access to the byte level buffer.
+    [[nodiscard]] const DynamicBuffer &getBuffer() const noexcept
+    { return m_buffer; }
+
+private:
+    DynamicBuffer m_buffer;
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_DYNAMIC_VERTEX_BUFFER_HPP
@@ -0,0 +1,230 @@
+#ifndef SIMPLERENDERER_FRAME_CAPTURE_HPP
+#define SIMPLERENDERER_FRAME_CAPTURE_HPP
+
+#include "simple_renderer/draw_command.hpp"
+#include "simple_renderer/drawable.hpp"
+#include "simple_renderer/camera.hpp"
+
+#include "glutils/gl.hpp"
+#include "glutils/buffer.hpp"
+#include "glutils/program.hpp"
+#include "glutils/vertex_array.hpp"
+
+#include "glm/mat4x4.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace Simple::Renderer {
+
+class RenderQueue;
+
+/**
+ * @brief The draws executed by a frame, with everything needed to submit them again: model matrices, camera, and the
+ * contents of the referenced buffers, vertex arrays and programs.
+ * Programs are stored as program binaries, so a capture may only be replayed by the OpenGL implementation that
+ * recorded it; ShaderProgram links with GL_PROGRAM_BINARY_RETRIEVABLE_HINT so that the binary can be read back.
+ * Textures and state set outside of RenderQueue are not captured.
+ */
+struct FrameCapture
+{
+    struct Buffer
+    {
+        std::vector<std::byte> data;
+    };
+
+    struct VertexAttribute
+    {
+        std::uint32_t index;
+        std::uint32_t binding;
+        std::uint32_t relative_offset;
+        std::int32_t size;
+        std::uint32_t type;
+        std::uint8_t normalized;
+        std::uint8_t integer;   ///< set with glVertexArrayAttribIFormat.
+        std::uint8_t long_;     ///< set with glVertexArrayAttribLFormat.
+    };
+
+    struct VertexBufferBinding
+    {
+        std::uint32_t index;
+        std::uint32_t buffer;   ///< index in FrameCapture::buffers.
+        std::uint64_t offset;
+        std::uint32_t stride;
+        std::uint32_t divisor;
+    };
+
+    static constexpr std::uint32_t no_buffer = -1u;
+
+    struct VertexArray
+    {
+        std::vector<VertexAttribute> attributes;
+        std::vector<VertexBufferBinding> bindings;
+        std::uint32_t element_buffer{no_buffer};  ///< index in FrameCapture::buffers.
+    };
+
+    /// Value of a default block uniform; array elements are captured as separate uniforms.
+    struct Uniform
+    {
+        std::int32_t location;
+        std::uint32_t type;
+        std::vector<std::uint32_t> components;  ///< raw 32 bit float, int or uint components.
+    };
+
+    struct Program
+    {
+        std::uint32_t binary_format;
+        std::vector<std::byte> binary;
+        std::vector<Uniform> uniforms;
+    };
+
+    struct Draw
+    {
+        glm::mat4 model_matrix;
+        std::uint32_t program;  ///< index in FrameCapture::programs.
+        std::uint8_t layer;
+    };
+
+    /// A draw command of any type in RendererCommandSet; fields not used by the type are zero.
+    struct Command
+    {
+        std::uint32_t draw;             ///< index in FrameCapture::draws.
+        std::uint32_t vertex_array;     ///< index in FrameCapture::vertex_arrays.
+        std::uint8_t command_type;      ///< index of the command type in RendererCommandSet.
+        std::uint32_t mode;
+        std::uint32_t first;
+        std::uint32_t count;
+        std::uint32_t index_type;
+        std::uint64_t offset;
+        std::uint32_t instance_count;
+        std::int32_t base_vertex;
+    };
+
+    glm::mat4 view_matrix{1.0f};
+    glm::mat4 projection_matrix{1.0f};
+
+    std::vector<Buffer> buffers;
+    std::vector<VertexArray> vertex_arrays;
+    std::vector<Program> programs;
+    std::vector<Draw> draws;
+    std::vector<Command> commands;
+
+    /// Serialize to a compact binary format, in the byte order of the host.
+    void write(std::ostream &stream) const;
+
+    /// Deserialize a capture written by write(); throws std::runtime_error if the data is not a valid capture.
+    [[nodiscard]] static FrameCapture read(std::istream &stream);
+
+    void save(const std::string &filename) const;
+
+    [[nodiscard]] static FrameCapture load(const std::string &filename);
+};
+
+/// Fills a FrameCapture, reading back the contents of each GL object the first time it is referenced.
+class FrameCaptureWriter
+{
+public:
+    /// Clears @p capture; it must outlive the writer.
+    explicit FrameCaptureWriter(FrameCapture &capture);
+
+    void setCamera(const Camera &camera);
+
+    /// Add a draw and return its index, to be passed to addCommand().
+    std::uint32_t addDraw(GL::ProgramHandle program, const glm::mat4 &model_matrix, std::uint8_t layer);
+
+    template<typename Command>
+    void addCommand(std::uint32_t draw, const Command &command, GL::VertexArrayHandle vertex_array);
+
+private:
+    FrameCapture &m_capture;
+
+    /// map GL object names to their index in the capture.
+    std::unordered_map<GLuint, std::uint32_t> m_buffer_indices;
+    std::unordered_map<GLuint, std::uint32_t> m_vertex_array_indices;
+    std::unordered_map<GLuint, std::uint32_t> m_program_indices;
+
+    std::uint32_t m_captureBuffer(GLuint buffer);
+    std::uint32_t m_captureVertexArray(GLuint vertex_array);
+    std::uint32_t m_captureProgram(GLuint program);
+};
+
+template<typename Command>
+void FrameCaptureWriter::addCommand(std::uint32_t draw, const Command &command, GL::VertexArrayHandle vertex_array)
+{
+    FrameCapture::Command &captured = m_capture.commands.emplace_back();
+    captured = {};
+    captured.draw = draw;
+    captured.vertex_array = m_captureVertexArray(vertex_array.getName());
+    captured.command_type = static_cast<std::uint8_t>(RendererCommandSet::type_index<Command>);
+    captured.mode = static_cast<std::uint32_t>(command.mode);
+
+    if constexpr (std::is_base_of_v<DrawArraysCommand, Command>)
+    {
+        captured.first = command.first;
+        captured.count = command.count;
+    }
+
+    if constexpr (std::is_base_of_v<DrawElementsCommand, Command>)
+    {
+        captured.count = command.count;
+        captured.index_type = static_cast<std::uint32_t>(command.type);
+        captured.offset = command.offset;
+    }
+
+    if constexpr (std::is_base_of_v<InstancedDrawCommand, Command>)
+        captured.instance_count = command.instance_count;
+
+    if constexpr (std::is_base_of_v<DrawElementsBaseVertexCommand, Command>)
+        captured.base_vertex = command.base_vertex;
+}
+
+/**
+ * @brief Recreates the GL objects of a FrameCapture, and submits its draws to a RenderQueue.
+ * The draws go through the regular recording, sorting and submission of the render queue, so that a captured frame
+ * may be used to measure changes to them.
+ */
+class FrameReplay
+{
+public:
+    /// Throws std::runtime_error if a program binary is rejected by the OpenGL implementation.
+    explicit FrameReplay(const FrameCapture &capture);
+
+    FrameReplay(const FrameReplay &) = delete;
+    FrameReplay &operator=(const FrameReplay &) = delete;
+
+    /// Record the captured draws on @p render_queue; they are executed by its next call to finishFrame().
+    void draw(RenderQueue &render_queue) const;
+
+    /// A camera with the captured view and projection matrices.
+    [[nodiscard]] const Camera &getCamera() const
+    { return m_camera; }
+
+private:
+    class CapturedDrawable final : public Drawable
+    {
+    public:
+        std::vector<FrameCapture::Command> commands;
+        const std::vector<GL::VertexArray> *vertex_arrays{nullptr};
+
+    protected:
+        void collectDrawCommands(const CommandCollector &collector) const override;
+    };
+
+    std::vector<GL::Buffer> m_buffers;
+    std::vector<GL::VertexArray> m_vertex_arrays;
+    std::vector<GL::Program> m_programs;
+
+    std::vector<FrameCapture::Draw> m_draws;
+    std::vector<CapturedDrawable> m_drawables;  ///< indexed the same as m_draws.
+
+    Camera m_camera;
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_FRAME_CAPTURE_HPP
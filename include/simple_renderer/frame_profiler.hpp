@@ -0,0 +1,146 @@
+#ifndef SIMPLERENDERER_FRAME_PROFILER_HPP
+#define SIMPLERENDERER_FRAME_PROFILER_HPP
+
+#include "glutils/gl.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace Simple::Renderer {
+
+/// Parts of RenderQueue::finishFrame() timed on the CPU.
+enum class FramePhase : std::uint8_t
+{
+    cull,       ///< frustum culling of recorded draws.
+    build,      ///< collecting commands into command sequences, including rebuilding render lists.
+    sort,       ///< sorting the recorded draws by draw key.
+    upload,     ///< writing model matrices and indirect draw records.
+    submit,     ///< executing command sequences, including the state changes made between draw calls.
+    count
+};
+
+constexpr auto frame_phase_count = static_cast<std::size_t>(FramePhase::count);
+
+/// Timings of a frame, in milliseconds.
+struct FrameStats
+{
+    std::array<double, frame_phase_count> cpu_phase_ms{};
+
+    double cpu_ms{0.0};     ///< whole call to RenderQueue::finishFrame().
+    double gpu_ms{0.0};     ///< time taken by the GPU to execute the commands issued by finishFrame().
+
+    [[nodiscard]] double getPhase(FramePhase phase) const
+    { return cpu_phase_ms[static_cast<std::size_t>(phase)]; }
+};
+
+/**
+ * @brief Measures where a frame spends its time.
+ * CPU time is measured with scoped timers around each phase. GPU time is measured with GL_TIME_ELAPSED queries, whose
+ * results are read a few frames later, once available, so that reading them never waits for the GPU. If the GPU falls
+ * further behind than the number of queries, frames are left untimed on the GPU instead.
+ */
+class FrameProfiler
+{
+    using Clock = std::chrono::steady_clock;
+
+public:
+    /// Adds the time between its construction and destruction to a phase of the current frame.
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(FrameProfiler &profiler, FramePhase phase) :
+                m_profiler(profiler), m_phase(phase), m_start(profiler.m_enabled ? Clock::now() : Clock::time_point())
+        {}
+
+        ScopedTimer(const ScopedTimer &) = delete;
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+        ~ScopedTimer()
+        {
+            if (m_profiler.m_enabled)
+                m_profiler.m_addPhaseTime(m_phase, Clock::now() - m_start);
+        }
+
+    private:
+        FrameProfiler &m_profiler;
+        FramePhase m_phase;
+        Clock::time_point m_start;
+    };
+
+    /// Number of frames averaged by getAverageStats().
+    static constexpr std::size_t average_frame_count = 60;
+
+    FrameProfiler() = default;
+
+    FrameProfiler(const FrameProfiler &) = delete;
+    FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+    ~FrameProfiler();
+
+    /// Enable or disable profiling, which is disabled by default. Must not be called during a frame.
+    void setEnabled(bool enabled);
+
+    [[nodiscard]] bool isEnabled() const
+    { return m_enabled; }
+
+    void beginFrame();
+
+    void endFrame();
+
+    [[nodiscard]] ScopedTimer time(FramePhase phase)
+    { return {*this, phase}; }
+
+    /**
+     * @brief Timings of the last frame.
+     * gpu_ms belongs to the most recent frame whose query result was available, usually a few frames before the last.
+     */
+    [[nodiscard]] const FrameStats &getLastStats() const
+    { return m_last_stats; }
+
+    /// Timings averaged over the last average_frame_count frames, or less if fewer frames were timed.
+    [[nodiscard]] const FrameStats &getAverageStats() const
+    { return m_average_stats; }
+
+private:
+    bool m_enabled{false};
+
+    Clock::time_point m_frame_start;
+    FrameStats m_current_stats;
+    FrameStats m_last_stats;
+    FrameStats m_average_stats;
+
+    /// rolling sums over the ring of past timings; cpu and gpu timings are recorded at different times.
+    std::array<FrameStats, average_frame_count> m_cpu_history{};
+    std::array<double, average_frame_count> m_gpu_history{};
+    FrameStats m_history_sum;
+    std::size_t m_cpu_history_size{0};
+    std::size_t m_cpu_history_next{0};
+    std::size_t m_gpu_history_size{0};
+    std::size_t m_gpu_history_next{0};
+
+    /// Queries are issued in ring order, so that they complete in ring order too.
+    static constexpr std::size_t s_query_count = 4;
+
+    std::array<GLuint, s_query_count> m_queries{};
+    std::array<bool, s_query_count> m_query_pending{};
+    std::size_t m_next_query{0};    ///< the next query to issue; the oldest one if all are pending.
+    bool m_query_active{false};
+
+    void m_addPhaseTime(FramePhase phase, Clock::duration duration)
+    { m_current_stats.cpu_phase_ms[static_cast<std::size_t>(phase)] += s_toMilliseconds(duration); }
+
+    static double s_toMilliseconds(Clock::duration duration)
+    { return std::chrono::duration<double, std::milli>(duration).count(); }
+
+    /// Read the results of completed queries, oldest first, stopping at the first one still in flight.
+    void m_collectQueryResults();
+
+    void m_recordCpuStats(const FrameStats &stats);
+
+    void m_recordGpuTime(double gpu_ms);
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_FRAME_PROFILER_HPP
@@ -0,0 +1,69 @@
+#ifndef SIMPLERENDERER_FRUSTUM_CULLING_HPP
+#define SIMPLERENDERER_FRUSTUM_CULLING_HPP
+
+#include "simple_renderer/bounding_box.hpp"
+
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+#include "glm/mat4x4.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/// The six planes bounding the volume visible to a camera.
+struct Frustum
+{
+    /**
+     * Planes are stored as (a, b, c, d) so that a point p is on the inner side if a * p.x + b * p.y + c * p.z + d >= 0.
+     * Normals are not normalized.
+     */
+    std::array<glm::vec4, 6> planes;
+
+    /// Extract the planes of the frustum in the space transformed to clip space by @p matrix.
+    static Frustum fromMatrix(const glm::mat4 &matrix);
+};
+
+/**
+ * @brief Bounding boxes stored as a structure of arrays, so that several of them can be tested at once using SIMD.
+ * Each box is stored as its center and extents.
+ */
+class BoundingBoxArray
+{
+public:
+    /// Add the box which contains @p box transformed by @p transform.
+    void push_back(const AxisAlignedBox &box, const glm::mat4 &transform);
+
+    /// Add a box which is never culled.
+    void pushUnbounded();
+
+    void clear();
+
+    [[nodiscard]] std::size_t size() const
+    { return m_center_x.size(); }
+
+    /**
+     * @brief Test all boxes against a frustum.
+     * Uses AVX or SSE, depending on the instruction sets enabled at compile time, with a scalar fallback. The test is
+     * conservative: some boxes outside the frustum near its corners are reported as visible.
+     * @param frustum The frustum, in the same space as the boxes.
+     * @param visibility Resized to size(); each element is set to 1 if the box with the same index may be visible,
+     * or 0 if it is certainly outside the frustum.
+     * @return The number of visible boxes.
+     */
+    std::size_t cull(const Frustum &frustum, std::vector<std::uint8_t> &visibility) const;
+
+private:
+    std::vector<float> m_center_x;
+    std::vector<float> m_center_y;
+    std::vector<float> m_center_z;
+    std::vector<float> m_extent_x;
+    std::vector<float> m_extent_y;
+    std::vector<float> m_extent_z;
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_FRUSTUM_CULLING_HPP
@@ -0,0 +1,135 @@
+#ifndef SIMPLERENDERER_GEOMETRY_ARENA_HPP
+#define SIMPLERENDERER_GEOMETRY_ARENA_HPP
+
+#include "simple_renderer/allocation_registry.hpp"
+#include "simple_renderer/drawable.hpp"
+#include "simple_renderer/vertex_array.hpp"
+#include "simple_renderer/vertex_buffer.hpp"
+
+#include "glutils/buffer.hpp"
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief Sub-allocates the vertices and indices of many meshes from a few large buffers.
+ * Geometry with the same vertex format (positions, and optionally normals and uvs) shares pages, each with one buffer
+ * per attribute, an index buffer and a vertex array. Draws of geometry in the same page only differ in their index
+ * range and base vertex, so the render queue may submit them without rebinding vertex arrays, and merge them into
+ * multi draw indirect calls.
+ */
+class GeometryArena
+{
+public:
+    /// A range of vertices, and possibly indices, in one of the pages of an arena.
+    struct Allocation
+    {
+        std::uint32_t page{0};
+        std::uint32_t first_vertex{0};
+        std::uint32_t vertex_count{0};
+        std::uint32_t first_index{0};
+        std::uint32_t index_count{0};   ///< zero for non-indexed geometry.
+    };
+
+    /**
+     * @param page_vertex_count number of vertices in each page.
+     * @param page_index_count number of indices in each page; their storage is only allocated once the page holds
+     * indexed geometry.
+     * Geometry that doesn't fit in a page of this size gets a page of its own.
+     */
+    explicit GeometryArena(std::uint32_t page_vertex_count = 1 << 20, std::uint32_t page_index_count = 1 << 22);
+
+    GeometryArena(const GeometryArena &) = delete;
+    GeometryArena &operator=(const GeometryArena &) = delete;
+
+    /// Copy vertex data into the arena. @p normals and @p uvs may be empty, otherwise they must have the same size as
+    /// @p positions; @p indices may be empty for non-indexed geometry.
+    [[nodiscard]] Allocation allocate(VertexDataInitializer<glm::vec3> positions,
+                                      VertexDataInitializer<glm::vec3> normals,
+                                      VertexDataInitializer<glm::vec2> uvs,
+                                      VertexDataInitializer<unsigned int> indices = {});
+
+    /// Release the ranges of an allocation made by this arena.
+    void deallocate(const Allocation &allocation);
+
+    /// The vertex array that sources vertices from the page of @p allocation.
+    [[nodiscard]] GL::VertexArrayHandle getVertexArray(const Allocation &allocation) const
+    { return m_pages.at(allocation.page).vertex_array.getGLObject(); }
+
+    [[nodiscard]] std::size_t getPageCount() const noexcept
+    { return m_pages.size(); }
+
+private:
+    /// Bits for the optional attributes of a page's vertex format.
+    enum FormatBits : std::uint8_t
+    {
+        has_normals = 1,
+        has_uvs = 2
+    };
+
+    struct Page
+    {
+        Page(std::uint8_t format, std::uint32_t vertex_count, std::uint32_t index_count);
+
+        /// Allocate the index buffer, unless already done; pages of non-indexed geometry never need it.
+        void allocateIndexStorage();
+
+        std::uint8_t format;
+        std::uint32_t index_capacity;
+
+        GL::Buffer positions;
+        GL::Buffer normals;
+        GL::Buffer uvs;
+        GL::Buffer indices;
+        VertexArray vertex_array;
+
+        TrackedMemory vertex_memory;
+        TrackedMemory index_memory;     ///< zero until allocateIndexStorage().
+
+        /// ranges of vertices and indices in use, in elements rather than bytes.
+        AllocationRegistry vertex_registry;
+        AllocationRegistry index_registry;
+    };
+
+    std::uint32_t m_page_vertex_count;
+    std::uint32_t m_page_index_count;
+    std::vector<Page> m_pages;
+
+    /// Find a page with the given format and enough free space, or create one.
+    std::uint32_t m_getPage(std::uint8_t format, std::uint32_t vertex_count, std::uint32_t index_count);
+};
+
+/// A mesh whose geometry is stored in a GeometryArena; indexed meshes are drawn with DrawElementsBaseVertexCommand.
+class ArenaMesh : public Drawable
+{
+public:
+    /// Copies the vertex data into @p arena, which must outlive the mesh.
+    ArenaMesh(GeometryArena &arena, VertexDataInitializer<glm::vec3> positions,
+              VertexDataInitializer<glm::vec3> normals, VertexDataInitializer<glm::vec2> uvs,
+              VertexDataInitializer<unsigned int> indices = {});
+
+    ArenaMesh(const ArenaMesh &) = delete;
+    ArenaMesh &operator=(const ArenaMesh &) = delete;
+
+    ~ArenaMesh();
+
+    void collectDrawCommands(const CommandCollector &collector) const override;
+
+    [[nodiscard]] bool isIndexed() const
+    { return m_allocation.index_count > 0; }
+
+    DrawMode draw_mode = DrawMode::triangles;
+
+private:
+    GeometryArena &m_arena;
+    GeometryArena::Allocation m_allocation;
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_GEOMETRY_ARENA_HPP
@@ -8,14 +8,33 @@ namespace Simple {
 
     constexpr auto glsl_version_c_str = "#version 430 core\n";
 
+    // Extensions; these must precede any other declaration. They are optional: shaders check for them with #ifdef.
+    constexpr auto glsl_vertex_extensions_c_str = "#extension GL_ARB_shader_draw_parameters : enable\n";
+
     // Vertex attribute declarations
     extern const GL::Definition vertex_position_def;
     extern const GL::Definition vertex_normal_def;
     extern const GL::Definition vertex_uv_def;
 
+    /// Defines vec3 decode_octahedral_normal(vec2), which decodes normals stored with
+    /// NormalEncoding::octahedral_snorm16, e.g. decode_octahedral_normal(vertex_normal.xy).
+    extern const char *const octahedral_normal_glsl_c_str;
+
     // Uniform declarations
 
-    extern const GL::Definition model_matrix_def;
+    /**
+     * @brief Model matrices are stored in a shader storage block. Each draw reads the matrix at index
+     * model_matrix_index + gl_BaseInstanceARB, or model_matrix_index alone without GL_ARB_shader_draw_parameters.
+     * The vertex stage passes the index on to the fragment stage in a flat varying; for that, the user's main() is
+     * renamed by model_matrix_glsl_c_str and called by the main() of model_matrix_vertex_main_glsl_c_str, which
+     * must follow the user's code.
+     */
+    extern const char *const model_matrix_glsl_c_str;
+    extern const char *const model_matrix_vertex_main_glsl_c_str;
+    extern const char *const model_matrix_fragment_glsl_c_str;
+    extern const GLint model_matrix_index_location;
+    extern const GLuint model_matrix_block_binding;
+
     extern const GL::BlockDefinition camera_uniform_block_def;
     extern const std::size_t view_matrix_block_index;
     extern const std::size_t proj_matrix_block_index;
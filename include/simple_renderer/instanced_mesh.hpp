@@ -2,15 +2,23 @@
 #define PROCEDURALPLACEMENTLIB_INSTANCED_MESH_HPP
 
 #include "mesh.hpp"
+#include "stream_buffer.hpp"
 
 #include <vector>
 #include <map>
+#include <memory>
 
 namespace Simple {
 
 namespace Renderer
 {
 
+/**
+ * @brief A mesh drawn once per instance, with an extra vertex attribute which advances per instance.
+ * The mesh must not have a vertex transform (e.g. from PositionEncoding::snorm16): it is folded into model_matrix,
+ * which would also apply to model space instance attributes such as position offsets. Constructors throw
+ * std::logic_error for such meshes.
+ */
 template<typename AttribType>
 class InstancedMesh : public Mesh
 {
@@ -26,11 +34,69 @@ public:
     {
         if (instance_divisor == 0)
             throw std::logic_error("instance_divisor is zero");
+        if (getVertexTransform())
+            throw std::logic_error("instanced mesh has a vertex transform");
 
-        constexpr BufferIndex buffer_index = BufferIndex(3); // indices 0 to 2 are occupied by positions, normals and uvs
-        m_vertex_array.bindVertexBufferAttribute<AttribType>(buffer_index, m_instance_buffer.getBufferRange(), attrib_index,
+        m_vertex_array.bindVertexBufferAttribute<AttribType>(s_instance_buffer_index,
+                                                             m_instance_buffer.getBufferRange(), attrib_index,
                                                              extra_args...);
-        m_vertex_array.setVertexBufferInstanceDivisor(buffer_index, instance_divisor);
+        m_vertex_array.setVertexBufferInstanceDivisor(s_instance_buffer_index, instance_divisor);
+
+        // instance attributes may place copies of the mesh anywhere, so the bounds of a single copy don't apply
+        setBounds(std::nullopt);
+    }
+
+    /**
+     * @brief Create a mesh in dynamic instance mode, whose instance data is replaced each frame by setInstanceData().
+     * Instance data is written into one of @p region_count regions of a stream buffer, each big enough for
+     * @p max_value_count instance attribute values, and the instance buffer binding is switched to it. A region is
+     * only rewritten once the GPU is done drawing from it, so updates neither reallocate storage nor stall on draws in
+     * flight.
+     * Nothing is drawn until the first call to setInstanceData().
+     */
+    template<typename ... ExtraArgs>
+    InstancedMesh(Mesh&& mesh, AttribIndex attrib_index, std::size_t max_value_count, std::uint32_t instance_divisor,
+                  std::size_t region_count, ExtraArgs ... extra_args) :
+            Mesh(std::move(mesh)),
+            m_instance_stream(std::make_unique<StreamBuffer>(max_value_count * sizeof(AttribType), region_count,
+                                                             MemoryCategory::instance)),
+            m_instance_divisor(instance_divisor)
+    {
+        if (instance_divisor == 0)
+            throw std::logic_error("instance_divisor is zero");
+        if (getVertexTransform())
+            throw std::logic_error("instanced mesh has a vertex transform");
+
+        m_vertex_array.bindVertexBufferAttribute<AttribType>(s_instance_buffer_index, BufferRange<AttribType>(),
+                                                             attrib_index, extra_args...);
+        m_vertex_array.setVertexBufferInstanceDivisor(s_instance_buffer_index, instance_divisor);
+
+        setBounds(std::nullopt);
+    }
+
+    [[nodiscard]] bool isDynamic() const noexcept
+    { return m_instance_stream != nullptr; }
+
+    /**
+     * @brief Replace the instance data of a mesh in dynamic instance mode; meant to be called once per frame, before
+     * the mesh is drawn. The previous region is fenced, so it must not be called between the draws of a frame. Render
+     * lists which contain the mesh must be invalidated if the number of instances changes.
+     * @param instance_data The instance attribute values; at most the max_value_count given on construction.
+     */
+    void setInstanceData(const VertexDataInitializer<AttribType> &instance_data)
+    {
+        if (!m_instance_stream)
+            throw std::logic_error("instance data of a static instanced mesh can't be replaced");
+
+        // the previous call's region was drawn from since then; move on to a region the GPU is done with
+        m_instance_stream->finishFrame();
+
+        const auto allocation = m_instance_stream->allocate(instance_data.size() * sizeof(AttribType),
+                                                            alignof(AttribType));
+        instance_data(reinterpret_cast<AttribType *>(allocation.data));
+
+        m_vertex_array.bindVertexBuffer(s_instance_buffer_index, allocation.getBufferRange(), sizeof(AttribType));
+        m_instance_count = static_cast<std::uint32_t>(instance_data.size() / m_instance_divisor);
     }
 
     [[nodiscard]] std::uint32_t getInstanceCount() { return m_instance_count; }
@@ -39,6 +105,10 @@ public:
 protected:
     void collectDrawCommands(const CommandCollector &collector) const override
     {
+        // a dynamic mesh has no instance data bound before its first update
+        if (m_instance_count == 0)
+            return;
+
         if (isIndexed())
         {
             collector.emplace(DrawElementsInstancedCommand{m_createDrawElementsCommand(), m_instance_count * m_instance_divisor},
@@ -52,7 +122,11 @@ protected:
     }
 
 private:
+    /// indices 0 to 2 are occupied by positions, normals and uvs
+    static constexpr BufferIndex s_instance_buffer_index = BufferIndex(3);
+
     VertexBuffer<AttribType> m_instance_buffer;
+    std::unique_ptr<StreamBuffer> m_instance_stream;    ///< instance data regions, only in dynamic instance mode.
     std::uint32_t m_instance_count{0};
     std::uint32_t m_instance_divisor{0};
 };
@@ -153,6 +227,11 @@ public:
 
     [[nodiscard]] bool isHandleValid(InstanceDataHandle handle) const;
 
+    /// Merge the free space left in the instance buffer by removed or resized instance data, copying at most
+    /// @p byte_budget bytes; see VertexBuffer::compact().
+    /// @return true if the instance buffer is fully compacted.
+    bool compactInstanceBuffer(std::size_t byte_budget);
+
 private:
     struct DataDescriptor
     {
@@ -204,7 +283,7 @@ private:
 
     std::underlying_type_t<InstanceDataHandle> m_next_handle{0};
     std::uint32_t m_instance_count{0};
-    VertexBuffer m_instance_buffer{s_initial_buffer_size};
+    VertexBuffer m_instance_buffer{s_initial_buffer_size, Renderer::MemoryCategory::instance};
     std::map<InstanceDataHandle, DataDescriptor> m_descriptors;
 };
 
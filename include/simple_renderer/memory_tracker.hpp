@@ -0,0 +1,146 @@
+#ifndef SIMPLERENDERER_MEMORY_TRACKER_HPP
+#define SIMPLERENDERER_MEMORY_TRACKER_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace Simple::Renderer {
+
+/// What GPU memory is used for.
+enum class MemoryCategory : std::uint8_t
+{
+    vertex,
+    index,
+    instance,
+    uniform,
+    texture,
+    staging,
+};
+
+constexpr std::size_t memory_category_count = 6;
+
+/**
+ * @brief Process-wide accounting of the GPU memory allocated by the renderer, per category.
+ * Usage is recorded by the objects that own GPU storage, through TrackedMemory; it is the size requested from OpenGL,
+ * which may differ from what the driver actually allocates. Peak usage is tracked per category and in total. A soft
+ * budget may be set, with a callback which is called when total usage goes over it. All functions are thread safe.
+ */
+class MemoryTracker
+{
+public:
+    /// Called with the total usage after an allocation which took it over the budget.
+    using BudgetCallback = std::function<void(std::size_t total_usage, std::size_t budget)>;
+
+    /// The tracker shared by every renderer in the process.
+    static MemoryTracker &get();
+
+    MemoryTracker(const MemoryTracker &) = delete;
+    MemoryTracker &operator=(const MemoryTracker &) = delete;
+
+    void allocate(MemoryCategory category, std::size_t size);
+
+    void deallocate(MemoryCategory category, std::size_t size) noexcept;
+
+    /// Bytes currently allocated in @p category.
+    [[nodiscard]] std::size_t getUsage(MemoryCategory category) const noexcept
+    { return m_usage[static_cast<std::size_t>(category)].load(std::memory_order_relaxed); }
+
+    /// Highest usage of @p category since the tracker was created or resetPeakUsage() was called.
+    [[nodiscard]] std::size_t getPeakUsage(MemoryCategory category) const noexcept
+    { return m_peak_usage[static_cast<std::size_t>(category)].load(std::memory_order_relaxed); }
+
+    /// Bytes currently allocated in all categories.
+    [[nodiscard]] std::size_t getTotalUsage() const noexcept
+    { return m_total_usage.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] std::size_t getPeakTotalUsage() const noexcept
+    { return m_peak_total_usage.load(std::memory_order_relaxed); }
+
+    /// Set the peaks to the current usage.
+    void resetPeakUsage() noexcept;
+
+    /**
+     * @brief Set a soft limit on total usage; allocations aren't prevented, but @p callback is called by the
+     * allocation which takes total usage from within the budget to over it, on the allocating thread.
+     * @param budget The budget in bytes, or zero for no budget.
+     * @param callback Must not allocate or deallocate tracked memory.
+     */
+    void setBudget(std::size_t budget, BudgetCallback callback);
+
+    /// The budget in bytes, or zero if there is none.
+    [[nodiscard]] std::size_t getBudget() const noexcept
+    { return m_budget.load(std::memory_order_relaxed); }
+
+private:
+    MemoryTracker() = default;
+
+    std::array<std::atomic<std::size_t>, memory_category_count> m_usage{};
+    std::array<std::atomic<std::size_t>, memory_category_count> m_peak_usage{};
+    std::atomic<std::size_t> m_total_usage{0};
+    std::atomic<std::size_t> m_peak_total_usage{0};
+
+    std::atomic<std::size_t> m_budget{0};
+    BudgetCallback m_budget_callback;
+    std::mutex m_budget_mutex;  ///< guards m_budget_callback.
+};
+
+/// Records an amount of memory in the MemoryTracker for as long as it exists; owned by objects with GPU storage.
+class TrackedMemory
+{
+public:
+    /// Tracks no memory.
+    constexpr TrackedMemory() noexcept = default;
+
+    TrackedMemory(MemoryCategory category, std::size_t size) : m_category(category)
+    { resize(size); }
+
+    TrackedMemory(const TrackedMemory &) = delete;
+    TrackedMemory &operator=(const TrackedMemory &) = delete;
+
+    TrackedMemory(TrackedMemory &&other) noexcept
+            : m_category(other.m_category), m_size(std::exchange(other.m_size, 0))
+    {}
+
+    TrackedMemory &operator=(TrackedMemory &&other) noexcept
+    {
+        if (this != &other)
+        {
+            MemoryTracker::get().deallocate(m_category, m_size);
+            m_category = other.m_category;
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    ~TrackedMemory()
+    { MemoryTracker::get().deallocate(m_category, m_size); }
+
+    /// Change the amount of memory recorded, e.g. when storage is reallocated.
+    void resize(std::size_t size)
+    {
+        if (size > m_size)
+            MemoryTracker::get().allocate(m_category, size - m_size);
+        else
+            MemoryTracker::get().deallocate(m_category, m_size - size);
+        m_size = size;
+    }
+
+    [[nodiscard]] MemoryCategory getCategory() const noexcept
+    { return m_category; }
+
+    [[nodiscard]] std::size_t getSize() const noexcept
+    { return m_size; }
+
+private:
+    MemoryCategory m_category{MemoryCategory::vertex};
+    std::size_t m_size{0};
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_MEMORY_TRACKER_HPP
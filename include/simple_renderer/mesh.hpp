@@ -6,22 +6,102 @@
 #include "simple_renderer/vertex_array.hpp"
 #include "simple_renderer/vertex_attribute_specification.hpp"
 #include "simple_renderer/vertex_data_loader.hpp"
+#include "simple_renderer/vertex_encoding.hpp"
 
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
 
+#include <array>
+#include <cstdint>
 #include <functional>
+#include <type_traits>
+#include <variant>
 
 namespace Simple {
 
 namespace Renderer {
 
+/// How the vertex attributes of a Mesh are laid out in its buffer.
+enum class MeshLayout : std::uint8_t
+{
+    /// One array per attribute, each bound to its own buffer binding index.
+    planar,
+    /// A single array of InterleavedVertex, so that fetching a vertex reads one contiguous stride.
+    interleaved,
+};
+
+/// Vertex of a mesh with MeshLayout::interleaved and float32 encodings; attributes the mesh doesn't have are zero.
+struct InterleavedVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+static_assert(sizeof(InterleavedVertex) == 32);
+
+/// Indices of a Mesh, from an array of 8, 16 or 32-bit unsigned integers.
+class IndexDataInitializer final
+{
+public:
+    using size_t = std::size_t;
+
+    /// No indices; the mesh is drawn without them.
+    IndexDataInitializer() = default;
+
+    IndexDataInitializer(VertexDataInitializer<std::uint8_t> indices) // NOLINT(google-explicit-constructor)
+            : m_source(indices)
+    {}
+
+    IndexDataInitializer(VertexDataInitializer<std::uint16_t> indices) // NOLINT(google-explicit-constructor)
+            : m_source(indices)
+    {}
+
+    IndexDataInitializer(VertexDataInitializer<unsigned int> indices) // NOLINT(google-explicit-constructor)
+            : m_source(indices)
+    {}
+
+    /// Initialize from the contents of a contiguous container of 8, 16 or 32-bit unsigned integers.
+    template<typename Container, typename Index = std::remove_cv_t<std::remove_reference_t<
+            decltype(*std::data(std::declval<const Container &>()))>>,
+            std::enable_if_t<std::is_same_v<Index, std::uint8_t> || std::is_same_v<Index, std::uint16_t>
+                             || std::is_same_v<Index, unsigned int>, int> = 0>
+    IndexDataInitializer(const Container &container) // NOLINT(google-explicit-constructor)
+            : m_source(VertexDataInitializer<Index>(container))
+    {}
+
+    /// Number of indices.
+    [[nodiscard]] size_t size() const
+    { return std::visit([](const auto &source) { return source.size(); }, m_source); }
+
+    explicit operator bool() const
+    { return size() > 0; }
+
+    /// Write the indices into @p data, converted to @p type. Indices that don't fit in @p type are truncated.
+    void operator()(IndexType type, std::byte *data) const;
+
+private:
+    std::variant<VertexDataInitializer<unsigned int>, VertexDataInitializer<std::uint16_t>,
+                 VertexDataInitializer<std::uint8_t>> m_source;
+};
+
 /// Base class for renderer-able meshes.
 class Mesh : public Drawable
 {
 public:
+    /**
+     * @brief Create a mesh from its vertex attributes and, optionally, indices.
+     * @param indices Stored as 16-bit integers when there are at most 65536 vertices, as 32-bit integers otherwise,
+     * whatever their source type.
+     * @param layout How the attributes are laid out in the mesh's buffer.
+     * @param encoding How each attribute is stored. With PositionEncoding::snorm16 the mesh gets a vertex transform
+     * which restores the original positions (see Drawable::setVertexTransform()), so it can't be turned into an
+     * InstancedMesh; with NormalEncoding::octahedral_snorm16 shaders must decode vertex_normal with
+     * decode_octahedral_normal().
+     */
     Mesh(VertexDataInitializer <glm::vec3> positions, VertexDataInitializer <glm::vec3> normals,
-         VertexDataInitializer <glm::vec2> uvs, VertexDataInitializer<unsigned int> indices = {});
+         VertexDataInitializer <glm::vec2> uvs, IndexDataInitializer indices = {},
+         MeshLayout layout = MeshLayout::planar, VertexEncoding encoding = {});
 
     void collectDrawCommands(const CommandCollector &collector) const override;
 
@@ -29,20 +109,56 @@ public:
     [[nodiscard]] bool isIndexed() const
     { return m_use_index_buffer; }
 
+    [[nodiscard]] MeshLayout getLayout() const
+    { return m_layout; }
+
+    [[nodiscard]] const VertexEncoding &getEncoding() const
+    { return m_encoding; }
+
+    /// Type of the indices in the mesh's buffer; only meaningful for indexed meshes.
+    [[nodiscard]] IndexType getIndexType() const
+    { return m_index_type; }
+
     DrawMode draw_mode = DrawMode::triangles;
 
 protected:
     [[nodiscard]] DrawElementsCommand m_createDrawElementsCommand() const;
     [[nodiscard]] DrawArraysCommand m_createDrawArraysCommand() const;
 
-    template<typename AttributeType, std::size_t SectionIndex>
-    void m_bindAttribute(uint attrib_index);
-
     VertexArray m_vertex_array;
 
 private:
-    VertexBuffer<glm::vec3, glm::vec3, glm::vec2, unsigned int> m_vertex_buffer;
+    /// Where the encoded position, normal and uv of each vertex are found in the buffer.
+    struct PackedLayout
+    {
+        /// byte offset of each attribute: relative to the vertex if interleaved, to the buffer if planar.
+        std::array<std::size_t, 3> offsets;
+        /// byte distance between the attributes of consecutive vertices, 0 for missing planar attributes.
+        std::array<std::size_t, 3> strides;
+        /// size of all vertex data; the indices follow it.
+        std::size_t vertices_size;
+    };
+
+    [[nodiscard]] PackedLayout m_makePackedLayout(std::size_t vertex_count, bool has_normals, bool has_uvs) const;
+
+    /// Encode the vertices into @p data following @p layout, then write the indices after them.
+    void m_initializePacked(std::byte *data, const PackedLayout &layout, const PositionQuantization &quantization,
+                            const VertexDataInitializer<glm::vec3> &positions,
+                            const VertexDataInitializer<glm::vec3> &normals,
+                            const VertexDataInitializer<glm::vec2> &uvs,
+                            const IndexDataInitializer &indices) const;
+
+    void m_bindPackedAttributes(const PackedLayout &layout, std::size_t vertex_count);
+
+    /// holds the mesh data: vertices, then indices.
+    Buffer m_buffer;
+    /// the index part of m_buffer, which is otherwise recorded as vertex memory.
+    TrackedMemory m_index_memory;
 
+    MeshLayout m_layout;
+    VertexEncoding m_encoding;
+    IndexType m_index_type{IndexType::unsigned_int};
+    std::uintptr_t m_index_buffer_offset{0};
     bool m_use_index_buffer;
     std::uint32_t m_index_count;
     std::uint32_t m_first_index;
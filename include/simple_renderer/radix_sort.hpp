@@ -0,0 +1,28 @@
+#ifndef SIMPLERENDERER_RADIX_SORT_HPP
+#define SIMPLERENDERER_RADIX_SORT_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/// A 64-bit sort key paired with a 32-bit payload, usually an index into an array holding the objects being sorted.
+struct SortItem
+{
+    std::uint64_t key{0};
+    std::uint32_t payload{0};
+};
+
+/**
+ * @brief Sort items by key using a least significant digit radix sort.
+ * The sort is stable. Passes over digits which are equal for all keys are skipped, so keys which only use their lower
+ * bits are sorted in fewer passes.
+ * @param items The items to sort.
+ * @param scratch Holds intermediate results; resized as required. Its contents are unspecified after the call. Reusing
+ * the same vector across calls avoids memory allocation.
+ */
+void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &scratch);
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_RADIX_SORT_HPP
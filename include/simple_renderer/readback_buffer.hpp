@@ -0,0 +1,124 @@
+#ifndef SIMPLERENDERER_READBACK_BUFFER_HPP
+#define SIMPLERENDERER_READBACK_BUFFER_HPP
+
+#include "simple_renderer/buffer_ref.hpp"
+#include "simple_renderer/memory_tracker.hpp"
+
+#include "glutils/gl.hpp"
+#include "glutils/buffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief A persistently mapped buffer that GPU data is copied into, so that it can be read without stalling.
+ * readAsync() issues a copy into the buffer followed by a fence, and returns a Readback which can be polled until the
+ * copy completes, usually a frame or two later. Reading the data then involves no synchronization with the GPU,
+ * unlike RBufferRef::read(), which waits for every command issued so far.
+ *
+ * Space is handed out as a ring; the space of a readback is reused once it and every earlier readback are destroyed.
+ */
+class ReadbackBuffer
+{
+public:
+    /// Data being copied back from the GPU; can be polled without blocking, like a future.
+    class Readback
+    {
+    public:
+        /// An invalid readback, not associated with any data.
+        Readback() = default;
+
+        Readback(const Readback &) = delete;
+        Readback &operator=(const Readback &) = delete;
+
+        Readback(Readback &&other) noexcept;
+        Readback &operator=(Readback &&other) noexcept;
+
+        /// Releases the space of the readback.
+        ~Readback();
+
+        [[nodiscard]] bool isValid() const noexcept
+        { return m_owner != nullptr; }
+
+        /// Has the GPU finished copying the data? Never blocks.
+        [[nodiscard]] bool isReady() const;
+
+        /// Block until the GPU has finished copying the data.
+        void wait() const;
+
+        /// The data, which stays valid as long as *this; waits for the copy if it hasn't completed yet.
+        [[nodiscard]] const std::byte *getData() const;
+
+        [[nodiscard]] std::size_t getSize() const noexcept
+        { return m_size; }
+
+        /// Copy the data into @p destination, which must be getSize() bytes long; waits if necessary.
+        void read(void *destination) const;
+
+    private:
+        friend class ReadbackBuffer;
+
+        Readback(ReadbackBuffer &owner, std::uint64_t id, GLsync fence, const std::byte *data, std::size_t size)
+                : m_owner(&owner), m_id(id), m_fence(fence), m_data(data), m_size(size)
+        {}
+
+        void m_release() noexcept;
+
+        ReadbackBuffer *m_owner{nullptr};
+        std::uint64_t m_id{0};
+        mutable GLsync m_fence{nullptr};    ///< deleted once signaled.
+        const std::byte *m_data{nullptr};
+        std::size_t m_size{0};
+    };
+
+    /// @param capacity total size of the data of the readbacks that may exist at a time, in bytes.
+    explicit ReadbackBuffer(std::size_t capacity);
+
+    ReadbackBuffer(const ReadbackBuffer &) = delete;
+    ReadbackBuffer &operator=(const ReadbackBuffer &) = delete;
+
+    /// Every readback of the buffer must be destroyed first.
+    ~ReadbackBuffer();
+
+    /// Copy the contents of @p source back from the GPU. Returns an empty optional if there isn't enough free space.
+    [[nodiscard]] std::optional<Readback> tryReadAsync(RBufferRef source);
+
+    /// Same as tryReadAsync(), but throws std::logic_error if there isn't enough free space.
+    [[nodiscard]] Readback readAsync(RBufferRef source);
+
+    [[nodiscard]] std::size_t getCapacity() const noexcept
+    { return m_capacity; }
+
+private:
+    /// Space of a readback, in the order they were made.
+    struct Slot
+    {
+        std::size_t offset;
+        std::size_t size;
+        bool released;
+    };
+
+    /// Allocations are aligned to this, the largest value of GL_MIN_MAP_BUFFER_ALIGNMENT.
+    static constexpr std::size_t s_alignment = 64;
+
+    GL::Buffer m_buffer{GL::BufferHandle()};
+    const std::byte *m_mapping{nullptr};
+    std::size_t m_capacity;
+    TrackedMemory m_memory;
+
+    std::deque<Slot> m_slots;
+    std::uint64_t m_first_slot_id{0};   ///< id of the readback m_slots.front() belongs to.
+    std::size_t m_head{0};              ///< offset after the most recent allocation.
+
+    [[nodiscard]] std::optional<std::size_t> m_allocate(std::size_t size);
+
+    void m_release(std::uint64_t id) noexcept;
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_READBACK_BUFFER_HPP
@@ -0,0 +1,112 @@
+#ifndef SIMPLERENDERER_RENDER_LIST_HPP
+#define SIMPLERENDERER_RENDER_LIST_HPP
+
+#include "simple_renderer/shader_program.hpp"
+#include "simple_renderer/drawable.hpp"
+#include "simple_renderer/command_queue.hpp"
+#include "simple_renderer/command_sequence.hpp"
+
+#include "glutils/buffer.hpp"
+
+#include "glm/mat4x4.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief A retained set of draws, submitted to a RenderQueue each frame with RenderQueue::draw(RenderList&).
+ * The draw commands of each drawable are collected when it is added, and the sorted command sequence is kept between
+ * frames. Changing a transform only uploads the changed model matrices; the sequence is rebuilt and sorted again only
+ * when draws are added or removed, or their program, drawable or layer change.
+ *
+ * Since the order doesn't depend on the camera, draws are sorted by layer, program and vertex array, but not by depth.
+ * Drawables and programs must remain valid while they are part of the list.
+ */
+class RenderList
+{
+    friend class RenderQueue;
+
+public:
+    enum class DrawHandle : std::uint32_t;
+
+    RenderList() = default;
+
+    RenderList(const RenderList &) = delete;
+    RenderList &operator=(const RenderList &) = delete;
+
+    ~RenderList();
+
+    /**
+     * @brief Add a draw to the list.
+     * @param model_transform The transformation matrix, accessible in the shader as 'model_matrix' (after the
+     * drawable's vertex transform, if any).
+     * @param layer Draws with a lower layer value are executed first within this list.
+     * @return A handle used to modify or remove the draw.
+     */
+    DrawHandle add(const Drawable &drawable, const ShaderProgram &program, const glm::mat4 &model_transform,
+                   std::uint8_t layer = 0);
+
+    void remove(DrawHandle handle);
+
+    void setTransform(DrawHandle handle, const glm::mat4 &model_transform);
+
+    void setProgram(DrawHandle handle, const ShaderProgram &program);
+
+    void setDrawable(DrawHandle handle, const Drawable &drawable);
+
+    void setLayer(DrawHandle handle, std::uint8_t layer);
+
+    /// Collect the draw commands of a drawable again, e.g. after its geometry changed.
+    void invalidate(DrawHandle handle);
+
+    /// Number of draws in the list.
+    [[nodiscard]] std::size_t size() const
+    { return m_entries.size() - m_free_handles.size(); }
+
+private:
+    using RendererCommandQueue = RendererCommandSet::Instantiate<CommandQueue>;
+
+    struct Entry
+    {
+        const Drawable *drawable{nullptr};
+        const ShaderProgram *program{nullptr};
+        std::uint8_t layer{0};
+
+        /// as given by the user; m_model_matrices holds it combined with the drawable's vertex transform.
+        glm::mat4 model_transform{1.0f};
+
+        /// moving the queue keeps the addresses of its commands, which the command sequence refers to.
+        RendererCommandQueue command_queue;
+    };
+
+    /// indexed by handle; the model matrix of each draw has the same index.
+    std::vector<Entry> m_entries;
+    std::vector<glm::mat4> m_model_matrices;
+    std::vector<DrawHandle> m_free_handles;
+
+    /// draws whose commands must be collected before the next frame.
+    std::vector<DrawHandle> m_stale_handles;
+
+    CommandSequence m_command_sequence;
+    bool m_command_sequence_dirty{false};
+
+    /// indices of model matrices changed since the last upload; may contain duplicates.
+    std::vector<std::uint32_t> m_dirty_matrices;
+
+    GL::Buffer m_model_matrix_buffer{GL::BufferHandle()};
+    std::size_t m_model_matrix_capacity{0};
+
+    Entry &m_getEntry(DrawHandle handle);
+
+    /// Mark the commands of a draw as outdated; also invalidates the command sequence.
+    void m_markStale(DrawHandle handle);
+
+    /// Upload the model matrices changed since the last call and bind them to the model matrix block.
+    void m_uploadModelMatrices();
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_RENDER_LIST_HPP
@@ -6,6 +6,11 @@
 #include "simple_renderer/camera.hpp"
 #include "simple_renderer/command_queue.hpp"
 #include "simple_renderer/draw_command.hpp"
+#include "simple_renderer/command_sequence.hpp"
+#include "simple_renderer/render_list.hpp"
+#include "simple_renderer/frustum_culling.hpp"
+#include "simple_renderer/frame_profiler.hpp"
+#include "simple_renderer/stream_buffer.hpp"
 
 #include "glutils/guard.hpp"
 #include "glutils/program.hpp"
@@ -17,39 +22,240 @@
 #include "glm/vec4.hpp"
 #include "glm/mat4x4.hpp"
 
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace Simple::Renderer {
 
+struct FrameCapture;
+
+/// Specifies how a RenderQueue submits its sorted command sequence to OpenGL.
+enum class SubmissionMode
+{
+    /// Every command results in a separate draw call.
+    immediate,
+
+    /// Runs of consecutive DrawArraysCommand, DrawElementsCommand or DrawElementsBaseVertexCommand of the same type
+    /// that share program, vertex array, draw mode and index type are merged into a single glMultiDrawArraysIndirect
+    /// or glMultiDrawElementsIndirect call. Batched draws pass their model matrix in the base instance, which shaders
+    /// can only read with GL_ARB_shader_draw_parameters; without it, commands are submitted as with immediate.
+    multi_draw_indirect
+};
+
+/// Number of draws recorded for a frame which were culled or kept by RenderQueue.
+struct CullingStats
+{
+    std::size_t visible_draws{0};
+    std::size_t culled_draws{0};
+};
+
 /// Performs rendering operations.
 class RenderQueue
 {
+    friend class FrameReplay;
+
+    using UniformData = glm::mat4;
+
+    /// stores commands and arguments
+    using RendererCommandQueue = RendererCommandSet::Instantiate<CommandQueue>;
+
 public:
+    /**
+     * @brief Collects draws for a RenderQueue.
+     * Each recorder has its own command queue and model matrix storage, so different recorders may be used from
+     * different threads at the same time. A recorder must not be used while its RenderQueue executes finishFrame().
+     */
+    class Recorder
+    {
+        friend class RenderQueue;
+
+    public:
+        /// Same as RenderQueue::draw().
+        void draw(const Drawable& drawable, const ShaderProgram& program, const glm::mat4& model_transform,
+                  std::uint8_t layer = 0);
+
+    private:
+        void m_draw(const Drawable &drawable, GL::ProgramHandle program, const glm::mat4 &model_transform,
+                    std::uint8_t layer);
+
+        void clear();
+
+        std::vector<UniformData> m_uniform_data;
+
+        /// layer of each draw, indexed the same as m_uniform_data.
+        std::vector<std::uint8_t> m_draw_layers;
+
+        /// world space bounds of each draw, indexed the same as m_uniform_data.
+        BoundingBoxArray m_draw_bounds;
+
+        /// set by finishFrame(); 0 for draws outside the view frustum.
+        std::vector<std::uint8_t> m_draw_visibility;
+
+        RendererCommandQueue m_command_queue;
+    };
+
+    RenderQueue() = default;
+
+    RenderQueue(const RenderQueue &) = delete;
+    RenderQueue &operator=(const RenderQueue &) = delete;
+
+    ~RenderQueue();
+
     /**
      * @brief enqueue a draw command.
      * @param program The shader program to draw with. The reference must remain valid until finishFrame is called.
      * @param mesh The mesh to draw.
-     * @param model_transform The transformation matrix, accessible in the shader as 'model_matrix'.
+     * @param model_transform The transformation matrix, accessible in the shader as 'model_matrix' (after the
+     * drawable's vertex transform, if any).
+     * @param layer Draws with a lower layer value are executed first, regardless of program or depth.
      */
-    void draw(const Drawable& drawable, const ShaderProgram& program, const glm::mat4& model_transform);
+    void draw(const Drawable& drawable, const ShaderProgram& program, const glm::mat4& model_transform,
+              std::uint8_t layer = 0)
+    { m_recorder.draw(drawable, program, model_transform, layer); }
+
+    /**
+     * @brief Draw the contents of a render list in the next call to finishFrame.
+     * Render lists are drawn in the order they were submitted, before the draws recorded for the frame. The list must
+     * remain valid until finishFrame is called, and it should not be submitted more than once per frame.
+     */
+    void draw(RenderList &render_list)
+    { m_render_lists.push_back(&render_list); }
+
+    /**
+     * @brief Set the number of additional recorders, usually one for each thread that will record draws.
+     * Draws held by removed recorders are discarded. References to the remaining recorders stay valid.
+     */
+    void setRecorderCount(std::size_t count);
+
+    [[nodiscard]] std::size_t getRecorderCount() const
+    { return m_recorders.size(); }
+
+    /// Access the recorder with index @p index; throws std::out_of_range unless it is less than getRecorderCount().
+    [[nodiscard]] Recorder &getRecorder(std::size_t index)
+    { return *m_recorders.at(index); }
 
-    /// Execute queued drawing commands.
+    /// Execute queued drawing commands, including those recorded by every recorder.
     void finishFrame(const Camera& camera);
 
+    /// Set how commands are submitted to OpenGL from the next call to finishFrame() onwards.
+    void setSubmissionMode(SubmissionMode mode)
+    { m_submission_mode = mode; }
+
+    [[nodiscard]] SubmissionMode getSubmissionMode() const
+    { return m_submission_mode; }
+
+    /// Does finishFrame() submit multi draw indirect batches? Only with SubmissionMode::multi_draw_indirect, and if
+    /// GL_ARB_shader_draw_parameters is supported.
+    [[nodiscard]] bool usesMultiDrawIndirect() const;
+
+    /**
+     * @brief Enable or disable frustum culling, which is enabled by default.
+     * When enabled, draws whose drawable has bounds are skipped if the bounds are outside the camera frustum. Render
+     * lists are never culled.
+     */
+    void setFrustumCulling(bool enabled)
+    { m_frustum_culling = enabled; }
+
+    [[nodiscard]] bool getFrustumCulling() const
+    { return m_frustum_culling; }
+
+    /// Number of draws culled and kept during the last call to finishFrame().
+    [[nodiscard]] const CullingStats &getCullingStats() const
+    { return m_culling_stats; }
+
+    /**
+     * @brief Enable or disable timing of finishFrame(), which is disabled by default.
+     * CPU time is measured for each FramePhase; GPU time is read back a few frames later without stalling.
+     */
+    void setProfiling(bool enabled)
+    { m_profiler.setEnabled(enabled); }
+
+    [[nodiscard]] bool getProfiling() const
+    { return m_profiler.isEnabled(); }
+
+    /// Timings of the last call to finishFrame(); see FrameProfiler::getLastStats().
+    [[nodiscard]] const FrameStats &getFrameStats() const
+    { return m_profiler.getLastStats(); }
+
+    /// Timings of recent calls to finishFrame(), averaged over FrameProfiler::average_frame_count frames.
+    [[nodiscard]] const FrameStats &getAverageFrameStats() const
+    { return m_profiler.getAverageStats(); }
+
+    /**
+     * @brief Store the draws executed by the next call to finishFrame() in @p capture, which must remain valid until
+     * then. Culled draws are left out, and draws of render lists are captured as ordinary draws.
+     * Reading back the referenced buffers and programs stalls the pipeline, so the captured frame will be slow.
+     */
+    void captureNextFrame(FrameCapture &capture)
+    { m_pending_capture = &capture; }
+
 private:
-    using UniformData = glm::mat4;
-    std::vector<UniformData> m_uniform_data;
+    /// used by draw()
+    Recorder m_recorder;
 
-    /// stores commands and arguments
-    using RendererCommandQueue = RendererCommandSet::Instantiate<CommandQueue>;
+    /// each recorder is allocated separately so that concurrent recording doesn't cause false sharing.
+    std::vector<std::unique_ptr<Recorder>> m_recorders;
+
+    /// total number of model matrices recorded this frame.
+    std::size_t m_uniform_data_count{0};
+
+    /// Drawable and ShaderProgram grant access to RenderQueue only, not to its recorders.
+    static void s_collectDrawCommands(const Drawable &drawable, GL::ProgramHandle program,
+                                      RendererCommandQueue &command_queue, std::size_t uniform_data_index);
+
+    static GL::ProgramHandle s_getProgramHandle(const ShaderProgram &program)
+    { return program.m_program; }
+
+    /// Record a draw using a program that isn't owned by a ShaderProgram; used by FrameReplay.
+    void m_drawCaptured(const Drawable &drawable, GL::ProgramHandle program, const glm::mat4 &model_transform,
+                        std::uint8_t layer)
+    { m_recorder.m_draw(drawable, program, model_transform, layer); }
+
+    template<typename Func>
+    void m_forEachRecorder(Func &&func)
+    {
+        func(m_recorder);
+        for (const auto &recorder: m_recorders)
+            func(*recorder);
+    }
+
+    /// draws recorded for the current frame, sorted by draw key.
+    CommandSequence m_command_sequence;
+
+    /// render lists submitted for the current frame.
+    std::vector<RenderList *> m_render_lists;
 
-    RendererCommandQueue m_command_queue;
+    /// Model matrices are written into a stream buffer, so that the GPU may still read those of previous frames.
+    StreamBuffer m_model_matrix_stream{0, StreamBuffer::default_region_count, MemoryCategory::uniform};
 
-    /// holds commands in the order they will be executed
-    std::vector<std::tuple<GL::ProgramHandle, GL::VertexArrayHandle, const UniformData*, const DrawCommand*>>
-            m_command_sequence;
+    /// GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, queried on first use.
+    std::size_t m_storage_buffer_alignment{0};
+
+    SubmissionMode m_submission_mode{SubmissionMode::immediate};
+
+    bool m_frustum_culling{true};
+    CullingStats m_culling_stats;
+
+    FrameProfiler m_profiler;
+
+    FrameCapture *m_pending_capture{nullptr};
 
     struct CommandSequenceBuilder;
+    struct RenderListSequenceBuilder;
+
+    /// Copy the model matrices into the model matrix stream and bind them.
+    void m_uploadModelMatrices();
+
+    /// Set the visibility of every recorded draw and update the culling stats.
+    void m_cullDraws(const Camera &camera);
+
+    /// Fill the pending capture with the draws of the current frame; culling must be done.
+    void m_captureFrame(const Camera &camera);
+
+    /// Collect the commands of changed draws in @p render_list, and rebuild its command sequence if required.
+    static void s_updateRenderList(RenderList &render_list);
 };
 
 } // Simple::Renderer
@@ -1,8 +1,16 @@
 #ifndef SIMPLERENDERER_RENDERER_HPP
 #define SIMPLERENDERER_RENDERER_HPP
 
+#include "simple_renderer/state_cache.hpp"
+
 #include "glm/vec2.hpp"
 
+#include <cstdint>
+
+namespace Simple {
+class Texture2D;
+}
+
 namespace Simple::Renderer {
 
 using glProc = void(*)();
@@ -23,13 +31,57 @@ void setViewport(glm::ivec2 lower_left, glm::ivec2 top_right);
 
 enum class Capability : std::uint32_t
 {
-    cull_face   = 0x0B44,
-    depth_test  = 0X0B71
+    cull_face       = 0x0B44,
+    depth_test      = 0X0B71,
+    stencil_test    = 0x0B90,
+    blend           = 0x0BE2,
+    scissor_test    = 0x0C11
 };
 
 void enable(Capability capability);
 void disable(Capability capability);
 
+/// Comparison used by the depth test.
+enum class DepthFunction : std::uint32_t
+{
+    never           = 0x0200,
+    less            = 0x0201,
+    equal           = 0x0202,
+    less_equal      = 0x0203,
+    greater         = 0x0204,
+    not_equal       = 0x0205,
+    greater_equal   = 0x0206,
+    always          = 0x0207
+};
+
+void setDepthFunction(DepthFunction function);
+
+/// Enable or disable writing to the depth buffer.
+void setDepthWrite(bool enabled);
+
+enum class BlendFactor : std::uint32_t
+{
+    zero = 0,
+    one = 1,
+    source_color = 0x0300,
+    one_minus_source_color = 0x0301,
+    source_alpha = 0x0302,
+    one_minus_source_alpha = 0x0303,
+    destination_alpha = 0x0304,
+    one_minus_destination_alpha = 0x0305,
+    destination_color = 0x0306,
+    one_minus_destination_color = 0x0307
+};
+
+void setBlendFunction(BlendFactor source_factor, BlendFactor destination_factor);
+
+/// Bind @p texture to texture unit @p unit.
+void bindTexture(std::uint32_t unit, const Texture2D &texture);
+
+/// The functions above go through the calling thread's StateCache; get the number of calls it issued and skipped.
+[[nodiscard]] inline const StateCache::Stats &getStateCacheStats()
+{ return StateCache::get().getStats(); }
+
 }//Simple::Renderer
 
 #endif //SIMPLERENDERER_RENDERER_HPP
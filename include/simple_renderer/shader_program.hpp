@@ -363,10 +363,14 @@ public:
      *      vec3 vertex_normal  : the mesh normal at this vertex, in model space.
      *      vec2 vertex_uv      : texture coordinates of the model.
      *
-     * The only predefined output for the vertex stage is the built-in gl_Position variable.
+     * The only predefined output for the vertex stage is the built-in gl_Position variable. The vertex shader's main()
+     * is renamed to user_vertex_main() and called by a main() which also passes the model matrix on to the fragment
+     * stage.
      *
      * Both vertex and fragment shaders have access to the following uniforms:
-     *      mat4 model_matrix   : model space to world space transform matrix.
+     *      mat4 model_matrix   : transform from the positions in the drawable's buffers to world space; the model
+     *                            transform of the draw, after the drawable's vertex transform if it has one (see
+     *                            Drawable::setVertexTransform()).
      *      mat4 view_matrix    : world space to camera space transform matrix.
      *      mat4 proj_matrix    : camera space to clip space transform matrix.
      *
@@ -0,0 +1,159 @@
+#ifndef SIMPLERENDERER_STATE_CACHE_HPP
+#define SIMPLERENDERER_STATE_CACHE_HPP
+
+#include "glutils/gl.hpp"
+
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief Tracks OpenGL state set through it, and skips calls which would not change anything.
+ * Each thread has its own cache, which assumes a single OpenGL context is current on that thread. State is unknown
+ * until first set through the cache, so the first call for each piece of state always reaches OpenGL. If state is
+ * changed by other means, invalidate() must be called.
+ *
+ * Deleting a buffer or texture unbinds it, and its name may then be reused by a new object. Objects which were bound
+ * through the cache must be passed to forgetBuffer() or forgetTexture() before they are deleted.
+ */
+class StateCache
+{
+public:
+    /// Number of calls forwarded to OpenGL and skipped since the last call to resetStats().
+    struct Stats
+    {
+        std::size_t issued_calls{0};
+        std::size_t skipped_calls{0};
+    };
+
+    /// The cache for the calling thread's context.
+    static StateCache &get();
+
+    /// Forget all tracked state, e.g. after OpenGL state has been modified without going through the cache.
+    void invalidate();
+
+    /// Forget bindings of @p buffer; must be called before deleting a buffer bound through the cache.
+    void forgetBuffer(GLuint buffer);
+
+    /// Forget bindings of @p texture; must be called before deleting a texture bound through the cache.
+    void forgetTexture(GLuint texture);
+
+    /// glEnable or glDisable.
+    void setCapability(GLenum capability, bool enabled);
+
+    /// glViewport.
+    void setViewport(glm::ivec2 lower_left, glm::ivec2 size);
+
+    /// glBindTextureUnit.
+    void bindTextureUnit(GLuint unit, GLuint texture);
+
+    /// glBindBufferRange, for indexed targets such as GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER.
+    void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    /// glBindBufferBase.
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    /// glBindBuffer, for non-indexed targets such as GL_DRAW_INDIRECT_BUFFER.
+    void bindBuffer(GLenum target, GLuint buffer);
+
+    /// glBlendFunc.
+    void setBlendFunction(GLenum source_factor, GLenum destination_factor);
+
+    /// glBlendEquation.
+    void setBlendEquation(GLenum mode);
+
+    /// glDepthFunc.
+    void setDepthFunction(GLenum function);
+
+    /// glDepthMask.
+    void setDepthMask(bool enabled);
+
+    [[nodiscard]] const Stats &getStats() const
+    { return m_stats; }
+
+    void resetStats()
+    { m_stats = {}; }
+
+private:
+    StateCache() = default;
+
+    /// Count a call; returns true if it must be forwarded to OpenGL, and stores @p value as the current state.
+    template<typename T>
+    bool m_update(std::optional<T> &current, const T &value)
+    {
+        if (current == value)
+        {
+            m_stats.skipped_calls++;
+            return false;
+        }
+
+        current = value;
+        m_stats.issued_calls++;
+        return true;
+    }
+
+    struct CapabilityState
+    {
+        GLenum capability;
+        std::optional<bool> enabled;
+    };
+
+    struct BufferRange
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;  ///< zero if the whole buffer is bound with glBindBufferBase.
+
+        bool operator==(const BufferRange &other) const
+        { return buffer == other.buffer && offset == other.offset && size == other.size; }
+    };
+
+    struct IndexedBinding
+    {
+        GLenum target;
+        GLuint index;
+        std::optional<BufferRange> range;
+    };
+
+    struct Binding
+    {
+        GLenum target;
+        std::optional<GLuint> buffer;
+    };
+
+    struct BlendFunction
+    {
+        GLenum source_factor;
+        GLenum destination_factor;
+
+        bool operator==(const BlendFunction &other) const
+        { return source_factor == other.source_factor && destination_factor == other.destination_factor; }
+    };
+
+    // few distinct capabilities and binding points are used, so these are searched linearly.
+    std::vector<CapabilityState> m_capabilities;
+    std::vector<IndexedBinding> m_indexed_bindings;
+    std::vector<Binding> m_bindings;
+
+    /// indexed by texture unit.
+    std::vector<std::optional<GLuint>> m_texture_units;
+
+    std::optional<glm::ivec4> m_viewport;
+    std::optional<BlendFunction> m_blend_function;
+    std::optional<GLenum> m_blend_equation;
+    std::optional<GLenum> m_depth_function;
+    std::optional<bool> m_depth_mask;
+
+    Stats m_stats;
+
+    std::optional<BufferRange> &m_getIndexedBinding(GLenum target, GLuint index);
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_STATE_CACHE_HPP
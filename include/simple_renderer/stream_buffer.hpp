@@ -0,0 +1,118 @@
+#ifndef SIMPLERENDERER_STREAM_BUFFER_HPP
+#define SIMPLERENDERER_STREAM_BUFFER_HPP
+
+#include "simple_renderer/buffer.hpp"
+#include "simple_renderer/buffer_ref.hpp"
+#include "simple_renderer/memory_tracker.hpp"
+
+#include "glutils/gl.hpp"
+#include "glutils/buffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief A persistently mapped buffer for data written by the CPU every frame, used as a ring of per-frame regions.
+ * Each frame allocates from its own region; finishFrame() fences the region, and it is reused only once the GPU is
+ * done with it. Writes go straight into the mapping, without the implicit synchronization or driver side copy of
+ * glBufferSubData. Data may be read by the GPU directly from the stream buffer, or copied into another buffer with
+ * upload().
+ */
+class StreamBuffer
+{
+public:
+    /// Memory allocated from the current region; it may be written until the end of the frame.
+    struct Allocation
+    {
+        std::byte *data{nullptr};   ///< mapped memory, write only.
+        GL::BufferHandle buffer{};
+        std::uintptr_t offset{0};   ///< byte offset of data within buffer.
+        std::size_t size{0};
+
+        [[nodiscard]] BufferRange<std::byte> getBufferRange() const
+        { return {buffer, {offset, size}}; }
+
+        /// Reference for copying the allocated data into another buffer.
+        [[nodiscard]] RBufferRef getReadRef() const
+        { return {buffer, offset, size}; }
+    };
+
+    /// Number of regions, i.e. frames that may be in flight, used unless specified otherwise.
+    static constexpr std::size_t default_region_count = 3;
+
+    /// Create a stream buffer with @p region_count regions of at least @p region_size bytes each; @p category is
+    /// what the streamed data is used for, for memory accounting.
+    explicit StreamBuffer(std::size_t region_size = 0, std::size_t region_count = default_region_count,
+                          MemoryCategory category = MemoryCategory::staging);
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    ~StreamBuffer();
+
+    /**
+     * @brief Ensure each region can hold at least @p region_size bytes.
+     * If the buffer must grow, waits until the GPU is done with every region and replaces the buffer object, which
+     * invalidates the allocations made during the current frame. Should be called before any allocation in a frame.
+     */
+    void reserve(std::size_t region_size);
+
+    /// Allocate @p size bytes from the current region, with an offset that is a multiple of @p alignment (a power of
+    /// two). Returns an empty optional if the region doesn't have enough free space.
+    [[nodiscard]] std::optional<Allocation> tryAllocate(std::size_t size, std::size_t alignment = 1);
+
+    /// Same as tryAllocate(), but throws std::logic_error if the region doesn't have enough free space.
+    [[nodiscard]] Allocation allocate(std::size_t size, std::size_t alignment = 1);
+
+    /// Allocate @p size bytes and copy @p data into them.
+    Allocation write(const void *data, std::size_t size, std::size_t alignment = 1);
+
+    /// Update @p destination with the contents of @p data, which must have the size of @p destination. Data is
+    /// written to the current region and copied by the GPU; if the region is full, it is written to @p destination
+    /// directly instead.
+    void upload(WBufferRef destination, const void *data);
+
+    /// Mark the current region as in use by the commands issued so far, and move to the next one.
+    void finishFrame();
+
+    [[nodiscard]] GL::BufferHandle getBufferHandle() const noexcept
+    { return m_buffer; }
+
+    /// Size of each region, in bytes.
+    [[nodiscard]] std::size_t getRegionSize() const noexcept
+    { return m_region_size; }
+
+    [[nodiscard]] std::size_t getRegionCount() const noexcept
+    { return m_fences.size(); }
+
+    /// Bytes allocated from the current region.
+    [[nodiscard]] std::size_t getUsedSize() const noexcept
+    { return m_used_size; }
+
+private:
+    /// Regions start at multiples of this, so that aligned allocations are aligned relative to the buffer as well.
+    static constexpr std::size_t s_region_alignment = 256;
+
+    GL::Buffer m_buffer{GL::BufferHandle()};
+    std::byte *m_mapping{nullptr};
+    std::size_t m_region_size{0};
+    TrackedMemory m_memory;
+
+    /// fence for the commands that last used each region; null if the region is not in use.
+    std::vector<GLsync> m_fences;
+
+    std::size_t m_region{0};        ///< index of the region used by the current frame.
+    std::size_t m_used_size{0};     ///< bytes allocated from the current region.
+    bool m_region_ready{false};     ///< set once the GPU is known to be done with the current region.
+
+    /// Wait until the GPU is done with the current region, if not done already.
+    void m_waitForRegion();
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_STREAM_BUFFER_HPP
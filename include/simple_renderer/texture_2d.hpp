@@ -1,10 +1,15 @@
 #ifndef PROCEDURALPLACEMENTLIB_TEXTURE_2_D_HPP
 #define PROCEDURALPLACEMENTLIB_TEXTURE_2_D_HPP
 
+#include "simple_renderer/memory_tracker.hpp"
+#include "simple_renderer/upload_queue.hpp"
+
 #include "glutils/texture.hpp"
 
 #include "glm/vec2.hpp"
 
+#include <optional>
+
 namespace Simple {
 
 class ImageData;
@@ -14,15 +19,30 @@ class Texture2D
 public:
     explicit Texture2D(const ImageData& image, bool generate_mipmaps = true);
 
+    /// Allocate the texture's storage right away, and upload its image through @p upload_queue. The texture must not
+    /// be destroyed before the upload completes; see getUploadTicket().
+    Texture2D(const ImageData& image, Renderer::UploadQueue& upload_queue, bool generate_mipmaps = true);
+
+    Texture2D(Texture2D&&) noexcept = default;
+    Texture2D& operator=(Texture2D&& other) noexcept;
+
+    ~Texture2D();
+
     [[nodiscard]]
     GL::TextureHandle getGLObject() const { return m_texture; }
 
     [[nodiscard]]
     glm::uvec2 getSize() const { return m_size; }
 
+    /// The ticket of the image upload, for textures created with an upload queue.
+    [[nodiscard]]
+    const std::optional<Renderer::UploadQueue::Ticket>& getUploadTicket() const { return m_upload_ticket; }
+
 private:
     GL::Texture m_texture;
     glm::uvec2 m_size;
+    std::optional<Renderer::UploadQueue::Ticket> m_upload_ticket;
+    Renderer::TrackedMemory m_memory;
 };
 
 } // simple
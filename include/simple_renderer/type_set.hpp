@@ -2,11 +2,19 @@
 #define PROCEDURALPLACEMENTLIB_TYPE_SET_HPP
 
 #include <type_traits>
+#include <utility>
 
 namespace Simple {
 
 template<typename ... Types> struct TypeSet;
 
+/// An empty object representing the type @p T; used to pass types as function arguments.
+template<typename T>
+struct TypeTag
+{
+    using Type = T;
+};
+
 template<>
 struct TypeSet<> final
 {
@@ -21,6 +29,10 @@ struct TypeSet<> final
     static constexpr std::size_t type_index = getTypeIndex<T>();
 
     static constexpr std::size_t type_count = 0;
+
+    template<typename Func>
+    static constexpr void visit(std::size_t, Func &&)
+    {}
 };
 
 template<typename Head, typename ... Tail>
@@ -40,6 +52,22 @@ struct TypeSet<Head, Tail...> final
 
     static constexpr std::size_t type_count = 1 + sizeof...(Tail);
 
+    /**
+     * @brief Invoke a functor with the TypeTag of the type with the specified index.
+     * The functor is called directly, with the type known at compile time; the index is matched with a chain of
+     * comparisons that compilers usually lower to a switch. Nothing is called if @p index is out of range.
+     * @param index The index of a type in the set, as given by type_index.
+     * @param func A functor that accepts a TypeTag of any type in the set, such as a generic lambda.
+     */
+    template<typename Func>
+    static constexpr void visit(std::size_t index, Func &&func)
+    {
+        if (index == 0)
+            func(TypeTag<Head>());
+        else
+            TypeSet<Tail...>::visit(index - 1, std::forward<Func>(func));
+    }
+
     /// Instantiate a template using the types in the set as arguments.
     template<template<typename...> class Class>
     using Instantiate = Class<Head, Tail...>;
@@ -0,0 +1,125 @@
+#ifndef SIMPLERENDERER_UPLOAD_QUEUE_HPP
+#define SIMPLERENDERER_UPLOAD_QUEUE_HPP
+
+#include "simple_renderer/buffer_ref.hpp"
+#include "simple_renderer/stream_buffer.hpp"
+
+#include "glutils/gl.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace Simple::Renderer {
+
+/**
+ * @brief Uploads data to the GPU a bit at a time, so that loading many objects doesn't stall a frame.
+ * Enqueued data is kept on the host until update() packs it into a staging stream buffer and issues the copies to its
+ * destination, up to a byte budget per call. The staging buffer never grows beyond the budget. Each job gets a ticket,
+ * which becomes complete once the GPU has finished its copies; jobs complete in the order they were enqueued.
+ */
+class UploadQueue
+{
+public:
+    /// Identifies an upload; tickets of later uploads compare greater.
+    enum class Ticket : std::uint64_t;
+
+    /// Issues the GPU commands that copy staged data to its destination.
+    using CopyFunction = std::function<void(RBufferRef staged)>;
+
+    /// @param byte_budget maximum number of bytes staged by each call to update().
+    explicit UploadQueue(std::size_t byte_budget = std::size_t(16) << 20);
+
+    UploadQueue(const UploadQueue &) = delete;
+    UploadQueue &operator=(const UploadQueue &) = delete;
+
+    ~UploadQueue();
+
+    /// Copy @p destination.getSize() bytes from @p data, to be written into @p destination. The destination buffer
+    /// must stay valid until the upload completes.
+    Ticket enqueue(WBufferRef destination, const void *data);
+
+    /// Same as enqueue(WBufferRef, const void *), but takes ownership of @p data instead of copying it.
+    Ticket enqueue(WBufferRef destination, std::vector<std::byte> data);
+
+    /// Stage @p data, then call @p copy with the staged bytes; used for destinations other than buffer ranges, such as
+    /// textures. Anything referenced by @p copy must stay valid until it is called.
+    Ticket enqueue(std::vector<std::byte> data, CopyFunction copy);
+
+    /**
+     * @brief Issue the copies of pending uploads, and check which ones have completed. Meant to be called once per
+     * frame. Uploads are staged in order until the byte budget is reached. Uploads to buffer ranges are split into
+     * chunks, so a big one is spread over several calls. Other uploads bigger than the budget can't be split; when one
+     * is first in line, it's copied through a temporary buffer and takes the whole budget of the call.
+     */
+    void update();
+
+    /// Issue all pending uploads regardless of the budget and block until they complete.
+    void finish();
+
+    /// Has the GPU finished the copies of the upload with the given ticket? Only updated by update() and finish(), but
+    /// may be called from any thread, e.g. by render queue recorders.
+    [[nodiscard]] bool isComplete(Ticket ticket) const noexcept
+    { return static_cast<std::uint64_t>(ticket) <= m_completed_ticket.load(std::memory_order_acquire); }
+
+    /// Ticket of the most recently enqueued upload; it completes after every upload enqueued before it.
+    [[nodiscard]] Ticket getLastTicket() const noexcept
+    { return static_cast<Ticket>(m_last_ticket); }
+
+    [[nodiscard]] std::size_t getByteBudget() const noexcept
+    { return m_byte_budget; }
+
+    void setByteBudget(std::size_t byte_budget)
+    { m_byte_budget = byte_budget; }
+
+    /// Bytes enqueued but not staged yet.
+    [[nodiscard]] std::size_t getPendingSize() const noexcept
+    { return m_pending_size; }
+
+private:
+    struct Job
+    {
+        std::vector<std::byte> data;
+        /// set for uploads to a buffer range, which may be staged in chunks; otherwise the upload uses copy.
+        std::optional<WBufferRef> destination;
+        CopyFunction copy;
+        std::uint64_t ticket;
+        /// bytes of data already staged.
+        std::size_t staged_size{0};
+    };
+
+    /// Copies issued by a single call to update(), which complete together.
+    struct Batch
+    {
+        GLsync fence;
+        std::uint64_t last_ticket;
+    };
+
+    /// Staged data must stay in place until copied, so regions outnumber the frames a batch may be in flight.
+    static constexpr std::size_t s_staging_region_count = 3;
+
+    std::size_t m_byte_budget;
+    std::size_t m_pending_size{0};
+
+    std::deque<Job> m_jobs;
+    std::deque<Batch> m_batches;
+    StreamBuffer m_staging{0, s_staging_region_count};
+
+    std::uint64_t m_last_ticket{0};
+    /// written by the thread calling update(), read by any thread through isComplete().
+    std::atomic<std::uint64_t> m_completed_ticket{0};
+
+    /// Stage jobs and issue their copies, up to the byte budget.
+    void m_submit();
+
+    /// Retire batches whose copies are done; if @p wait, block until all of them are.
+    void m_retireBatches(bool wait);
+};
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_UPLOAD_QUEUE_HPP
@@ -278,6 +278,31 @@ public:
         bindVertexBufferAttributeImpl<S, B>(buffer_index, buffer_range, attrib_index, normalized);
     }
 
+    /**
+     * @brief Specify an attribute sourced from interleaved vertex data, i.e. a buffer range holding a struct per
+     * vertex, which must be bound to @p buffer_index with bindVertexBuffer().
+     * @tparam ShaderType Type of the attribute as declared in the vertex shader.
+     * @tparam BufferType Type of the attribute's member of the struct.
+     * @param relative_offset Offset of the attribute within the struct, usually obtained with offsetof.
+     */
+    template<typename ShaderType, typename BufferType>
+    void bindInterleavedAttribute(BufferIndex buffer_index, AttribIndex attrib_index, uint relative_offset) const
+    {
+        bindAttribute(attrib_index, buffer_index);
+        setAttributeFormat<ShaderType, BufferType>(attrib_index, relative_offset);
+        enableAttribute(attrib_index);
+    }
+
+    /// Same as above, for integer data converted to a floating point attribute; see setAttributeFormat().
+    template<typename S, typename B>
+    void bindInterleavedAttribute(BufferIndex buffer_index, AttribIndex attrib_index, uint relative_offset,
+                                  bool normalized) const
+    {
+        bindAttribute(attrib_index, buffer_index);
+        setAttributeFormat<S, B>(attrib_index, relative_offset, normalized);
+        enableAttribute(attrib_index);
+    }
+
     /// Get a handle for the underlying OpenGL object.
     [[nodiscard]]
     GL::VertexArrayHandle getGLObject() const
@@ -40,6 +40,11 @@ public:
                          instance_divisor);
     }
 
+    /// Update the bindings to a vertex buffer section that has been moved from @p old_offset, e.g. by
+    /// VertexBuffer::compact(). Attributes keep their locations and formats.
+    void rebindSection(const VertexBuffer &vertex_buffer, const VertexBufferSectionDescriptor &section,
+                       std::uint64_t old_offset);
+
     /// Mark an attribute as unused.
     void unbindAttribute(GLuint attribute_location);
 
@@ -47,6 +52,10 @@ public:
     void bindIndexBuffer(const VertexBuffer &vertex_buffer);
     void unbindIndexBuffer();
 
+    /// Obtain a handle to the underlying GL vertex array object.
+    [[nodiscard]] GL::VertexArrayHandle getVertexArrayHandle() const noexcept
+    { return m_vertex_array; }
+
     /// Emplace a command using this vertex batch.
     template<typename Command>
     void emplaceDrawCommand(const Renderer::Drawable::CommandCollector &collector, Command &&command) const
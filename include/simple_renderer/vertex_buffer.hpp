@@ -4,6 +4,9 @@
 #include "simple_renderer/buffer.hpp"
 #include "simple_renderer/allocation_registry.hpp"
 #include "simple_renderer/buffer_ref.hpp"
+#include "simple_renderer/dirty_range_set.hpp"
+#include "simple_renderer/stream_buffer.hpp"
+#include "simple_renderer/upload_queue.hpp"
 
 #include "glutils/vertex_attrib_utils.hpp"
 
@@ -12,6 +15,8 @@
 #include <utility>
 #include <tuple>
 #include <functional>
+#include <future>
+#include <memory>
 
 namespace Simple {
 
@@ -62,6 +67,18 @@ public:
     constexpr explicit operator bool() const noexcept
     { return size() > 0; }
 
+    /// The element with index @p index, without bounds checking.
+    [[nodiscard]] const VertexType &operator[](size_t index) const
+    { return m_value_initialize ? *m_data : m_data[index]; }
+
+    /// Invoke @p func with each element, in order, without copying them.
+    template<typename Func>
+    void forEach(Func &&func) const
+    {
+        for (size_t i = 0; i < m_size; i++)
+            func(m_value_initialize ? *m_data : m_data[i]);
+    }
+
 private:
     void valueInitialize(VertexType *data) const
     {
@@ -116,8 +133,15 @@ public:
     explicit VertexBuffer(size_t vertex_count) : VertexBuffer({Ts(), vertex_count}...)
     {}
 
-    /// Construct from a list of vertex data initializers, one for each section.
+    /// Construct from a list of vertex data initializers, one for each section. The initializers write directly into
+    /// the buffer's mapped storage, one after the other.
     explicit VertexBuffer(VertexDataInitializer<Ts>... initializers)
+            : VertexBuffer(std::launch::deferred, initializers...)
+    {}
+
+    /// Same as VertexBuffer(VertexDataInitializer<Ts>...), but each section is written as if by
+    /// std::async(@p policy, ...); with std::launch::async, large sections are written in parallel.
+    explicit VertexBuffer(std::launch policy, VertexDataInitializer<Ts>... initializers)
             : m_ranges{TypedRange<Ts>(TypedOffset<Ts>(), initializers.size())...}
     {
         initializeRangeOffsets();
@@ -125,14 +149,16 @@ public:
         const auto last_range = getTypedRange<sizeof...(Ts) - 1>();
         const size_t buffer_size{last_range.offset + last_range.size};
 
-        // create temporary byte array
-        std::vector<std::byte> byte_array;
-        byte_array.reserve(buffer_size);
-
-        initializeByteArray(std::tie(initializers...), byte_array.data());
-
-        // create buffer
-        m_buffer = Buffer(buffer_size, byte_array.data());
+        m_buffer = Buffer(buffer_size, [&](std::byte *data)
+        {
+            // every section must be written before the buffer is unmapped, even if one of them throws; the futures
+            // returned by std::async wait for their task when destroyed.
+            std::array<std::future<void>, sizeof...(Ts)> sections;
+            initializeSections(std::tie(initializers...), data, policy, sections);
+
+            for (std::future<void> &section: sections)
+                section.get();
+        });
     }
 
     /// Construct a BufferRange object for the section with the specified index.
@@ -175,23 +201,18 @@ private:
     }
 
     template<size_t I = 0, typename Tuple>
-    constexpr void initializeByteArray(const Tuple &initializers, std::byte *array)
+    void initializeSections(const Tuple &initializers, std::byte *data, std::launch policy,
+                            std::array<std::future<void>, sizeof...(Ts)> &sections) const
     {
         if constexpr (I < sizeof...(Ts))
         {
-            initializeByteArraySection(std::get<I>(initializers), getTypedRange<I>().offset, array);
+            auto *section_data = reinterpret_cast<VertexTypeByIndex<I> *>(data + getTypedRange<I>().offset.get());
+            sections[I] = std::async(policy, std::get<I>(initializers), section_data);
 
-            initializeByteArray<I + 1>(initializers, array);
+            initializeSections<I + 1>(initializers, data, policy, sections);
         }
     }
 
-    template<typename T>
-    void
-    initializeByteArraySection(const VertexDataInitializer<T> &initializer, TypedOffset <T> offset, std::byte *array)
-    {
-        initializer(reinterpret_cast<T *>(array + offset.get()));
-    }
-
     std::tuple<TypedRange < Ts>...>
     m_ranges;
     Buffer m_buffer;
@@ -230,13 +251,12 @@ public:
     VertexBuffer(ContiguousIterator begin, ContiguousIterator end) : VertexBuffer({begin, end})
     {}
 
-    explicit VertexBuffer(VertexDataInitializer<T> initializer) : m_vertex_count(initializer.size())
-    {
-        std::vector<T> vector;
-        vector.resize(initializer.size());
-        initializer(vector.data());
-        m_buffer = Buffer(initializer.size() * stride, vector.data());
-    }
+    /// Construct from an initializer, which writes directly into the buffer's mapped storage.
+    explicit VertexBuffer(VertexDataInitializer<T> initializer)
+            : m_vertex_count(initializer.size()),
+              m_buffer(m_vertex_count * stride, [&initializer](std::byte *data)
+              { initializer(reinterpret_cast<T *>(data)); })
+    {}
 
     template<typename Container>
     explicit VertexBuffer(const Container &container)
@@ -371,8 +391,8 @@ class VertexBuffer final
 public:
     using size_uint = std::uint64_t;
 
-    /// Construct a vertex buffer with fixed storage size.
-    explicit VertexBuffer(size_uint size);
+    /// Construct a vertex buffer with fixed storage size; @p category is used for memory accounting.
+    explicit VertexBuffer(size_uint size, Renderer::MemoryCategory category = Renderer::MemoryCategory::vertex);
 
     /// Return the size of the buffer, in bytes.
     [[nodiscard]] size_uint getBufferSize() const noexcept
@@ -415,6 +435,12 @@ public:
     const VertexBufferSectionDescriptor &addAttributeData(const void *vertex_data, size_uint vertex_count,
                                                           VertexAttributeSequence sequence);
 
+    /// Same as addAttributeData(const void *, size_uint, VertexAttributeSequence), but the data is copied into
+    /// @p upload_queue and written to the buffer asynchronously; see UploadQueue::getLastTicket().
+    const VertexBufferSectionDescriptor &addAttributeData(const void *vertex_data, size_uint vertex_count,
+                                                          VertexAttributeSequence sequence,
+                                                          Renderer::UploadQueue &upload_queue);
+
     /// Copy vertex data from a buffer into the vertex buffer, creating a new section.
     /**
      * This function copies @p vertex_count * @p vertex_attribute_sequence.getStride() bytes from @p read_buffer to
@@ -464,8 +490,50 @@ public:
     void updateAttributeData(size_uint index, GL::BufferHandle read_buffer,
                              size_uint read_offset) const;
 
+    /// Same as updateAttributeData(size_uint, const void *), but uploads the data through @p stream_buffer.
+    void updateAttributeData(size_uint index, const void *data, Renderer::StreamBuffer &stream_buffer) const;
+
     void updateAttributeData(size_uint index, const std::function<void(WBufferRef)> &initializer);
 
+    /// Default for the merge_gap argument of flushDirtyRanges(), in bytes.
+    static constexpr size_uint default_merge_gap = 256;
+
+    /// Keep a copy of a section's data in host memory, so that it can be modified a few vertices at a time.
+    /**
+     * Modifications made with updateVertices(), or directly in getShadowCopy() followed by markDirty(), are recorded
+     * as dirty byte ranges and uploaded by flushDirtyRanges(). The current contents of the section are read back from
+     * the buffer once. updateAttributeData(size_uint, const void *) keeps the shadow copy up to date; other updates
+     * of the section don't, and must not be mixed with modifications of the shadow copy.
+     * @param index the index of the section.
+     */
+    void enableShadowCopy(size_uint index);
+
+    /// Release the shadow copy of a section, discarding modifications not flushed yet.
+    void disableShadowCopy(size_uint index);
+
+    [[nodiscard]] bool hasShadowCopy(size_uint index) const noexcept
+    { return m_getShadow(index) != nullptr; }
+
+    /// Access the shadow copy of a section; throws std::logic_error if the section has none.
+    [[nodiscard]] std::byte *getShadowCopy(size_uint index);
+
+    /// Record that @p vertex_count vertices starting at @p first_vertex were modified in the shadow copy of a section.
+    void markDirty(size_uint index, size_uint first_vertex, size_uint vertex_count);
+
+    /// Copy @p vertex_count vertices from @p data into the shadow copy of a section, starting at @p first_vertex.
+    void updateVertices(size_uint index, size_uint first_vertex, size_uint vertex_count, const void *data);
+
+    /// Upload the dirty ranges of all shadow copies, usually once at the end of a frame.
+    /**
+     * The dirty ranges of each section are merged when separated by at most @p merge_gap bytes, and each resulting
+     * range is uploaded with a single write. A bigger gap uploads a few more bytes with fewer calls.
+     */
+    void flushDirtyRanges(size_uint merge_gap = default_merge_gap);
+
+    /// Same as flushDirtyRanges(size_uint), but all dirty ranges are written into a single allocation of
+    /// @p stream_buffer and copied into place by the GPU. Falls back to direct writes if the region is full.
+    void flushDirtyRanges(Renderer::StreamBuffer &stream_buffer, size_uint merge_gap = default_merge_gap);
+
     /// Discard the data section with the given index.
     /**
      * References to the section descriptor and those with a greater index will be invalidated. The contents of all
@@ -474,10 +542,31 @@ public:
      */
     void discardAttributeData(size_uint index);
 
+    /// Move sections towards the start of the buffer, to merge the free space left by discarded sections.
+    /**
+     * Sections are moved in order of offset, each one right after the previous, with copies inside the buffer object;
+     * section indices don't change. The work done by each call is limited by @p byte_budget, so that a buffer may be
+     * compacted a bit at a time, e.g. once per frame. A section bigger than the budget is only moved if it is the
+     * first to be moved by the call, so that every call makes progress. A section moved by less than its size goes
+     * through a scratch buffer, which is kept until the buffer is fully compacted.
+     *
+     * Vertex arrays that source attributes from a moved section must be rebound; @p on_section_moved is called with
+     * the index and the old offset of each moved section, after its descriptor has been updated.
+     * @param byte_budget maximum number of bytes to copy.
+     * @param on_section_moved called for each moved section.
+     * @return true if the buffer is fully compacted, i.e. all of its free space is at its end.
+     */
+    bool compact(size_uint byte_budget,
+                 const std::function<void(size_uint section_index, size_uint old_offset)> &on_section_moved);
+
     /// Calculate the maximum size of a new section given the remaining space.
     [[nodiscard]] size_uint getMaxNewSectionSize() const
     { return m_allocator.getMaxAllocation(); }
 
+    /// Describe how the free space between sections is split.
+    [[nodiscard]] AllocationRegistry::FragmentationReport getFragmentationReport() const
+    { return m_allocator.getFragmentationReport(); }
+
     [[nodiscard]] auto begin() const
     { return m_sections.begin(); }
 
@@ -493,10 +582,39 @@ public:
                                                                              const VertexAttributeSequence& attributes);
 
 private:
+    /// Host copy of a section's data, and the ranges of it modified since the last flush.
+    struct SectionShadow
+    {
+        std::vector<std::byte> data;
+        Renderer::DirtyRangeSet dirty_ranges;
+    };
+
     GL::Buffer m_buffer;
     size_uint m_size;
+    Renderer::TrackedMemory m_memory;
     AllocationRegistry m_allocator;
     std::vector<VertexBufferSectionDescriptor> m_sections;
+
+    /// Shadow copies by section index; only as long as needed for the last section with one.
+    std::vector<std::unique_ptr<SectionShadow>> m_shadows;
+
+    /// Section indices by offset, kept between compact() calls since moving sections down doesn't change their
+    /// order; cleared when sections are added or discarded. The first m_compacted_count sections are packed.
+    std::vector<size_uint> m_compaction_order;
+    size_uint m_compacted_count{0};
+
+    /// Holds a section while it is moved by less than its size, since copies within a buffer must not overlap.
+    GL::Buffer m_compaction_scratch{GL::BufferHandle()};
+    Renderer::TrackedMemory m_compaction_scratch_memory;
+
+    /// Copy @p size bytes from @p old_offset down to @p new_offset, which may overlap.
+    void m_moveData(size_uint old_offset, size_uint new_offset, size_uint size);
+
+    [[nodiscard]] SectionShadow *m_getShadow(size_uint index) const noexcept
+    { return index < m_shadows.size() ? m_shadows[index].get() : nullptr; }
+
+    /// Same as m_getShadow(), but throws std::logic_error if the section has no shadow copy.
+    [[nodiscard]] SectionShadow &m_getExistingShadow(size_uint index) const;
 };
 
 } // namespace Simple
@@ -0,0 +1,104 @@
+#ifndef SIMPLERENDERER_VERTEX_ENCODING_HPP
+#define SIMPLERENDERER_VERTEX_ENCODING_HPP
+
+#include "simple_renderer/bounding_box.hpp"
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
+
+#include <cstdint>
+
+namespace Simple::Renderer {
+
+/// How vertex positions are stored in a vertex buffer.
+enum class PositionEncoding : std::uint8_t
+{
+    /// 3 floats; 12 bytes.
+    float32,
+    /// 3 normalized 16-bit integers relative to the mesh bounds, see PositionQuantization; 8 bytes with padding.
+    snorm16,
+};
+
+/// How vertex normals are stored in a vertex buffer.
+enum class NormalEncoding : std::uint8_t
+{
+    /// 3 floats; 12 bytes.
+    float32,
+    /**
+     * @brief The unit vector mapped onto an octahedron, stored as 2 normalized 16-bit integers; 4 bytes. Shaders read
+     * the encoded value as vertex_normal.xy and decode it with decode_octahedral_normal().
+     */
+    octahedral_snorm16,
+};
+
+/// How texture coordinates are stored in a vertex buffer.
+enum class UVEncoding : std::uint8_t
+{
+    /// 2 floats; 8 bytes.
+    float32,
+    /// 2 normalized 16-bit unsigned integers; 4 bytes. Only for coordinates within [0, 1], others are clamped.
+    unorm16,
+    /// 2 half precision floats; 4 bytes.
+    float16,
+};
+
+/// Storage format of each vertex attribute of a mesh. Smaller formats save memory and bandwidth, at some precision.
+struct VertexEncoding
+{
+    PositionEncoding position{PositionEncoding::float32};
+    NormalEncoding normal{NormalEncoding::float32};
+    UVEncoding uv{UVEncoding::float32};
+
+    /// Does any attribute use an encoding other than float32?
+    [[nodiscard]] constexpr bool isCompressed() const
+    {
+        return position != PositionEncoding::float32 || normal != NormalEncoding::float32 || uv != UVEncoding::float32;
+    }
+
+    /// The smallest encodings: 16 bytes per vertex instead of 32.
+    static constexpr VertexEncoding compact()
+    { return {PositionEncoding::snorm16, NormalEncoding::octahedral_snorm16, UVEncoding::float16}; }
+};
+
+/**
+ * @brief Maps positions within a box to normalized 16-bit integers, for PositionEncoding::snorm16.
+ * The scale is the same along every axis, so that the dequantization transform can be folded into the model matrix
+ * without distorting normals.
+ */
+struct PositionQuantization
+{
+    glm::vec3 offset{0.0f};
+    float scale{1.0f};
+
+    /// A quantization covering @p bounds.
+    static PositionQuantization fromBounds(const AxisAlignedBox &bounds);
+
+    /// Quantize @p position; the fourth component is padding and always 0.
+    [[nodiscard]] glm::vec<4, std::int16_t> encode(const glm::vec3 &position) const;
+
+    [[nodiscard]] glm::vec3 decode(const glm::vec<4, std::int16_t> &encoded) const;
+
+    /// Transforms normalized positions, as read by a vertex shader, back to the original ones.
+    [[nodiscard]] glm::mat4 getDequantizationTransform() const;
+};
+
+/// Encode the unit vector @p normal with octahedral mapping into 2 normalized 16-bit integers.
+glm::vec<2, std::int16_t> encodeOctahedralNormal(const glm::vec3 &normal);
+
+/// Inverse of encodeOctahedralNormal(); the same as decode_octahedral_normal() in shaders.
+glm::vec3 decodeOctahedralNormal(const glm::vec<2, std::int16_t> &encoded);
+
+/// Encode @p uv into 2 normalized 16-bit unsigned integers, clamping it to [0, 1].
+glm::vec<2, std::uint16_t> encodeUnorm16(const glm::vec2 &uv);
+
+/// Convert @p value to an IEEE half precision float, rounding to nearest even. Values too large become infinity.
+std::uint16_t encodeHalf(float value);
+
+/// Convert the IEEE half precision float @p value to float.
+float decodeHalf(std::uint16_t value);
+
+} // Simple::Renderer
+
+#endif //SIMPLERENDERER_VERTEX_ENCODING_HPP
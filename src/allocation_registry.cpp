@@ -3,39 +3,232 @@
 #include <stdexcept>
 #include <algorithm>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
 namespace Simple {
 
-AllocationRegistry::AllocationRegistry(uintptr size) : m_size(size) {}
+/// Index of the highest set bit; @p value must not be zero.
+static unsigned floorLog2(std::uint64_t value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    unsigned index = 0;
+    while (value >>= 1)
+        index++;
+    return index;
+#endif
+}
 
-auto AllocationRegistry::m_findFreeBlock(AllocationRegistry::uintptr size) noexcept
+/// Index of the lowest set bit; @p value must not be zero.
+static unsigned findLowestBit(std::uint64_t value) noexcept
 {
-    auto it = m_blocks.begin();
-    uintptr offset = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    unsigned index = 0;
+    while (!(value & 1))
+    {
+        value >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
 
-    while (it != m_blocks.end() && !(it->isFree() && it->getSize() >= size))
-        offset += it++->getSize();
+AllocationRegistry::AllocationRegistry(uintptr size) : m_size(size), m_free_bytes(size)
+{
+    m_free_lists.fill(s_no_block);
 
-    return std::make_pair(it, offset);
+    // the whole range starts as a single free block
+    if (size > 0)
+        m_insertFreeBlock(m_createBlock({0, size}));
 }
 
-auto AllocationRegistry::tryAllocate(AllocationRegistry::uintptr size) -> std::optional<uintptr>
+std::size_t AllocationRegistry::s_getSizeClass(uintptr size) noexcept
+{
+    if (size < s_class_subdivisions)
+        return size;
+
+    const unsigned log2 = floorLog2(size);
+    const std::size_t group = log2 - s_class_subdivision_bits + 1;
+    const std::size_t subdivision = (size >> (log2 - s_class_subdivision_bits)) & (s_class_subdivisions - 1);
+
+    return group * s_class_subdivisions + subdivision;
+}
+
+std::size_t AllocationRegistry::s_getFittingSizeClass(uintptr size) noexcept
 {
-    const auto [iter, offset] = m_findFreeBlock(size);
+    if (size < s_class_subdivisions)
+        return size;
 
-    if (iter != m_blocks.cend())
+    // round up to the next class boundary, so that every block of the class is big enough
+    const uintptr class_width = uintptr(1) << (floorLog2(size) - s_class_subdivision_bits);
+    const uintptr rounded_size = size + class_width - 1;
+
+    if (rounded_size < size)
+        return s_class_count;
+
+    return s_getSizeClass(rounded_size);
+}
+
+std::size_t AllocationRegistry::m_findNonEmptyClass(std::size_t size_class) const noexcept
+{
+    if (size_class >= s_class_count)
+        return s_class_count;
+
+    const std::size_t group = size_class / s_class_subdivisions;
+    const std::size_t subdivision = size_class % s_class_subdivisions;
+
+    const std::uint64_t classes = m_class_bitmaps[group] & (~std::uint64_t(0) << subdivision);
+    if (classes)
+        return group * s_class_subdivisions + findLowestBit(classes);
+
+    const std::uint64_t groups = m_group_bitmap & (~std::uint64_t(0) << group << 1);
+    if (!groups)
+        return s_class_count;
+
+    const unsigned next_group = findLowestBit(groups);
+    return next_group * s_class_subdivisions + findLowestBit(m_class_bitmaps[next_group]);
+}
+
+auto AllocationRegistry::m_findFreeBlock(uintptr size) const noexcept -> BlockIndex
+{
+    const std::size_t size_class = m_findNonEmptyClass(s_getFittingSizeClass(size));
+    if (size_class != s_class_count)
+        return m_free_lists[size_class];
+
+    // only the class of the requested size may still have a block that fits
+    for (BlockIndex index = m_free_lists[s_getSizeClass(size)]; index != s_no_block; index = m_blocks[index].next_free)
+        if (m_blocks[index].size >= size)
+            return index;
+
+    return s_no_block;
+}
+
+void AllocationRegistry::m_insertFreeBlock(BlockIndex index) noexcept
+{
+    Block &block = m_blocks[index];
+    const std::size_t size_class = s_getSizeClass(block.size);
+
+    block.is_free = true;
+    block.prev_free = s_no_block;
+    block.next_free = m_free_lists[size_class];
+
+    if (block.next_free != s_no_block)
+        m_blocks[block.next_free].prev_free = index;
+
+    m_free_lists[size_class] = index;
+    m_free_block_count++;
+
+    const std::size_t group = size_class / s_class_subdivisions;
+    m_class_bitmaps[group] |= std::uint8_t(1) << (size_class % s_class_subdivisions);
+    m_group_bitmap |= std::uint64_t(1) << group;
+}
+
+void AllocationRegistry::m_removeFreeBlock(BlockIndex index) noexcept
+{
+    Block &block = m_blocks[index];
+    const std::size_t size_class = s_getSizeClass(block.size);
+
+    if (block.prev_free != s_no_block)
+        m_blocks[block.prev_free].next_free = block.next_free;
+    else
+        m_free_lists[size_class] = block.next_free;
+
+    if (block.next_free != s_no_block)
+        m_blocks[block.next_free].prev_free = block.prev_free;
+
+    block.is_free = false;
+    block.prev_free = block.next_free = s_no_block;
+    m_free_block_count--;
+
+    if (m_free_lists[size_class] == s_no_block)
     {
-        if (iter->getSize() == size)
-        {
-            iter->setIsFree(false);
-            return offset;
-        }
+        const std::size_t group = size_class / s_class_subdivisions;
+        m_class_bitmaps[group] &= ~(std::uint8_t(1) << (size_class % s_class_subdivisions));
+        if (!m_class_bitmaps[group])
+            m_group_bitmap &= ~(std::uint64_t(1) << group);
+    }
+}
 
-        *iter = {iter->getSize() - size, true};
+auto AllocationRegistry::m_createBlock(const Block &block) -> BlockIndex
+{
+    if (!m_unused_blocks.empty())
+    {
+        const BlockIndex index = m_unused_blocks.back();
+        m_unused_blocks.pop_back();
+        m_blocks[index] = block;
+        return index;
     }
-    else if (m_size - offset < size)
+
+    m_blocks.push_back(block);
+
+    // merging releases at most one slot for each block created, so pushing released slots never allocates
+    m_unused_blocks.reserve(m_blocks.capacity());
+
+    return static_cast<BlockIndex>(m_blocks.size() - 1);
+}
+
+void AllocationRegistry::m_mergeWithNext(BlockIndex index, BlockIndex next) noexcept
+{
+    Block &block = m_blocks[index];
+    const Block &next_block = m_blocks[next];
+
+    block.size += next_block.size;
+    block.next_physical = next_block.next_physical;
+
+    if (block.next_physical != s_no_block)
+        m_blocks[block.next_physical].prev_physical = index;
+
+    // capacity was reserved when the block was created, so this can't throw
+    m_unused_blocks.push_back(next);
+}
+
+auto AllocationRegistry::tryAllocate(AllocationRegistry::uintptr size) -> std::optional<uintptr>
+{
+    // every allocation takes at least one byte, so that each one has a distinct offset
+    size = std::max<uintptr>(size, 1);
+
+    const BlockIndex index = m_findFreeBlock(size);
+    if (index == s_no_block)
         return {};
 
-    m_blocks.insert(iter, {size, false});
+    m_removeFreeBlock(index);
+
+    // the allocation takes the start of the block, and the rest remains free
+    if (m_blocks[index].size > size)
+    {
+        const Block &block = m_blocks[index];
+        Block remainder{block.offset + size, block.size - size};
+        remainder.prev_physical = index;
+        remainder.next_physical = block.next_physical;
+
+        const BlockIndex remainder_index = m_createBlock(remainder);
+
+        // m_blocks may have been reallocated
+        if (remainder.next_physical != s_no_block)
+            m_blocks[remainder.next_physical].prev_physical = remainder_index;
+
+        m_blocks[index].next_physical = remainder_index;
+        m_blocks[index].size = size;
+
+        m_insertFreeBlock(remainder_index);
+    }
+
+    const uintptr offset = m_blocks[index].offset;
+    m_used_blocks.emplace(offset, index);
+    m_free_bytes -= size;
 
     return offset;
 }
@@ -50,21 +243,33 @@ auto AllocationRegistry::allocate(uintptr size) -> uintptr
 
 bool AllocationRegistry::tryDeallocate(AllocationRegistry::uintptr offset) noexcept
 {
-    uintptr acc_offset = 0;
-    auto iter = m_blocks.begin();
+    const auto iter = m_used_blocks.find(offset);
+    if (iter == m_used_blocks.end())
+        return false;
+
+    BlockIndex index = iter->second;
+    m_used_blocks.erase(iter);
+    m_free_bytes += m_blocks[index].size;
 
-    while (iter != m_blocks.end())
+    // merge with free neighbours, so that free space doesn't stay split into blocks as small as past allocations
+    const BlockIndex next = m_blocks[index].next_physical;
+    if (next != s_no_block && m_blocks[next].is_free)
     {
-        if (acc_offset == offset)
-        {
-            iter->setIsFree(true);
-            return true;
-        }
+        m_removeFreeBlock(next);
+        m_mergeWithNext(index, next);
+    }
 
-        acc_offset += iter++->getSize();
+    const BlockIndex prev = m_blocks[index].prev_physical;
+    if (prev != s_no_block && m_blocks[prev].is_free)
+    {
+        m_removeFreeBlock(prev);
+        m_mergeWithNext(prev, index);
+        index = prev;
     }
 
-    return false;
+    m_insertFreeBlock(index);
+
+    return true;
 }
 
 void AllocationRegistry::deallocate(uintptr offset)
@@ -74,18 +279,89 @@ void AllocationRegistry::deallocate(uintptr offset)
         throw std::logic_error("allocation registry: invalid deallocation offset");
 }
 
-AllocationRegistry::uintptr AllocationRegistry::getMaxAllocation() const noexcept
+auto AllocationRegistry::tryMoveDown(uintptr offset) -> std::optional<uintptr>
 {
-    uintptr max_free_block_size = 0;
-    uintptr block_size_sum = 0;
-    for (const auto& block : m_blocks)
+    if (!canMoveDown(offset))
+        return {};
+
+    const auto iter = m_used_blocks.find(offset);
+    const BlockIndex index = iter->second;
+    const BlockIndex prev = m_blocks[index].prev_physical;
+
+    // swap the block with its free predecessor; the size of the free block, and so its size class, doesn't change
+    Block &block = m_blocks[index];
+    Block &free_block = m_blocks[prev];
+
+    const BlockIndex before = free_block.prev_physical;
+    const BlockIndex after = block.next_physical;
+
+    block.offset = free_block.offset;
+    free_block.offset = block.offset + block.size;
+
+    block.prev_physical = before;
+    block.next_physical = prev;
+    free_block.prev_physical = index;
+    free_block.next_physical = after;
+
+    if (before != s_no_block)
+        m_blocks[before].next_physical = index;
+    if (after != s_no_block)
+        m_blocks[after].prev_physical = prev;
+
+    auto node = m_used_blocks.extract(iter);
+    node.key() = block.offset;
+    m_used_blocks.insert(std::move(node));
+
+    if (after != s_no_block && m_blocks[after].is_free)
     {
-        const auto size = block.getSize();
-        block_size_sum += size;
-        if (size > max_free_block_size)
-            max_free_block_size = size;
+        m_removeFreeBlock(prev);
+        m_removeFreeBlock(after);
+        m_mergeWithNext(prev, after);
+        m_insertFreeBlock(prev);
     }
-    return std::max(max_free_block_size, m_size - block_size_sum);
+
+    return m_blocks[index].offset;
+}
+
+bool AllocationRegistry::canMoveDown(uintptr offset) const noexcept
+{
+    const auto iter = m_used_blocks.find(offset);
+    if (iter == m_used_blocks.end())
+        return false;
+
+    const BlockIndex prev = m_blocks[iter->second].prev_physical;
+    return prev != s_no_block && m_blocks[prev].is_free;
+}
+
+AllocationRegistry::uintptr AllocationRegistry::getMaxAllocation() const noexcept
+{
+    if (!m_group_bitmap)
+        return 0;
+
+    // the biggest block is in the highest non-empty class; blocks within a class differ in size
+    const unsigned group = floorLog2(m_group_bitmap);
+    const std::size_t size_class = group * s_class_subdivisions + floorLog2(m_class_bitmaps[group]);
+
+    uintptr max_size = 0;
+    for (BlockIndex index = m_free_lists[size_class]; index != s_no_block; index = m_blocks[index].next_free)
+        max_size = std::max(max_size, m_blocks[index].size);
+
+    return max_size;
+}
+
+AllocationRegistry::FragmentationReport AllocationRegistry::getFragmentationReport() const noexcept
+{
+    FragmentationReport report;
+    report.free_bytes = m_free_bytes;
+    report.largest_free_block = getMaxAllocation();
+    report.free_block_count = m_free_block_count;
+    report.used_block_count = m_used_blocks.size();
+
+    if (m_free_bytes > 0)
+        report.external_fragmentation = 1.0 - static_cast<double>(report.largest_free_block)
+                                              / static_cast<double>(m_free_bytes);
+
+    return report;
 }
 
-} // simple
\ No newline at end of file
+} // simple
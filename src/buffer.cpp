@@ -4,12 +4,55 @@
 
 namespace Simple::Renderer {
 
-Buffer::Buffer(Buffer::size_t size, const void *data) : m_buffer(), m_size(m_buffer ? size : 0)
+Buffer::Buffer(Buffer::size_t size, const void *data, MemoryCategory category)
+        : m_buffer(), m_size(m_buffer ? size : 0)
 {
     if (!m_buffer)
         throw std::runtime_error("GL buffer object creation failed");
 
     m_buffer.allocateImmutable(static_cast<GLsizeiptr>(size), GL::Buffer::StorageFlags::none, data);
+    m_memory = TrackedMemory(category, size);
+}
+
+Buffer::Buffer(Buffer::size_t size, const Initializer &initializer, MemoryCategory category)
+        : m_buffer(), m_size(m_buffer ? size : 0)
+{
+    if (!m_buffer)
+        throw std::runtime_error("GL buffer object creation failed");
+
+    m_buffer.allocateImmutable(static_cast<GLsizeiptr>(size), GL::Buffer::StorageFlags::map_write);
+    m_memory = TrackedMemory(category, size);
+
+    if (size == 0)
+        return;
+
+    // the storage is new, so invalidating it lets the driver hand out memory without waiting or copying
+    auto *data = static_cast<std::byte *>(glMapNamedBufferRange(m_buffer.getName(), 0, static_cast<GLsizeiptr>(size),
+                                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!data)
+        throw std::runtime_error("GL buffer mapping failed");
+
+    try
+    {
+        initializer(data);
+    }
+    catch (...)
+    {
+        glUnmapNamedBuffer(m_buffer.getName());
+        throw;
+    }
+
+    if (glUnmapNamedBuffer(m_buffer.getName()) == GL_FALSE)
+        throw std::runtime_error("GL buffer contents were lost while mapped");
+}
+
+TrackedMemory Buffer::splitTrackedMemory(MemoryCategory category, size_t size)
+{
+    if (size > m_memory.getSize())
+        throw std::logic_error("attempt to split more memory than the buffer has");
+
+    m_memory.resize(m_memory.getSize() - size);
+    return {category, size};
 }
 
 template<>
@@ -1,6 +1,8 @@
 #include "simple_renderer/camera.hpp"
 
 #include "simple_renderer/glsl_definitions.hpp"
+#include "simple_renderer/state_cache.hpp"
+#include "simple_renderer/stream_buffer.hpp"
 #include "glutils/gl.hpp"
 
 #include "glm/gtc/type_ptr.hpp"
@@ -15,21 +17,55 @@ Camera::Camera()
 {
     std::array init_data{glm::mat4(1.0f), glm::mat4(1.0f)};
     m_buffer.allocateImmutable(2 * mat4_size, GL::BufferHandle::StorageFlags::dynamic_storage, init_data.data());
+    m_memory = TrackedMemory(MemoryCategory::uniform, 2 * mat4_size);
 }
 
-void Camera::setViewMatrix(const glm::mat4 &matrix) const
+Camera &Camera::operator=(Camera &&other) noexcept
 {
+    if (this != &other)
+    {
+        StateCache::get().forgetBuffer(m_buffer.getName());
+        m_buffer = std::move(other.m_buffer);
+        m_memory = std::move(other.m_memory);
+        m_view_matrix = other.m_view_matrix;
+        m_projection_matrix = other.m_projection_matrix;
+    }
+
+    return *this;
+}
+
+Camera::~Camera()
+{
+    StateCache::get().forgetBuffer(m_buffer.getName());
+}
+
+void Camera::setViewMatrix(const glm::mat4 &matrix)
+{
+    m_view_matrix = matrix;
     m_buffer.write(view_matrix_block_index * mat4_size, mat4_size, glm::value_ptr(matrix));
 }
 
-void Camera::setProjectionMatrix(const glm::mat4 &matrix) const
+void Camera::setProjectionMatrix(const glm::mat4 &matrix)
 {
+    m_projection_matrix = matrix;
     m_buffer.write(proj_matrix_block_index * mat4_size, mat4_size, glm::value_ptr(matrix));
 }
 
+void Camera::setViewMatrix(const glm::mat4 &matrix, StreamBuffer &stream_buffer)
+{
+    m_view_matrix = matrix;
+    stream_buffer.upload({m_buffer, view_matrix_block_index * mat4_size, mat4_size}, glm::value_ptr(matrix));
+}
+
+void Camera::setProjectionMatrix(const glm::mat4 &matrix, StreamBuffer &stream_buffer)
+{
+    m_projection_matrix = matrix;
+    stream_buffer.upload({m_buffer, proj_matrix_block_index * mat4_size, mat4_size}, glm::value_ptr(matrix));
+}
+
 void Camera::bindUniformBlock() const
 {
-    glBindBufferBase(GL_UNIFORM_BUFFER, camera_uniform_block_def.layout.binding, m_buffer.getName());
+    StateCache::get().bindBufferBase(GL_UNIFORM_BUFFER, camera_uniform_block_def.layout.binding, m_buffer.getName());
 }
 
 } // Simple::Renderer
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "simple_renderer/command_sequence.hpp"
+
+#include "simple_renderer/glsl_definitions.hpp"
+#include "simple_renderer/state_cache.hpp"
+
+#include "glutils/gl.hpp"
+
+#include <type_traits>
+
+namespace Simple::Renderer {
+
+constexpr std::uint8_t draw_arrays_type_index = command_type_tag<DrawArraysCommand>;
+constexpr std::uint8_t draw_elements_type_index = command_type_tag<DrawElementsCommand>;
+constexpr std::uint8_t draw_elements_base_vertex_type_index = command_type_tag<DrawElementsBaseVertexCommand>;
+
+/// Only non-instanced commands may be batched, since the base instance is used to index the model matrix.
+static bool isIndirectBatchable(std::uint8_t command_type)
+{
+    return command_type == draw_arrays_type_index || command_type == draw_elements_type_index
+           || command_type == draw_elements_base_vertex_type_index;
+}
+
+/// Batchable commands which derive from DrawElementsCommand, and are submitted with glMultiDrawElementsIndirect.
+static bool isIndexed(std::uint8_t command_type)
+{
+    return command_type == draw_elements_type_index || command_type == draw_elements_base_vertex_type_index;
+}
+
+template<typename Entry>
+static bool canShareIndirectBatch(const Entry &l, const Entry &r)
+{
+    if (l.program != r.program || l.vertex_array != r.vertex_array || l.command_type != r.command_type
+        || l.command->mode != r.command->mode)
+        return false;
+
+    if (isIndexed(l.command_type))
+        return static_cast<const DrawElementsCommand *>(l.command)->type
+               == static_cast<const DrawElementsCommand *>(r.command)->type;
+
+    return true;
+}
+
+CommandSequence::~CommandSequence()
+{
+    StateCache::get().forgetBuffer(m_indirect_buffer.getName());
+}
+
+void CommandSequence::push(std::uint64_t key, const Entry &entry)
+{
+    m_sort_items.push_back({key, static_cast<std::uint32_t>(m_entries.size())});
+    m_entries.push_back(entry);
+}
+
+void CommandSequence::clear()
+{
+    m_entries.clear();
+    m_sort_items.clear();
+    m_clearIndirectBatches();
+}
+
+void CommandSequence::sort()
+{
+    radixSort(m_sort_items, m_sort_scratch);
+    m_clearIndirectBatches();
+}
+
+void CommandSequence::m_clearIndirectBatches()
+{
+    m_indirect_batches_built = false;
+    m_indirect_batches.clear();
+    m_elements_records.clear();
+    m_arrays_records.clear();
+}
+
+void CommandSequence::buildIndirectBatches()
+{
+    if (m_indirect_batches_built)
+        return;
+
+    m_indirect_batches_built = true;
+
+    const std::size_t item_count = m_sort_items.size();
+
+    for (std::size_t first = 0; first < item_count;)
+    {
+        const Entry &first_entry = m_entries[m_sort_items[first].payload];
+
+        std::size_t last = first + 1;
+
+        if (isIndirectBatchable(first_entry.command_type))
+            while (last < item_count && canShareIndirectBatch(first_entry, m_entries[m_sort_items[last].payload]))
+                last++;
+
+        // a single command is cheaper to submit directly
+        if (last - first < 2)
+        {
+            first = last;
+            continue;
+        }
+
+        const bool indexed = isIndexed(first_entry.command_type);
+        m_indirect_batches.push_back({first, last - first,
+                                      indexed ? m_elements_records.size() : m_arrays_records.size(),
+                                      indexed});
+
+        for (; first < last; first++)
+        {
+            const Entry &entry = m_entries[m_sort_items[first].payload];
+
+            if (indexed)
+            {
+                const auto &command = *static_cast<const DrawElementsCommand *>(entry.command);
+                const std::int32_t base_vertex = entry.command_type == draw_elements_base_vertex_type_index
+                        ? static_cast<const DrawElementsBaseVertexCommand &>(command).base_vertex : 0;
+
+                m_elements_records.push_back({command.count, 1,
+                                              static_cast<std::uint32_t>(command.offset
+                                                                         / getIndexTypeSize(command.type)),
+                                              base_vertex, entry.uniform_index});
+            }
+            else
+            {
+                const auto &command = *static_cast<const DrawArraysCommand *>(entry.command);
+                m_arrays_records.push_back({command.count, 1, command.first, entry.uniform_index});
+            }
+        }
+    }
+
+    if (m_indirect_batches.empty())
+        return;
+
+    // elements records go first, followed by arrays records
+    const auto elements_size = static_cast<GLsizeiptr>(m_elements_records.size() * sizeof(DrawElementsIndirectRecord));
+    const auto arrays_size = static_cast<GLsizeiptr>(m_arrays_records.size() * sizeof(DrawArraysIndirectRecord));
+
+    glNamedBufferData(m_indirect_buffer.getName(), elements_size + arrays_size, nullptr, GL_STREAM_DRAW);
+    glNamedBufferSubData(m_indirect_buffer.getName(), 0, elements_size, m_elements_records.data());
+    glNamedBufferSubData(m_indirect_buffer.getName(), elements_size, arrays_size, m_arrays_records.data());
+}
+
+void CommandSequence::m_executeIndirectBatch(const IndirectBatch &batch) const
+{
+    const DrawCommand &first_command = *m_entries[m_sort_items[batch.first_item].payload].command;
+    const auto mode = static_cast<GLenum>(first_command.mode);
+    const auto draw_count = static_cast<GLsizei>(batch.item_count);
+
+    if (batch.indexed)
+    {
+        const auto type = static_cast<GLenum>(static_cast<const DrawElementsCommand &>(first_command).type);
+        const std::uintptr_t offset = batch.first_record * sizeof(DrawElementsIndirectRecord);
+        glMultiDrawElementsIndirect(mode, type, reinterpret_cast<const void *>(offset), draw_count, 0);
+    }
+    else
+    {
+        const std::uintptr_t offset = m_elements_records.size() * sizeof(DrawElementsIndirectRecord)
+                                      + batch.first_record * sizeof(DrawArraysIndirectRecord);
+        glMultiDrawArraysIndirect(mode, reinterpret_cast<const void *>(offset), draw_count, 0);
+    }
+}
+
+void CommandSequence::execute(bool use_indirect_batches) const
+{
+    const bool has_indirect_batches = use_indirect_batches && !m_indirect_batches.empty();
+
+    if (has_indirect_batches)
+        StateCache::get().bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirect_buffer.getName());
+
+    GL::ProgramHandle bound_program{};
+    GL::VertexArrayHandle bound_vertex_array{};
+    constexpr std::uint32_t unknown_index = -1u;
+    std::uint32_t bound_index{unknown_index};
+
+    const auto set_model_matrix_index = [&bound_index](std::uint32_t index)
+    {
+        if (index != bound_index)
+        {
+            glUniform1ui(model_matrix_index_location, index);
+            bound_index = index;
+        }
+    };
+
+    auto next_batch = m_indirect_batches.cbegin();
+    const auto batches_end = has_indirect_batches ? m_indirect_batches.cend() : m_indirect_batches.cbegin();
+
+    // iterate over commands in sequence, changing gl state when necessary
+    for (std::size_t i = 0; i < m_sort_items.size();)
+    {
+        const auto &[program, vertex_array, uniform_index, command_type, command] = m_entries[m_sort_items[i].payload];
+
+        if (program != bound_program)
+        {
+            program.use();
+            bound_program = program;
+            bound_index = unknown_index; // uniform values are per program
+        }
+
+        if (vertex_array != bound_vertex_array)
+        {
+            vertex_array.bind();
+            bound_vertex_array = vertex_array;
+        }
+
+        if (next_batch != batches_end && next_batch->first_item == i)
+        {
+            // each record's base instance holds its model matrix index
+            set_model_matrix_index(0);
+            m_executeIndirectBatch(*next_batch);
+            i += next_batch->item_count;
+            ++next_batch;
+            continue;
+        }
+
+        // dispatch on the type tag, so that commands are invoked without a virtual call
+        RendererCommandSet::visit(command_type, [&](auto type_tag)
+        {
+            using Command = typename decltype(type_tag)::Type;
+            const auto &typed_command = static_cast<const Command &>(*command);
+
+            if constexpr (std::is_base_of_v<InstancedDrawCommand, Command>)
+            {
+                set_model_matrix_index(uniform_index);
+                typed_command.Command::operator()();
+            }
+            else
+            {
+                // non-instanced commands pass their model matrix index as the base instance
+                set_model_matrix_index(0);
+                typed_command(uniform_index);
+            }
+        });
+
+        i++;
+    }
+}
+
+} // Simple::Renderer
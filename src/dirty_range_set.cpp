@@ -0,0 +1,55 @@
+#include "simple_renderer/dirty_range_set.hpp"
+
+#include <algorithm>
+
+namespace Simple::Renderer {
+
+void DirtyRangeSet::add(std::size_t begin, std::size_t end)
+{
+    if (begin >= end)
+        return;
+
+    // first range that overlaps or touches the new one, and the first one after all of those
+    const auto first = std::lower_bound(m_ranges.begin(), m_ranges.end(), begin,
+                                        [](const Range &range, std::size_t value) { return range.end < value; });
+    auto last = first;
+    while (last != m_ranges.end() && last->begin <= end)
+        ++last;
+
+    if (first == last)
+    {
+        m_ranges.insert(first, {begin, end});
+        return;
+    }
+
+    first->begin = std::min(first->begin, begin);
+    first->end = std::max(std::prev(last)->end, end);
+    m_ranges.erase(std::next(first), last);
+}
+
+void DirtyRangeSet::coalesce(std::size_t gap)
+{
+    if (m_ranges.empty())
+        return;
+
+    auto merged = m_ranges.begin();
+    for (auto it = std::next(merged); it != m_ranges.end(); ++it)
+    {
+        if (it->begin - merged->end <= gap)
+            merged->end = it->end;
+        else
+            *++merged = *it;
+    }
+
+    m_ranges.erase(std::next(merged), m_ranges.end());
+}
+
+std::size_t DirtyRangeSet::getSize() const noexcept
+{
+    std::size_t size = 0;
+    for (const Range &range: m_ranges)
+        size += range.size();
+    return size;
+}
+
+} // Simple::Renderer
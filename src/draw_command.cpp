@@ -9,11 +9,37 @@ void DrawArraysCommand::operator()() const
     glDrawArrays(static_cast<GLenum>(mode), static_cast<GLint>(first), static_cast<GLint>(count));
 }
 
+void DrawArraysCommand::operator()(std::uint32_t base_instance) const
+{
+    glDrawArraysInstancedBaseInstance(static_cast<GLenum>(mode), static_cast<GLint>(first), static_cast<GLsizei>(count),
+                                      1, static_cast<GLuint>(base_instance));
+}
+
 void DrawElementsCommand::operator()() const
 {
     glDrawElements(static_cast<GLenum>(mode), static_cast<GLint>(count), static_cast<GLenum>(type), reinterpret_cast<void *>(offset));
 }
 
+void DrawElementsCommand::operator()(std::uint32_t base_instance) const
+{
+    glDrawElementsInstancedBaseInstance(static_cast<GLenum>(mode), static_cast<GLsizei>(count),
+                                        static_cast<GLenum>(type), reinterpret_cast<void *>(offset), 1,
+                                        static_cast<GLuint>(base_instance));
+}
+
+void DrawElementsBaseVertexCommand::operator()() const
+{
+    glDrawElementsBaseVertex(static_cast<GLenum>(mode), static_cast<GLsizei>(count), static_cast<GLenum>(type),
+                             reinterpret_cast<void *>(offset), static_cast<GLint>(base_vertex));
+}
+
+void DrawElementsBaseVertexCommand::operator()(std::uint32_t base_instance) const
+{
+    glDrawElementsInstancedBaseVertexBaseInstance(static_cast<GLenum>(mode), static_cast<GLsizei>(count),
+                                                  static_cast<GLenum>(type), reinterpret_cast<void *>(offset), 1,
+                                                  static_cast<GLint>(base_vertex), static_cast<GLuint>(base_instance));
+}
+
 void DrawArraysInstancedCommand::operator()() const
 {
     glDrawArraysInstanced(static_cast<GLenum>(mode), static_cast<GLint>(first), static_cast<GLsizei>(count), static_cast<GLsizei>(instance_count));
@@ -0,0 +1,159 @@
+#include "simple_renderer/dynamic_vertex_buffer.hpp"
+
+#include "simple_renderer/state_cache.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Simple::Renderer {
+
+DynamicBuffer::~DynamicBuffer()
+{
+    StateCache::get().forgetBuffer(m_buffer.getName());
+}
+
+void DynamicBuffer::reserve(size_t capacity)
+{
+    if (capacity <= m_capacity)
+        return;
+
+    GL::Buffer buffer;
+    if (!buffer)
+        throw std::runtime_error("GL buffer object creation failed");
+
+    glNamedBufferStorage(buffer.getName(), static_cast<GLsizeiptr>(capacity), nullptr, GL_MAP_WRITE_BIT);
+
+    if (m_size > 0)
+        GL::Buffer::copy(m_buffer, buffer, 0, 0, static_cast<GLsizeiptr>(m_size));
+
+    StateCache::get().forgetBuffer(m_buffer.getName());
+    m_buffer = std::move(buffer);
+    m_capacity = capacity;
+    m_memory.resize(capacity);
+
+    for (const Binding &binding: m_bindings)
+        m_bind(binding);
+}
+
+auto DynamicBuffer::append(size_t size, const Buffer::Initializer &initializer) -> size_t
+{
+    if (m_size + size > m_capacity)
+        reserve(std::max(m_size + size, m_capacity * 2));
+
+    const size_t offset = m_size;
+    m_write(offset, size, initializer);
+    m_size += size;
+
+    return offset;
+}
+
+void DynamicBuffer::update(size_t offset, size_t size, const Buffer::Initializer &initializer)
+{
+    if (offset + size > m_size)
+        throw std::logic_error("dynamic buffer update out of range");
+
+    m_write(offset, size, initializer);
+}
+
+void DynamicBuffer::erase(size_t offset, size_t size)
+{
+    if (offset + size > m_size)
+        throw std::logic_error("dynamic buffer erase out of range");
+
+    if (size == 0)
+        return;
+
+    const size_t tail_offset = offset + size;
+    const size_t tail_size = m_size - tail_offset;
+
+    // copies within a buffer must not overlap, so the tail either moves in chunks no bigger than the gap, or goes
+    // through a temporary buffer when that would take too many copies.
+    if (tail_size <= size * 2)
+    {
+        for (size_t from = tail_offset; from < m_size; from += size)
+            GL::Buffer::copy(m_buffer, m_buffer, static_cast<GLintptr>(from), static_cast<GLintptr>(from - size),
+                             static_cast<GLsizeiptr>(std::min(size, m_size - from)));
+    }
+    else
+    {
+        GL::Buffer temporary;
+        glNamedBufferStorage(temporary.getName(), static_cast<GLsizeiptr>(tail_size), nullptr, 0);
+
+        GL::Buffer::copy(m_buffer, temporary, static_cast<GLintptr>(tail_offset), 0,
+                         static_cast<GLsizeiptr>(tail_size));
+        GL::Buffer::copy(temporary, m_buffer, 0, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(tail_size));
+    }
+
+    m_size -= size;
+}
+
+void DynamicBuffer::bindVertexBuffer(const VertexArray &vertex_array, BufferIndex index, GLsizei stride)
+{
+    const Binding binding{vertex_array.getGLObject().getName(), index.value(), stride, false};
+
+    const auto it = std::find_if(m_bindings.begin(), m_bindings.end(), [&binding](const Binding &b)
+    { return b.vertex_array == binding.vertex_array && !b.element_buffer && b.index == binding.index; });
+
+    if (it != m_bindings.end())
+        *it = binding;
+    else
+        m_bindings.push_back(binding);
+
+    m_bind(binding);
+}
+
+void DynamicBuffer::bindElementBuffer(const VertexArray &vertex_array)
+{
+    const Binding binding{vertex_array.getGLObject().getName(), 0, 0, true};
+
+    const auto it = std::find_if(m_bindings.begin(), m_bindings.end(), [&binding](const Binding &b)
+    { return b.vertex_array == binding.vertex_array && b.element_buffer; });
+
+    if (it == m_bindings.end())
+        m_bindings.push_back(binding);
+
+    m_bind(binding);
+}
+
+void DynamicBuffer::unbindVertexArray(const VertexArray &vertex_array)
+{
+    const GLuint name = vertex_array.getGLObject().getName();
+    m_bindings.erase(std::remove_if(m_bindings.begin(), m_bindings.end(),
+                                    [name](const Binding &b) { return b.vertex_array == name; }),
+                     m_bindings.end());
+}
+
+void DynamicBuffer::m_write(size_t offset, size_t size, const Buffer::Initializer &initializer) const
+{
+    if (size == 0)
+        return;
+
+    auto *data = static_cast<std::byte *>(glMapNamedBufferRange(m_buffer.getName(), static_cast<GLintptr>(offset),
+                                                                static_cast<GLsizeiptr>(size),
+                                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+    if (!data)
+        throw std::runtime_error("GL buffer mapping failed");
+
+    try
+    {
+        initializer(data);
+    }
+    catch (...)
+    {
+        glUnmapNamedBuffer(m_buffer.getName());
+        throw;
+    }
+
+    if (glUnmapNamedBuffer(m_buffer.getName()) == GL_FALSE)
+        throw std::runtime_error("GL buffer contents were lost while mapped");
+}
+
+void DynamicBuffer::m_bind(const Binding &binding) const
+{
+    if (binding.element_buffer)
+        glVertexArrayElementBuffer(binding.vertex_array, m_buffer.getName());
+    else
+        glVertexArrayVertexBuffer(binding.vertex_array, binding.index, m_buffer.getName(), 0, binding.stride);
+}
+
+} // Simple::Renderer
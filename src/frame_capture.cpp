@@ -0,0 +1,724 @@
+#include "simple_renderer/frame_capture.hpp"
+
+#include "simple_renderer/render_queue.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+
+namespace Simple::Renderer {
+
+// file layout: magic, version, camera matrices, then each vector as its size followed by its elements. Structs are
+// written field by field, without padding.
+constexpr std::uint32_t capture_magic = 0x43465253; // "SRFC"
+constexpr std::uint32_t capture_version = 3;
+
+///////////////////////////////////////////// Serialization ////////////////////////////////////////////////////////////
+
+template<typename T>
+static void writeValue(std::ostream &stream, const T &value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+static void readValue(std::istream &stream, T &value)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (!stream.read(reinterpret_cast<char *>(&value), sizeof(T)))
+        throw std::runtime_error("unexpected end of frame capture");
+}
+
+/// Types stored the same in memory and in a capture, so that vectors of them can be written and read in one block.
+template<typename T>
+constexpr bool is_block_serializable = std::is_arithmetic_v<T> || std::is_same_v<T, std::byte>;
+
+/// Vectors of scalars are written in one block; others use the writeElement() overloads below.
+template<typename T>
+static void writeVector(std::ostream &stream, const std::vector<T> &vector)
+{
+    writeValue(stream, static_cast<std::uint64_t>(vector.size()));
+
+    if constexpr (is_block_serializable<T>)
+        stream.write(reinterpret_cast<const char *>(vector.data()),
+                     static_cast<std::streamsize>(vector.size() * sizeof(T)));
+    else
+        for (const T &element: vector)
+            writeElement(stream, element);
+}
+
+template<typename T>
+static void readVector(std::istream &stream, std::vector<T> &vector)
+{
+    std::uint64_t size;
+    readValue(stream, size);
+
+    if constexpr (is_block_serializable<T>)
+    {
+        // grow while reading, so that a corrupt size fails at the end of the stream instead of allocating it all
+        constexpr std::uint64_t chunk_size = (std::uint64_t(1) << 20) / sizeof(T) + 1;
+
+        vector.clear();
+        while (vector.size() < size)
+        {
+            const std::size_t offset = vector.size();
+            const auto count = static_cast<std::size_t>(std::min(size - offset, chunk_size));
+            vector.resize(offset + count);
+
+            if (!stream.read(reinterpret_cast<char *>(vector.data() + offset),
+                             static_cast<std::streamsize>(count * sizeof(T))))
+                throw std::runtime_error("unexpected end of frame capture");
+        }
+    }
+    else
+    {
+        vector.clear();
+        for (std::uint64_t i = 0; i < size; i++)
+            readElement(stream, vector.emplace_back());
+    }
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::Buffer &buffer)
+{
+    writeVector(stream, buffer.data);
+}
+
+static void readElement(std::istream &stream, FrameCapture::Buffer &buffer)
+{
+    readVector(stream, buffer.data);
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::VertexAttribute &attribute)
+{
+    writeValue(stream, attribute.index);
+    writeValue(stream, attribute.binding);
+    writeValue(stream, attribute.relative_offset);
+    writeValue(stream, attribute.size);
+    writeValue(stream, attribute.type);
+    writeValue(stream, attribute.normalized);
+    writeValue(stream, attribute.integer);
+    writeValue(stream, attribute.long_);
+}
+
+static void readElement(std::istream &stream, FrameCapture::VertexAttribute &attribute)
+{
+    readValue(stream, attribute.index);
+    readValue(stream, attribute.binding);
+    readValue(stream, attribute.relative_offset);
+    readValue(stream, attribute.size);
+    readValue(stream, attribute.type);
+    readValue(stream, attribute.normalized);
+    readValue(stream, attribute.integer);
+    readValue(stream, attribute.long_);
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::VertexBufferBinding &binding)
+{
+    writeValue(stream, binding.index);
+    writeValue(stream, binding.buffer);
+    writeValue(stream, binding.offset);
+    writeValue(stream, binding.stride);
+    writeValue(stream, binding.divisor);
+}
+
+static void readElement(std::istream &stream, FrameCapture::VertexBufferBinding &binding)
+{
+    readValue(stream, binding.index);
+    readValue(stream, binding.buffer);
+    readValue(stream, binding.offset);
+    readValue(stream, binding.stride);
+    readValue(stream, binding.divisor);
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::VertexArray &vertex_array)
+{
+    writeVector(stream, vertex_array.attributes);
+    writeVector(stream, vertex_array.bindings);
+    writeValue(stream, vertex_array.element_buffer);
+}
+
+static void readElement(std::istream &stream, FrameCapture::VertexArray &vertex_array)
+{
+    readVector(stream, vertex_array.attributes);
+    readVector(stream, vertex_array.bindings);
+    readValue(stream, vertex_array.element_buffer);
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::Uniform &uniform)
+{
+    writeValue(stream, uniform.location);
+    writeValue(stream, uniform.type);
+    writeVector(stream, uniform.components);
+}
+
+static void readElement(std::istream &stream, FrameCapture::Uniform &uniform)
+{
+    readValue(stream, uniform.location);
+    readValue(stream, uniform.type);
+    readVector(stream, uniform.components);
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::Program &program)
+{
+    writeValue(stream, program.binary_format);
+    writeVector(stream, program.binary);
+    writeVector(stream, program.uniforms);
+}
+
+static void readElement(std::istream &stream, FrameCapture::Program &program)
+{
+    readValue(stream, program.binary_format);
+    readVector(stream, program.binary);
+    readVector(stream, program.uniforms);
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::Draw &draw)
+{
+    writeValue(stream, draw.model_matrix);
+    writeValue(stream, draw.program);
+    writeValue(stream, draw.layer);
+}
+
+static void readElement(std::istream &stream, FrameCapture::Draw &draw)
+{
+    readValue(stream, draw.model_matrix);
+    readValue(stream, draw.program);
+    readValue(stream, draw.layer);
+}
+
+static void writeElement(std::ostream &stream, const FrameCapture::Command &command)
+{
+    writeValue(stream, command.draw);
+    writeValue(stream, command.vertex_array);
+    writeValue(stream, command.command_type);
+    writeValue(stream, command.mode);
+    writeValue(stream, command.first);
+    writeValue(stream, command.count);
+    writeValue(stream, command.index_type);
+    writeValue(stream, command.offset);
+    writeValue(stream, command.instance_count);
+    writeValue(stream, command.base_vertex);
+}
+
+static void readElement(std::istream &stream, FrameCapture::Command &command)
+{
+    readValue(stream, command.draw);
+    readValue(stream, command.vertex_array);
+    readValue(stream, command.command_type);
+    readValue(stream, command.mode);
+    readValue(stream, command.first);
+    readValue(stream, command.count);
+    readValue(stream, command.index_type);
+    readValue(stream, command.offset);
+    readValue(stream, command.instance_count);
+    readValue(stream, command.base_vertex);
+}
+
+void FrameCapture::write(std::ostream &stream) const
+{
+    writeValue(stream, capture_magic);
+    writeValue(stream, capture_version);
+    writeValue(stream, view_matrix);
+    writeValue(stream, projection_matrix);
+    writeVector(stream, buffers);
+    writeVector(stream, vertex_arrays);
+    writeVector(stream, programs);
+    writeVector(stream, draws);
+    writeVector(stream, commands);
+
+    if (!stream)
+        throw std::runtime_error("failed to write frame capture");
+}
+
+FrameCapture FrameCapture::read(std::istream &stream)
+{
+    std::uint32_t magic, version;
+    readValue(stream, magic);
+    readValue(stream, version);
+
+    if (magic != capture_magic)
+        throw std::runtime_error("not a frame capture");
+
+    if (version != capture_version)
+        throw std::runtime_error("unsupported frame capture version");
+
+    FrameCapture capture;
+    readValue(stream, capture.view_matrix);
+    readValue(stream, capture.projection_matrix);
+    readVector(stream, capture.buffers);
+    readVector(stream, capture.vertex_arrays);
+    readVector(stream, capture.programs);
+    readVector(stream, capture.draws);
+    readVector(stream, capture.commands);
+
+    // indices are used to access objects during replay
+    const auto check_index = [](std::size_t index, std::size_t size)
+    {
+        if (index >= size)
+            throw std::runtime_error("invalid object index in frame capture");
+    };
+
+    for (const VertexArray &vertex_array: capture.vertex_arrays)
+    {
+        for (const VertexBufferBinding &binding: vertex_array.bindings)
+            check_index(binding.buffer, capture.buffers.size());
+
+        if (vertex_array.element_buffer != no_buffer)
+            check_index(vertex_array.element_buffer, capture.buffers.size());
+    }
+
+    for (const Draw &draw: capture.draws)
+        check_index(draw.program, capture.programs.size());
+
+    for (const Command &command: capture.commands)
+    {
+        check_index(command.draw, capture.draws.size());
+        check_index(command.vertex_array, capture.vertex_arrays.size());
+        check_index(command.command_type, RendererCommandSet::type_count);
+    }
+
+    return capture;
+}
+
+void FrameCapture::save(const std::string &filename) const
+{
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("could not open " + filename);
+
+    write(file);
+}
+
+FrameCapture FrameCapture::load(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("could not open " + filename);
+
+    return read(file);
+}
+
+///////////////////////////////////////////// Uniform values ///////////////////////////////////////////////////////////
+
+enum class UniformComponentType : std::uint8_t
+{
+    float_,
+    int_,
+    uint_
+};
+
+/// Shape of a default block uniform type, as reported by GL_TYPE.
+struct UniformTypeInfo
+{
+    UniformComponentType component_type;
+    std::uint8_t columns;
+    std::uint8_t rows;
+};
+
+/// Types whose values are captured; double uniforms and images are skipped.
+static std::optional<UniformTypeInfo> getUniformTypeInfo(GLenum type)
+{
+    using C = UniformComponentType;
+
+    switch (type)
+    {
+        case GL_FLOAT: return UniformTypeInfo{C::float_, 1, 1};
+        case GL_FLOAT_VEC2: return UniformTypeInfo{C::float_, 1, 2};
+        case GL_FLOAT_VEC3: return UniformTypeInfo{C::float_, 1, 3};
+        case GL_FLOAT_VEC4: return UniformTypeInfo{C::float_, 1, 4};
+        case GL_FLOAT_MAT2: return UniformTypeInfo{C::float_, 2, 2};
+        case GL_FLOAT_MAT3: return UniformTypeInfo{C::float_, 3, 3};
+        case GL_FLOAT_MAT4: return UniformTypeInfo{C::float_, 4, 4};
+        case GL_FLOAT_MAT2x3: return UniformTypeInfo{C::float_, 2, 3};
+        case GL_FLOAT_MAT2x4: return UniformTypeInfo{C::float_, 2, 4};
+        case GL_FLOAT_MAT3x2: return UniformTypeInfo{C::float_, 3, 2};
+        case GL_FLOAT_MAT3x4: return UniformTypeInfo{C::float_, 3, 4};
+        case GL_FLOAT_MAT4x2: return UniformTypeInfo{C::float_, 4, 2};
+        case GL_FLOAT_MAT4x3: return UniformTypeInfo{C::float_, 4, 3};
+        case GL_INT:
+        case GL_BOOL:
+        case GL_SAMPLER_1D:
+        case GL_SAMPLER_2D:
+        case GL_SAMPLER_3D:
+        case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_2D_SHADOW:
+        case GL_SAMPLER_2D_ARRAY:
+        case GL_SAMPLER_BUFFER:
+        case GL_INT_SAMPLER_2D:
+        case GL_UNSIGNED_INT_SAMPLER_2D:
+            return UniformTypeInfo{C::int_, 1, 1};
+        case GL_INT_VEC2:
+        case GL_BOOL_VEC2:
+            return UniformTypeInfo{C::int_, 1, 2};
+        case GL_INT_VEC3:
+        case GL_BOOL_VEC3:
+            return UniformTypeInfo{C::int_, 1, 3};
+        case GL_INT_VEC4:
+        case GL_BOOL_VEC4:
+            return UniformTypeInfo{C::int_, 1, 4};
+        case GL_UNSIGNED_INT: return UniformTypeInfo{C::uint_, 1, 1};
+        case GL_UNSIGNED_INT_VEC2: return UniformTypeInfo{C::uint_, 1, 2};
+        case GL_UNSIGNED_INT_VEC3: return UniformTypeInfo{C::uint_, 1, 3};
+        case GL_UNSIGNED_INT_VEC4: return UniformTypeInfo{C::uint_, 1, 4};
+        default: return std::nullopt;
+    }
+}
+
+static void readUniform(GLuint program, FrameCapture::Uniform &uniform, const UniformTypeInfo &info)
+{
+    uniform.components.resize(std::size_t(info.columns) * info.rows);
+
+    static_assert(sizeof(GLfloat) == sizeof(std::uint32_t) && sizeof(GLint) == sizeof(std::uint32_t));
+    void *data = uniform.components.data();
+
+    switch (info.component_type)
+    {
+        case UniformComponentType::float_:
+            glGetUniformfv(program, uniform.location, static_cast<GLfloat *>(data));
+            break;
+        case UniformComponentType::int_:
+            glGetUniformiv(program, uniform.location, static_cast<GLint *>(data));
+            break;
+        case UniformComponentType::uint_:
+            glGetUniformuiv(program, uniform.location, static_cast<GLuint *>(data));
+            break;
+    }
+}
+
+static void writeUniform(GLuint program, const FrameCapture::Uniform &uniform)
+{
+    const auto info = getUniformTypeInfo(uniform.type);
+    if (!info || uniform.components.size() != std::size_t(info->columns) * info->rows)
+        throw std::runtime_error("invalid uniform in frame capture");
+
+    const GLint location = uniform.location;
+    const void *data = uniform.components.data();
+    const auto f = static_cast<const GLfloat *>(data);
+    const auto i = static_cast<const GLint *>(data);
+    const auto u = static_cast<const GLuint *>(data);
+
+    if (info->columns > 1)
+    {
+        switch (uniform.type)
+        {
+            case GL_FLOAT_MAT2: glProgramUniformMatrix2fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3: glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4: glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT2x3: glProgramUniformMatrix2x3fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT2x4: glProgramUniformMatrix2x4fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3x2: glProgramUniformMatrix3x2fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3x4: glProgramUniformMatrix3x4fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4x2: glProgramUniformMatrix4x2fv(program, location, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4x3: glProgramUniformMatrix4x3fv(program, location, 1, GL_FALSE, f); break;
+            default: break;
+        }
+        return;
+    }
+
+    switch (info->component_type)
+    {
+        case UniformComponentType::float_:
+            switch (info->rows)
+            {
+                case 1: glProgramUniform1fv(program, location, 1, f); break;
+                case 2: glProgramUniform2fv(program, location, 1, f); break;
+                case 3: glProgramUniform3fv(program, location, 1, f); break;
+                default: glProgramUniform4fv(program, location, 1, f); break;
+            }
+            break;
+        case UniformComponentType::int_:
+            switch (info->rows)
+            {
+                case 1: glProgramUniform1iv(program, location, 1, i); break;
+                case 2: glProgramUniform2iv(program, location, 1, i); break;
+                case 3: glProgramUniform3iv(program, location, 1, i); break;
+                default: glProgramUniform4iv(program, location, 1, i); break;
+            }
+            break;
+        case UniformComponentType::uint_:
+            switch (info->rows)
+            {
+                case 1: glProgramUniform1uiv(program, location, 1, u); break;
+                case 2: glProgramUniform2uiv(program, location, 1, u); break;
+                case 3: glProgramUniform3uiv(program, location, 1, u); break;
+                default: glProgramUniform4uiv(program, location, 1, u); break;
+            }
+            break;
+    }
+}
+
+///////////////////////////////////////////// FrameCaptureWriter ///////////////////////////////////////////////////////
+
+FrameCaptureWriter::FrameCaptureWriter(FrameCapture &capture) : m_capture(capture)
+{
+    m_capture = FrameCapture();
+}
+
+void FrameCaptureWriter::setCamera(const Camera &camera)
+{
+    m_capture.view_matrix = camera.getViewMatrix();
+    m_capture.projection_matrix = camera.getProjectionMatrix();
+}
+
+std::uint32_t FrameCaptureWriter::addDraw(GL::ProgramHandle program, const glm::mat4 &model_matrix,
+                                          std::uint8_t layer)
+{
+    const std::uint32_t program_index = m_captureProgram(program.getName());
+    m_capture.draws.push_back({model_matrix, program_index, layer});
+    return static_cast<std::uint32_t>(m_capture.draws.size() - 1);
+}
+
+std::uint32_t FrameCaptureWriter::m_captureBuffer(GLuint buffer)
+{
+    const auto [iter, inserted] = m_buffer_indices.try_emplace(buffer, m_capture.buffers.size());
+    if (!inserted)
+        return iter->second;
+
+    GLint64 size = 0;
+    glGetNamedBufferParameteri64v(buffer, GL_BUFFER_SIZE, &size);
+
+    std::vector<std::byte> &data = m_capture.buffers.emplace_back().data;
+    data.resize(static_cast<std::size_t>(size));
+    glGetNamedBufferSubData(buffer, 0, static_cast<GLsizeiptr>(size), data.data());
+
+    return iter->second;
+}
+
+std::uint32_t FrameCaptureWriter::m_captureVertexArray(GLuint vertex_array)
+{
+    const auto [iter, inserted] = m_vertex_array_indices.try_emplace(vertex_array, m_capture.vertex_arrays.size());
+    if (!inserted)
+        return iter->second;
+
+    FrameCapture::VertexArray captured;
+
+    GLint max_attributes = 0;
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_attributes);
+
+    for (GLint index = 0; index < max_attributes; index++)
+    {
+        const auto get = [vertex_array, index](GLenum parameter)
+        {
+            GLint value = 0;
+            glGetVertexArrayIndexediv(vertex_array, static_cast<GLuint>(index), parameter, &value);
+            return value;
+        };
+
+        if (!get(GL_VERTEX_ATTRIB_ARRAY_ENABLED))
+            continue;
+
+        captured.attributes.push_back({static_cast<std::uint32_t>(index),
+                                       static_cast<std::uint32_t>(get(GL_VERTEX_ATTRIB_BINDING)),
+                                       static_cast<std::uint32_t>(get(GL_VERTEX_ATTRIB_RELATIVE_OFFSET)),
+                                       get(GL_VERTEX_ATTRIB_ARRAY_SIZE),
+                                       static_cast<std::uint32_t>(get(GL_VERTEX_ATTRIB_ARRAY_TYPE)),
+                                       static_cast<std::uint8_t>(get(GL_VERTEX_ATTRIB_ARRAY_NORMALIZED)),
+                                       static_cast<std::uint8_t>(get(GL_VERTEX_ATTRIB_ARRAY_INTEGER)),
+                                       static_cast<std::uint8_t>(get(GL_VERTEX_ATTRIB_ARRAY_LONG))});
+    }
+
+    for (const FrameCapture::VertexAttribute &attribute: captured.attributes)
+    {
+        const auto is_captured = [&attribute](const FrameCapture::VertexBufferBinding &binding)
+        { return binding.index == attribute.binding; };
+
+        if (std::any_of(captured.bindings.begin(), captured.bindings.end(), is_captured))
+            continue;
+
+        GLint buffer = 0, stride = 0, divisor = 0;
+        GLint64 offset = 0;
+        glGetVertexArrayIndexediv(vertex_array, attribute.binding, GL_VERTEX_BINDING_BUFFER, &buffer);
+        glGetVertexArrayIndexediv(vertex_array, attribute.binding, GL_VERTEX_BINDING_STRIDE, &stride);
+        glGetVertexArrayIndexediv(vertex_array, attribute.binding, GL_VERTEX_BINDING_DIVISOR, &divisor);
+        glGetVertexArrayIndexed64iv(vertex_array, attribute.binding, GL_VERTEX_BINDING_OFFSET, &offset);
+
+        if (buffer == 0)
+            continue;
+
+        captured.bindings.push_back({attribute.binding, m_captureBuffer(static_cast<GLuint>(buffer)),
+                                     static_cast<std::uint64_t>(offset), static_cast<std::uint32_t>(stride),
+                                     static_cast<std::uint32_t>(divisor)});
+    }
+
+    GLint element_buffer = 0;
+    glGetVertexArrayiv(vertex_array, GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_buffer);
+    if (element_buffer != 0)
+        captured.element_buffer = m_captureBuffer(static_cast<GLuint>(element_buffer));
+
+    m_capture.vertex_arrays.push_back(std::move(captured));
+    return iter->second;
+}
+
+std::uint32_t FrameCaptureWriter::m_captureProgram(GLuint program)
+{
+    const auto [iter, inserted] = m_program_indices.try_emplace(program, m_capture.programs.size());
+    if (!inserted)
+        return iter->second;
+
+    FrameCapture::Program captured;
+
+    GLint binary_length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0)
+        throw std::runtime_error("program binary not available; programs must be linked with "
+                                 "GL_PROGRAM_BINARY_RETRIEVABLE_HINT, as ShaderProgram does");
+
+    GLenum binary_format = 0;
+    captured.binary.resize(static_cast<std::size_t>(binary_length));
+    glGetProgramBinary(program, binary_length, &binary_length, &binary_format, captured.binary.data());
+    captured.binary.resize(static_cast<std::size_t>(binary_length));
+    captured.binary_format = binary_format;
+
+    GLint uniform_count = 0;
+    glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniform_count);
+
+    for (GLint index = 0; index < uniform_count; index++)
+    {
+        constexpr std::array<GLenum, 3> properties{GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION};
+        std::array<GLint, properties.size()> values{};
+        glGetProgramResourceiv(program, GL_UNIFORM, static_cast<GLuint>(index), properties.size(), properties.data(),
+                               values.size(), nullptr, values.data());
+
+        const auto [type, array_size, location] = values;
+
+        // block members have no location; their values live in buffers.
+        const auto info = getUniformTypeInfo(static_cast<GLenum>(type));
+        if (location < 0 || !info)
+            continue;
+
+        for (GLint element = 0; element < array_size; element++)
+        {
+            FrameCapture::Uniform &uniform = captured.uniforms.emplace_back();
+            uniform.location = location + element;
+            uniform.type = static_cast<std::uint32_t>(type);
+            readUniform(program, uniform, *info);
+        }
+    }
+
+    m_capture.programs.push_back(std::move(captured));
+    return iter->second;
+}
+
+///////////////////////////////////////////// FrameReplay //////////////////////////////////////////////////////////////
+
+FrameReplay::FrameReplay(const FrameCapture &capture) :
+        m_buffers(capture.buffers.size()),
+        m_vertex_arrays(capture.vertex_arrays.size()),
+        m_programs(capture.programs.size()),
+        m_draws(capture.draws),
+        m_drawables(capture.draws.size())
+{
+    for (std::size_t i = 0; i < capture.buffers.size(); i++)
+    {
+        const std::vector<std::byte> &data = capture.buffers[i].data;
+        glNamedBufferData(m_buffers[i].getName(), static_cast<GLsizeiptr>(data.size()), data.data(), GL_STATIC_DRAW);
+    }
+
+    for (std::size_t i = 0; i < capture.vertex_arrays.size(); i++)
+    {
+        const FrameCapture::VertexArray &captured = capture.vertex_arrays[i];
+        const GLuint vertex_array = m_vertex_arrays[i].getName();
+
+        for (const FrameCapture::VertexBufferBinding &binding: captured.bindings)
+        {
+            glVertexArrayVertexBuffer(vertex_array, binding.index, m_buffers[binding.buffer].getName(),
+                                      static_cast<GLintptr>(binding.offset), static_cast<GLsizei>(binding.stride));
+            glVertexArrayBindingDivisor(vertex_array, binding.index, binding.divisor);
+        }
+
+        for (const FrameCapture::VertexAttribute &attribute: captured.attributes)
+        {
+            const auto type = static_cast<GLenum>(attribute.type);
+
+            if (attribute.long_)
+                glVertexArrayAttribLFormat(vertex_array, attribute.index, attribute.size, type,
+                                           attribute.relative_offset);
+            else if (attribute.integer)
+                glVertexArrayAttribIFormat(vertex_array, attribute.index, attribute.size, type,
+                                           attribute.relative_offset);
+            else
+                glVertexArrayAttribFormat(vertex_array, attribute.index, attribute.size, type,
+                                          attribute.normalized ? GL_TRUE : GL_FALSE, attribute.relative_offset);
+
+            glVertexArrayAttribBinding(vertex_array, attribute.index, attribute.binding);
+            glEnableVertexArrayAttrib(vertex_array, attribute.index);
+        }
+
+        if (captured.element_buffer != FrameCapture::no_buffer)
+            glVertexArrayElementBuffer(vertex_array, m_buffers[captured.element_buffer].getName());
+    }
+
+    for (std::size_t i = 0; i < capture.programs.size(); i++)
+    {
+        const FrameCapture::Program &captured = capture.programs[i];
+        const GLuint program = m_programs[i].getName();
+
+        glProgramBinary(program, static_cast<GLenum>(captured.binary_format), captured.binary.data(),
+                        static_cast<GLsizei>(captured.binary.size()));
+
+        GLint link_status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+        if (link_status == GL_FALSE)
+            throw std::runtime_error("captured program binary was rejected");
+
+        for (const FrameCapture::Uniform &uniform: captured.uniforms)
+            writeUniform(program, uniform);
+    }
+
+    for (CapturedDrawable &drawable: m_drawables)
+        drawable.vertex_arrays = &m_vertex_arrays;
+
+    for (const FrameCapture::Command &command: capture.commands)
+        m_drawables[command.draw].commands.push_back(command);
+
+    m_camera.setViewMatrix(capture.view_matrix);
+    m_camera.setProjectionMatrix(capture.projection_matrix);
+}
+
+void FrameReplay::CapturedDrawable::collectDrawCommands(const CommandCollector &collector) const
+{
+    for (const FrameCapture::Command &captured: commands)
+    {
+        const GL::VertexArrayHandle vertex_array = (*vertex_arrays)[captured.vertex_array];
+        const auto mode = static_cast<DrawMode>(captured.mode);
+        const auto index_type = static_cast<IndexType>(captured.index_type);
+
+        RendererCommandSet::visit(captured.command_type, [&](auto type_tag)
+        {
+            using Command = typename decltype(type_tag)::Type;
+
+            if constexpr (std::is_same_v<Command, DrawArraysCommand>)
+                collector.emplace(Command(mode, captured.first, captured.count), vertex_array);
+            else if constexpr (std::is_same_v<Command, DrawElementsCommand>)
+                collector.emplace(Command(mode, captured.count, index_type, captured.offset), vertex_array);
+            else if constexpr (std::is_same_v<Command, DrawArraysInstancedCommand>)
+                collector.emplace(Command(mode, captured.first, captured.count, captured.instance_count),
+                                  vertex_array);
+            else if constexpr (std::is_same_v<Command, DrawElementsInstancedCommand>)
+                collector.emplace(Command(mode, captured.count, index_type, captured.offset,
+                                          captured.instance_count), vertex_array);
+            else if constexpr (std::is_same_v<Command, DrawElementsBaseVertexCommand>)
+                collector.emplace(Command(mode, captured.count, index_type, captured.offset, captured.base_vertex),
+                                  vertex_array);
+            else
+                static_assert(std::is_void_v<Command>, "command type cannot be replayed");
+        });
+    }
+}
+
+void FrameReplay::draw(RenderQueue &render_queue) const
+{
+    for (std::size_t i = 0; i < m_draws.size(); i++)
+    {
+        const FrameCapture::Draw &draw = m_draws[i];
+        render_queue.m_drawCaptured(m_drawables[i], m_programs[draw.program], draw.model_matrix, draw.layer);
+    }
+}
+
+} // Simple::Renderer
@@ -0,0 +1,114 @@
+#include "simple_renderer/frame_profiler.hpp"
+
+#include <algorithm>
+
+namespace Simple::Renderer {
+
+FrameProfiler::~FrameProfiler()
+{
+    if (m_queries[0] != 0)
+        glDeleteQueries(s_query_count, m_queries.data());
+}
+
+void FrameProfiler::setEnabled(bool enabled)
+{
+    if (enabled && m_queries[0] == 0)
+        glCreateQueries(GL_TIME_ELAPSED, s_query_count, m_queries.data());
+
+    m_enabled = enabled;
+}
+
+void FrameProfiler::beginFrame()
+{
+    if (!m_enabled)
+        return;
+
+    m_frame_start = Clock::now();
+    m_current_stats = {};
+
+    m_collectQueryResults();
+
+    // if every query is still in flight, this frame isn't timed on the GPU rather than waiting for a result
+    if (!m_query_pending[m_next_query])
+    {
+        glBeginQuery(GL_TIME_ELAPSED, m_queries[m_next_query]);
+        m_query_active = true;
+    }
+}
+
+void FrameProfiler::endFrame()
+{
+    if (!m_enabled)
+        return;
+
+    if (m_query_active)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        m_query_pending[m_next_query] = true;
+        m_next_query = (m_next_query + 1) % s_query_count;
+        m_query_active = false;
+    }
+
+    m_current_stats.cpu_ms = s_toMilliseconds(Clock::now() - m_frame_start);
+    m_recordCpuStats(m_current_stats);
+}
+
+void FrameProfiler::m_collectQueryResults()
+{
+    for (std::size_t i = 0; i < s_query_count; i++)
+    {
+        const std::size_t query = (m_next_query + i) % s_query_count;
+
+        if (!m_query_pending[query])
+            continue;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(m_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available == GL_FALSE)
+            break;
+
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(m_queries[query], GL_QUERY_RESULT, &elapsed_ns);
+        m_query_pending[query] = false;
+
+        m_recordGpuTime(static_cast<double>(elapsed_ns) / 1'000'000.0);
+    }
+}
+
+void FrameProfiler::m_recordCpuStats(const FrameStats &stats)
+{
+    FrameStats &oldest = m_cpu_history[m_cpu_history_next];
+
+    for (std::size_t i = 0; i < frame_phase_count; i++)
+        m_history_sum.cpu_phase_ms[i] += stats.cpu_phase_ms[i] - oldest.cpu_phase_ms[i];
+    m_history_sum.cpu_ms += stats.cpu_ms - oldest.cpu_ms;
+
+    oldest = stats;
+    m_cpu_history_next = (m_cpu_history_next + 1) % average_frame_count;
+    m_cpu_history_size = std::min(m_cpu_history_size + 1, average_frame_count);
+
+    const auto count = static_cast<double>(m_cpu_history_size);
+    for (std::size_t i = 0; i < frame_phase_count; i++)
+        m_average_stats.cpu_phase_ms[i] = m_history_sum.cpu_phase_ms[i] / count;
+    m_average_stats.cpu_ms = m_history_sum.cpu_ms / count;
+
+    m_last_stats.cpu_phase_ms = stats.cpu_phase_ms;
+    m_last_stats.cpu_ms = stats.cpu_ms;
+}
+
+void FrameProfiler::m_recordGpuTime(double gpu_ms)
+{
+    double &oldest = m_gpu_history[m_gpu_history_next];
+
+    m_history_sum.gpu_ms += gpu_ms - oldest;
+
+    oldest = gpu_ms;
+    m_gpu_history_next = (m_gpu_history_next + 1) % average_frame_count;
+    m_gpu_history_size = std::min(m_gpu_history_size + 1, average_frame_count);
+
+    m_average_stats.gpu_ms = m_history_sum.gpu_ms / static_cast<double>(m_gpu_history_size);
+    m_last_stats.gpu_ms = gpu_ms;
+}
+
+} // Simple::Renderer
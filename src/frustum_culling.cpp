@@ -0,0 +1,183 @@
+#include "simple_renderer/frustum_culling.hpp"
+
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMPLE_RENDERER_CULL_AVX 1
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SIMPLE_RENDERER_CULL_SSE 1
+#endif
+
+namespace Simple::Renderer {
+
+Frustum Frustum::fromMatrix(const glm::mat4 &matrix)
+{
+    // glm matrices are indexed by column; row i holds the coefficients of the clip space coordinate i.
+    const auto row = [&matrix](int i) { return glm::vec4(matrix[0][i], matrix[1][i], matrix[2][i], matrix[3][i]); };
+
+    const glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+
+    // a point is inside if -w <= x, y, z <= w
+    return {{w + x, w - x, w + y, w - y, w + z, w - z}};
+}
+
+void BoundingBoxArray::push_back(const AxisAlignedBox &box, const glm::mat4 &transform)
+{
+    const glm::vec3 center = box.getCenter();
+    const glm::vec3 extents = box.getExtents();
+
+    // the transformed box is contained in a box with the transformed center and the absolute value of the linear
+    // part of the transform applied to the extents.
+    const glm::vec4 world_center = transform * glm::vec4(center, 1.0f);
+
+    glm::vec3 world_extents{0.0f};
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            world_extents[i] += std::abs(transform[j][i]) * extents[j];
+
+    m_center_x.push_back(world_center.x);
+    m_center_y.push_back(world_center.y);
+    m_center_z.push_back(world_center.z);
+    m_extent_x.push_back(world_extents.x);
+    m_extent_y.push_back(world_extents.y);
+    m_extent_z.push_back(world_extents.z);
+}
+
+void BoundingBoxArray::pushUnbounded()
+{
+    // infinite extents would yield 0 * inf = NaN for planes aligned with an axis
+    constexpr float max = std::numeric_limits<float>::max();
+
+    m_center_x.push_back(0.0f);
+    m_center_y.push_back(0.0f);
+    m_center_z.push_back(0.0f);
+    m_extent_x.push_back(max);
+    m_extent_y.push_back(max);
+    m_extent_z.push_back(max);
+}
+
+void BoundingBoxArray::clear()
+{
+    m_center_x.clear();
+    m_center_y.clear();
+    m_center_z.clear();
+    m_extent_x.clear();
+    m_extent_y.clear();
+    m_extent_z.clear();
+}
+
+std::size_t BoundingBoxArray::cull(const Frustum &frustum, std::vector<std::uint8_t> &visibility) const
+{
+    const std::size_t count = size();
+    visibility.resize(count);
+
+    std::size_t visible_count = 0;
+    std::size_t i = 0;
+
+    // a box is outside if, for some plane, the signed distance of its center plus its projected radius is negative.
+
+#if SIMPLE_RENDERER_CULL_AVX
+    constexpr std::size_t width = 8;
+    const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+    for (; i + width <= count; i += width)
+    {
+        const __m256 cx = _mm256_loadu_ps(m_center_x.data() + i);
+        const __m256 cy = _mm256_loadu_ps(m_center_y.data() + i);
+        const __m256 cz = _mm256_loadu_ps(m_center_z.data() + i);
+        const __m256 ex = _mm256_loadu_ps(m_extent_x.data() + i);
+        const __m256 ey = _mm256_loadu_ps(m_extent_y.data() + i);
+        const __m256 ez = _mm256_loadu_ps(m_extent_z.data() + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (const glm::vec4 &plane: frustum.planes)
+        {
+            const __m256 a = _mm256_set1_ps(plane.x);
+            const __m256 b = _mm256_set1_ps(plane.y);
+            const __m256 c = _mm256_set1_ps(plane.z);
+
+            const __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, cx), _mm256_mul_ps(b, cy)),
+                                                  _mm256_add_ps(_mm256_mul_ps(c, cz), _mm256_set1_ps(plane.w)));
+            const __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(sign_mask, a), ex),
+                                                              _mm256_mul_ps(_mm256_andnot_ps(sign_mask, b), ey)),
+                                                _mm256_mul_ps(_mm256_andnot_ps(sign_mask, c), ez));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), _mm256_setzero_ps(),
+                                                         _CMP_GE_OQ));
+        }
+
+        const int mask = _mm256_movemask_ps(inside);
+        for (std::size_t k = 0; k < width; k++)
+        {
+            const std::uint8_t visible = (mask >> k) & 1;
+            visibility[i + k] = visible;
+            visible_count += visible;
+        }
+    }
+#elif SIMPLE_RENDERER_CULL_SSE
+    constexpr std::size_t width = 4;
+    const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+    for (; i + width <= count; i += width)
+    {
+        const __m128 cx = _mm_loadu_ps(m_center_x.data() + i);
+        const __m128 cy = _mm_loadu_ps(m_center_y.data() + i);
+        const __m128 cz = _mm_loadu_ps(m_center_z.data() + i);
+        const __m128 ex = _mm_loadu_ps(m_extent_x.data() + i);
+        const __m128 ey = _mm_loadu_ps(m_extent_y.data() + i);
+        const __m128 ez = _mm_loadu_ps(m_extent_z.data() + i);
+
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+
+        for (const glm::vec4 &plane: frustum.planes)
+        {
+            const __m128 a = _mm_set1_ps(plane.x);
+            const __m128 b = _mm_set1_ps(plane.y);
+            const __m128 c = _mm_set1_ps(plane.z);
+
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, cx), _mm_mul_ps(b, cy)),
+                                               _mm_add_ps(_mm_mul_ps(c, cz), _mm_set1_ps(plane.w)));
+            const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, a), ex),
+                                                        _mm_mul_ps(_mm_andnot_ps(sign_mask, b), ey)),
+                                             _mm_mul_ps(_mm_andnot_ps(sign_mask, c), ez));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        }
+
+        const int mask = _mm_movemask_ps(inside);
+        for (std::size_t k = 0; k < width; k++)
+        {
+            const std::uint8_t visible = (mask >> k) & 1;
+            visibility[i + k] = visible;
+            visible_count += visible;
+        }
+    }
+#endif
+
+    // remaining boxes, or all of them without SIMD support
+    for (; i < count; i++)
+    {
+        bool inside = true;
+
+        for (const glm::vec4 &plane: frustum.planes)
+        {
+            const float distance = plane.x * m_center_x[i] + plane.y * m_center_y[i] + plane.z * m_center_z[i]
+                                   + plane.w;
+            const float radius = std::abs(plane.x) * m_extent_x[i] + std::abs(plane.y) * m_extent_y[i]
+                                 + std::abs(plane.z) * m_extent_z[i];
+
+            inside = inside && distance + radius >= 0.0f;
+        }
+
+        visibility[i] = inside;
+        visible_count += inside;
+    }
+
+    return visible_count;
+}
+
+} // Simple::Renderer
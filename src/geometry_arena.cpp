@@ -0,0 +1,175 @@
+#include "simple_renderer/geometry_arena.hpp"
+
+#include "simple_renderer/glsl_definitions.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace Simple::Renderer {
+
+/// Write the contents of @p initializer into @p buffer, starting at element @p first.
+template<typename T>
+static void writeElements(const GL::Buffer &buffer, std::uint32_t first, const VertexDataInitializer<T> &initializer)
+{
+    if (!initializer)
+        return;
+
+    std::vector<T> elements(initializer.size());
+    initializer(elements.data());
+    buffer.write(static_cast<GLintptr>(first * sizeof(T)), static_cast<GLsizeiptr>(elements.size() * sizeof(T)),
+                 elements.data());
+}
+
+template<typename T>
+static BufferRange<T> makeElementRange(const GL::Buffer &buffer, std::uint32_t count)
+{
+    return {buffer, {TypedOffset<T>(), count}};
+}
+
+GeometryArena::Page::Page(std::uint8_t format, std::uint32_t vertex_count, std::uint32_t index_count)
+        : format(format), index_capacity(index_count), vertex_registry(vertex_count), index_registry(index_count)
+{
+    constexpr auto storage_flags = GL::Buffer::StorageFlags::dynamic_storage;
+
+    positions.allocateImmutable(static_cast<GLsizeiptr>(vertex_count * sizeof(glm::vec3)), storage_flags);
+    vertex_array.bindVertexBufferAttribute<glm::vec3>(BufferIndex(0),
+                                                      makeElementRange<glm::vec3>(positions, vertex_count),
+                                                      AttribIndex(vertex_position_def.layout.location));
+
+    if (format & has_normals)
+    {
+        normals.allocateImmutable(static_cast<GLsizeiptr>(vertex_count * sizeof(glm::vec3)), storage_flags);
+        vertex_array.bindVertexBufferAttribute<glm::vec3>(BufferIndex(1),
+                                                          makeElementRange<glm::vec3>(normals, vertex_count),
+                                                          AttribIndex(vertex_normal_def.layout.location));
+    }
+
+    if (format & has_uvs)
+    {
+        uvs.allocateImmutable(static_cast<GLsizeiptr>(vertex_count * sizeof(glm::vec2)), storage_flags);
+        vertex_array.bindVertexBufferAttribute<glm::vec2>(BufferIndex(2),
+                                                          makeElementRange<glm::vec2>(uvs, vertex_count),
+                                                          AttribIndex(vertex_uv_def.layout.location));
+    }
+
+    const std::size_t vertex_size = sizeof(glm::vec3) + (format & has_normals ? sizeof(glm::vec3) : 0)
+                                    + (format & has_uvs ? sizeof(glm::vec2) : 0);
+    vertex_memory = TrackedMemory(MemoryCategory::vertex, vertex_count * vertex_size);
+}
+
+void GeometryArena::Page::allocateIndexStorage()
+{
+    if (index_memory.getSize() > 0)
+        return;
+
+    const std::size_t size = index_capacity * sizeof(unsigned int);
+    indices.allocateImmutable(static_cast<GLsizeiptr>(size), GL::Buffer::StorageFlags::dynamic_storage);
+    vertex_array.getGLObject().bindElementBuffer(indices);
+    index_memory = TrackedMemory(MemoryCategory::index, size);
+}
+
+GeometryArena::GeometryArena(std::uint32_t page_vertex_count, std::uint32_t page_index_count)
+        : m_page_vertex_count(page_vertex_count), m_page_index_count(page_index_count)
+{}
+
+std::uint32_t GeometryArena::m_getPage(std::uint8_t format, std::uint32_t vertex_count, std::uint32_t index_count)
+{
+    for (std::size_t i = 0; i < m_pages.size(); i++)
+    {
+        const Page &page = m_pages[i];
+        if (page.format == format && page.vertex_registry.getMaxAllocation() >= vertex_count
+            && (index_count == 0 || page.index_registry.getMaxAllocation() >= index_count))
+            return static_cast<std::uint32_t>(i);
+    }
+
+    m_pages.emplace_back(format, std::max(m_page_vertex_count, vertex_count),
+                         std::max(m_page_index_count, index_count));
+
+    return static_cast<std::uint32_t>(m_pages.size() - 1);
+}
+
+auto GeometryArena::allocate(VertexDataInitializer<glm::vec3> positions, VertexDataInitializer<glm::vec3> normals,
+                             VertexDataInitializer<glm::vec2> uvs, VertexDataInitializer<unsigned int> indices)
+-> Allocation
+{
+    if (!positions)
+        throw std::logic_error("no position data");
+
+    if (normals && positions.size() != normals.size())
+        throw std::logic_error("different number of positions and normals");
+
+    if (uvs && positions.size() != uvs.size())
+        throw std::logic_error("different number of positions and UVs");
+
+    if (positions.size() > std::numeric_limits<std::uint32_t>::max()
+        || indices.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::logic_error("too many vertices or indices for a geometry arena");
+
+    const auto format = static_cast<std::uint8_t>((normals ? has_normals : 0) | (uvs ? has_uvs : 0));
+
+    Allocation allocation;
+    allocation.vertex_count = static_cast<std::uint32_t>(positions.size());
+    allocation.index_count = static_cast<std::uint32_t>(indices.size());
+    allocation.page = m_getPage(format, allocation.vertex_count, allocation.index_count);
+
+    Page &page = m_pages[allocation.page];
+
+    // the page was chosen so that both allocations succeed
+    allocation.first_vertex = static_cast<std::uint32_t>(page.vertex_registry.allocate(allocation.vertex_count));
+    writeElements(page.positions, allocation.first_vertex, positions);
+    writeElements(page.normals, allocation.first_vertex, normals);
+    writeElements(page.uvs, allocation.first_vertex, uvs);
+
+    if (indices)
+    {
+        page.allocateIndexStorage();
+        allocation.first_index = static_cast<std::uint32_t>(page.index_registry.allocate(allocation.index_count));
+        writeElements(page.indices, allocation.first_index, indices);
+    }
+
+    return allocation;
+}
+
+void GeometryArena::deallocate(const Allocation &allocation)
+{
+    Page &page = m_pages.at(allocation.page);
+    page.vertex_registry.deallocate(allocation.first_vertex);
+
+    if (allocation.index_count > 0)
+        page.index_registry.deallocate(allocation.first_index);
+}
+
+/////////////////////////////////////////////////// ArenaMesh //////////////////////////////////////////////////////////
+
+ArenaMesh::ArenaMesh(GeometryArena &arena, VertexDataInitializer<glm::vec3> positions,
+                     VertexDataInitializer<glm::vec3> normals, VertexDataInitializer<glm::vec2> uvs,
+                     VertexDataInitializer<unsigned int> indices)
+        : m_arena(arena), m_allocation(arena.allocate(positions, normals, uvs, indices))
+{
+    constexpr float max = std::numeric_limits<float>::max();
+    AxisAlignedBox bounds{glm::vec3(max), glm::vec3(-max)};
+    positions.forEach([&bounds](const glm::vec3 &position) { bounds.expand(position); });
+    setBounds(bounds);
+}
+
+ArenaMesh::~ArenaMesh()
+{
+    m_arena.deallocate(m_allocation);
+}
+
+void ArenaMesh::collectDrawCommands(const Drawable::CommandCollector &collector) const
+{
+    const auto vertex_array = m_arena.getVertexArray(m_allocation);
+
+    if (isIndexed())
+        collector.emplace(DrawElementsBaseVertexCommand(draw_mode, m_allocation.index_count, IndexType::unsigned_int,
+                                                        m_allocation.first_index * sizeof(unsigned int),
+                                                        static_cast<std::int32_t>(m_allocation.first_vertex)),
+                          vertex_array);
+    else
+        collector.emplace(DrawArraysCommand(draw_mode, m_allocation.first_vertex, m_allocation.vertex_count),
+                          vertex_array);
+}
+
+} // Simple::Renderer
@@ -30,16 +30,44 @@ namespace Simple {
             .name       = "vertex_uv"
     };
 
+    const char *const octahedral_normal_glsl_c_str =
+            "vec3 decode_octahedral_normal(vec2 encoded)\n"
+            "{\n"
+            "    vec3 normal = vec3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));\n"
+            "    float t = max(-normal.z, 0.0f);\n"
+            "    normal.xy += mix(vec2(t), vec2(-t), greaterThanEqual(normal.xy, vec2(0.0f)));\n"
+            "    return normalize(normal);\n"
+            "}\n";
+
     // Uniforms
 
-    const Definition model_matrix_def
-    {
-            .layout     {.location = 0},
-            .storage    = StorageQualifier::uniform,
-            .type       = Type::mat4_,
-            .name       = "model_matrix",
-            .init       {"mat4(1.0f)"}
-    };
+    const GLint model_matrix_index_location = 0;
+    const GLuint model_matrix_block_binding = 0;
+
+    const char *const model_matrix_glsl_c_str =
+            "layout(location = 0) uniform uint model_matrix_index = 0u;\n"
+            "layout(std430, binding = 0) readonly buffer ModelMatrixBlock { mat4 model_matrices[]; };\n"
+            "#ifdef GL_ARB_shader_draw_parameters\n"
+            "#define model_matrix_draw_index (model_matrix_index + uint(gl_BaseInstanceARB))\n"
+            "#else\n"
+            "#define model_matrix_draw_index model_matrix_index\n"
+            "#endif\n"
+            "#define model_matrix (model_matrices[model_matrix_draw_index])\n"
+            "flat out uint model_matrix_varying_index;\n"
+            "#define main user_vertex_main\n";
+
+    const char *const model_matrix_vertex_main_glsl_c_str =
+            "#undef main\n"
+            "void main()\n"
+            "{\n"
+            "    model_matrix_varying_index = model_matrix_draw_index;\n"
+            "    user_vertex_main();\n"
+            "}\n";
+
+    const char *const model_matrix_fragment_glsl_c_str =
+            "layout(std430, binding = 0) readonly buffer ModelMatrixBlock { mat4 model_matrices[]; };\n"
+            "flat in uint model_matrix_varying_index;\n"
+            "#define model_matrix (model_matrices[model_matrix_varying_index])\n";
 
     const BlockDefinition camera_uniform_block_def
     {
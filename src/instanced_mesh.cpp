@@ -14,7 +14,7 @@ void InstancedMesh::collectDrawCommands(const Drawable::CommandCollector &collec
 
 void InstancedMesh::m_resizeInstanceBuffer(std::size_t new_size)
 {
-    VertexBuffer new_buffer{new_size};
+    VertexBuffer new_buffer{new_size, Renderer::MemoryCategory::instance};
 
     for (auto &[handle, data_descriptor]: m_descriptors)
     {
@@ -112,6 +112,14 @@ bool InstancedMesh::isHandleValid(InstanceDataHandle handle) const
     return m_descriptors.find(handle) != m_descriptors.end();
 }
 
+bool InstancedMesh::compactInstanceBuffer(std::size_t byte_budget)
+{
+    return m_instance_buffer.compact(byte_budget, [this](std::uint64_t section_index, std::uint64_t old_offset)
+    {
+        m_getVertexAttributes().rebindSection(m_instance_buffer, m_instance_buffer[section_index], old_offset);
+    });
+}
+
 auto InstancedMesh::m_createHandle() -> InstanceDataHandle
 {
     return static_cast<InstanceDataHandle>(m_next_handle++);
@@ -0,0 +1,69 @@
+#include "simple_renderer/memory_tracker.hpp"
+
+namespace Simple::Renderer {
+
+/// Raise @p peak to @p value if it is lower.
+static void updatePeak(std::atomic<std::size_t> &peak, std::size_t value) noexcept
+{
+    std::size_t current = peak.load(std::memory_order_relaxed);
+    while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed));
+}
+
+MemoryTracker &MemoryTracker::get()
+{
+    static MemoryTracker tracker;
+    return tracker;
+}
+
+void MemoryTracker::allocate(MemoryCategory category, std::size_t size)
+{
+    if (size == 0)
+        return;
+
+    const auto index = static_cast<std::size_t>(category);
+    updatePeak(m_peak_usage[index], m_usage[index].fetch_add(size, std::memory_order_relaxed) + size);
+
+    const std::size_t previous_total = m_total_usage.fetch_add(size, std::memory_order_relaxed);
+    const std::size_t total = previous_total + size;
+    updatePeak(m_peak_total_usage, total);
+
+    const std::size_t budget = getBudget();
+    if (budget == 0 || previous_total > budget || total <= budget)
+        return;
+
+    // the callback is copied so that it runs without holding the lock
+    BudgetCallback callback;
+    {
+        std::lock_guard lock(m_budget_mutex);
+        callback = m_budget_callback;
+    }
+
+    if (callback)
+        callback(total, budget);
+}
+
+void MemoryTracker::deallocate(MemoryCategory category, std::size_t size) noexcept
+{
+    if (size == 0)
+        return;
+
+    m_usage[static_cast<std::size_t>(category)].fetch_sub(size, std::memory_order_relaxed);
+    m_total_usage.fetch_sub(size, std::memory_order_relaxed);
+}
+
+void MemoryTracker::resetPeakUsage() noexcept
+{
+    for (std::size_t i = 0; i < memory_category_count; i++)
+        m_peak_usage[i].store(m_usage[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    m_peak_total_usage.store(getTotalUsage(), std::memory_order_relaxed);
+}
+
+void MemoryTracker::setBudget(std::size_t budget, BudgetCallback callback)
+{
+    std::lock_guard lock(m_budget_mutex);
+    m_budget_callback = std::move(callback);
+    m_budget.store(budget, std::memory_order_relaxed);
+}
+
+} // Simple::Renderer
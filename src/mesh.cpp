@@ -3,6 +3,12 @@
 
 #include "simple_renderer/glsl_definitions.hpp"
 
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
 namespace Simple {
 
 // old implementation
@@ -83,21 +89,62 @@ DrawArraysCommand Mesh::m_createDrawArraysCommand() const
 
 namespace Renderer {
 
-template<typename AttributeType, std::size_t SectionIndex>
-void Mesh::m_bindAttribute(uint attrib_index)
+/// Convert each of @p indices to @p Index and write them to @p data.
+template<typename Index, typename SourceIndex>
+static void writeIndices(const VertexDataInitializer<SourceIndex> &indices, std::byte *data)
 {
-    constexpr BufferIndex buffer_index {SectionIndex};
-    m_vertex_array.bindVertexBufferAttribute<AttributeType>(buffer_index,
-                                                            m_vertex_buffer.getBufferRange<SectionIndex>(),
-                                                            AttribIndex(attrib_index));
-    //m_vertex_array.setVertexBufferInstanceDivisor(buffer_index, 0);
+    auto *dest = reinterpret_cast<Index *>(data);
+
+    if constexpr (std::is_same_v<Index, SourceIndex>)
+        indices(dest);
+    else
+        indices.forEach([&dest](SourceIndex index) { *dest++ = static_cast<Index>(index); });
 }
 
+void IndexDataInitializer::operator()(IndexType type, std::byte *data) const
+{
+    std::visit([type, data](const auto &source)
+               {
+                   switch (type)
+                   {
+                       case IndexType::unsigned_byte:
+                           writeIndices<std::uint8_t>(source, data);
+                           break;
+                       case IndexType::unsigned_short:
+                           writeIndices<std::uint16_t>(source, data);
+                           break;
+                       case IndexType::unsigned_int:
+                           writeIndices<unsigned int>(source, data);
+                           break;
+                   }
+               }, m_source);
+}
+
+/// Position, normal and uv, in the order they are laid out in a mesh's buffer.
+enum PackedAttribute : std::size_t
+{
+    packed_position,
+    packed_normal,
+    packed_uv,
+};
+
+/// Size of each encoded attribute, padded to a multiple of 4 bytes so that every attribute stays aligned.
+static std::size_t getEncodedSize(PositionEncoding encoding)
+{ return encoding == PositionEncoding::snorm16 ? 8 : sizeof(glm::vec3); }
+
+static std::size_t getEncodedSize(NormalEncoding encoding)
+{ return encoding == NormalEncoding::octahedral_snorm16 ? 4 : sizeof(glm::vec3); }
+
+static std::size_t getEncodedSize(UVEncoding encoding)
+{ return encoding == UVEncoding::float32 ? sizeof(glm::vec2) : 4; }
+
 Mesh::Mesh(VertexDataInitializer<glm::vec3> positions, VertexDataInitializer<glm::vec3> normals,
-           VertexDataInitializer<glm::vec2> uvs, VertexDataInitializer<unsigned int> indices)
-        : m_vertex_buffer(positions, normals, uvs, indices),
-          m_index_count(indices.size()),
-          m_use_index_buffer(indices.size() > 0)
+           VertexDataInitializer<glm::vec2> uvs, IndexDataInitializer indices, MeshLayout layout,
+           VertexEncoding encoding)
+        : m_layout(layout),
+          m_encoding(encoding),
+          m_use_index_buffer(indices.size() > 0),
+          m_index_count(indices.size())
 {
     if (!positions.size())
         throw std::logic_error("no position data");
@@ -108,24 +155,36 @@ Mesh::Mesh(VertexDataInitializer<glm::vec3> positions, VertexDataInitializer<glm
     if (uvs.size() != 0 && positions.size() != uvs.size())
         throw std::logic_error("different number of positions and UVs");
 
-    m_bindAttribute<glm::vec3, 0>(vertex_position_def.layout.location);
+    // start from an empty box, since the initializer can only be iterated
+    constexpr float max = std::numeric_limits<float>::max();
+    AxisAlignedBox bounds{glm::vec3(max), glm::vec3(-max)};
+    positions.forEach([&bounds](const glm::vec3 &position) { bounds.expand(position); });
+    setBounds(bounds);
 
-    if (normals)
+    PositionQuantization quantization;
+    if (encoding.position == PositionEncoding::snorm16)
     {
-        m_bindAttribute<glm::vec3, 1>(vertex_normal_def.layout.location);
+        quantization = PositionQuantization::fromBounds(bounds);
+        setVertexTransform(quantization.getDequantizationTransform());
     }
 
-    if (uvs)
-    {
-        m_bindAttribute<glm::vec2, 2>(vertex_uv_def.layout.location);
-    }
+    // valid indices are below the vertex count; 8-bit indices aren't used since many GPUs don't support them natively
+    if (positions.size() <= std::size_t(std::numeric_limits<std::uint16_t>::max()) + 1)
+        m_index_type = IndexType::unsigned_short;
+
+    const PackedLayout packed_layout = m_makePackedLayout(positions.size(), bool(normals), bool(uvs));
+    const std::size_t indices_size = indices.size() * getIndexTypeSize(m_index_type);
+    m_buffer = Buffer(packed_layout.vertices_size + indices_size, [&](std::byte *data)
+                      { m_initializePacked(data, packed_layout, quantization, positions, normals, uvs, indices); });
+    m_index_memory = m_buffer.splitTrackedMemory(MemoryCategory::index, indices_size);
+    m_index_buffer_offset = packed_layout.vertices_size;
+
+    m_bindPackedAttributes(packed_layout, positions.size());
 
-    // indices
     if (m_index_count)
-    {
-        m_vertex_array.bindElementBuffer(m_vertex_buffer.getBuffer());
-    }
-    else
+        m_vertex_array.bindElementBuffer(m_buffer);
+
+    if (!m_index_count)
     {
         m_first_index = 0;
         m_index_count = positions.size();
@@ -140,10 +199,178 @@ void Mesh::collectDrawCommands(const Drawable::CommandCollector &collector) cons
         collector.emplace(m_createDrawArraysCommand(), m_vertex_array.getGLObject());
 }
 
+auto Mesh::m_makePackedLayout(std::size_t vertex_count, bool has_normals, bool has_uvs) const -> PackedLayout
+{
+    // interleaved vertices always hold every attribute, missing ones are zero
+    const bool interleaved = m_layout == MeshLayout::interleaved;
+    const std::array<std::size_t, 3> sizes {getEncodedSize(m_encoding.position),
+                                            interleaved || has_normals ? getEncodedSize(m_encoding.normal) : 0,
+                                            interleaved || has_uvs ? getEncodedSize(m_encoding.uv) : 0};
+
+    PackedLayout layout{};
+    std::size_t offset = 0;
+
+    for (std::size_t i = 0; i < sizes.size(); i++)
+    {
+        layout.offsets[i] = offset;
+        offset += interleaved ? sizes[i] : sizes[i] * vertex_count;
+    }
+
+    if (interleaved)
+    {
+        layout.strides.fill(offset);
+        layout.vertices_size = offset * vertex_count;
+    }
+    else
+    {
+        layout.strides = sizes;
+        layout.vertices_size = offset;
+    }
+
+    return layout;
+}
+
+void Mesh::m_initializePacked(std::byte *data, const PackedLayout &layout, const PositionQuantization &quantization,
+                              const VertexDataInitializer<glm::vec3> &positions,
+                              const VertexDataInitializer<glm::vec3> &normals,
+                              const VertexDataInitializer<glm::vec2> &uvs,
+                              const IndexDataInitializer &indices) const
+{
+    const auto write = [](std::byte *dest, const auto &value) { std::memcpy(dest, &value, sizeof(value)); };
+
+    const auto write_attribute = [&](PackedAttribute attribute, std::size_t vertex)
+    {
+        std::byte *dest = data + layout.offsets[attribute] + vertex * layout.strides[attribute];
+
+        switch (attribute)
+        {
+            case packed_position:
+                if (m_encoding.position == PositionEncoding::snorm16)
+                    write(dest, quantization.encode(positions[vertex]));
+                else
+                    write(dest, positions[vertex]);
+                break;
+
+            case packed_normal:
+                if (!normals)
+                    std::memset(dest, 0, getEncodedSize(m_encoding.normal));
+                else if (m_encoding.normal == NormalEncoding::octahedral_snorm16)
+                    write(dest, encodeOctahedralNormal(normals[vertex]));
+                else
+                    write(dest, normals[vertex]);
+                break;
+
+            case packed_uv:
+                if (!uvs)
+                    std::memset(dest, 0, getEncodedSize(m_encoding.uv));
+                else if (m_encoding.uv == UVEncoding::unorm16)
+                    write(dest, encodeUnorm16(uvs[vertex]));
+                else if (m_encoding.uv == UVEncoding::float16)
+                    write(dest, std::array{encodeHalf(uvs[vertex].x), encodeHalf(uvs[vertex].y)});
+                else
+                    write(dest, uvs[vertex]);
+                break;
+        }
+    };
+
+    // the mapping may be write-combined memory, so the buffer is written in order
+    if (m_layout == MeshLayout::interleaved)
+    {
+        for (std::size_t i = 0; i < positions.size(); i++)
+        {
+            write_attribute(packed_position, i);
+            write_attribute(packed_normal, i);
+            write_attribute(packed_uv, i);
+        }
+    }
+    else
+    {
+        for (const PackedAttribute attribute: {packed_position, packed_normal, packed_uv})
+        {
+            if (layout.strides[attribute] == 0)
+                continue;
+
+            for (std::size_t i = 0; i < positions.size(); i++)
+                write_attribute(attribute, i);
+        }
+    }
+
+    indices(m_index_type, data + layout.vertices_size);
+}
+
+void Mesh::m_bindPackedAttributes(const PackedLayout &layout, std::size_t vertex_count)
+{
+    const bool interleaved = m_layout == MeshLayout::interleaved;
+
+    // interleaved attributes share binding index 0 and are found at their offset within the vertex; planar ones are
+    // each bound to their own index, at the start of their array.
+    const auto bind_buffer = [&](PackedAttribute attribute) -> std::pair<BufferIndex, uint>
+    {
+        const BufferIndex buffer_index{interleaved ? 0 : static_cast<uint>(attribute)};
+        const std::size_t offset = interleaved ? 0 : layout.offsets[attribute];
+        const std::size_t stride = layout.strides[attribute];
+
+        if (!interleaved || attribute == packed_position)
+            m_vertex_array.bindVertexBuffer(buffer_index,
+                                            m_buffer.makeRange(ByteOffset(offset), stride * vertex_count),
+                                            static_cast<uint>(stride));
+
+        return {buffer_index, static_cast<uint>(interleaved ? layout.offsets[attribute] : 0)};
+    };
+
+    {
+        const auto [buffer_index, relative_offset] = bind_buffer(packed_position);
+        const AttribIndex attrib_index(vertex_position_def.layout.location);
+
+        if (m_encoding.position == PositionEncoding::snorm16)
+            m_vertex_array.bindInterleavedAttribute<glm::vec3, glm::vec<3, std::int16_t>>(buffer_index, attrib_index,
+                                                                                         relative_offset, true);
+        else
+            m_vertex_array.bindInterleavedAttribute<glm::vec3, glm::vec3>(buffer_index, attrib_index,
+                                                                          relative_offset);
+    }
+
+    if (layout.strides[packed_normal])
+    {
+        const auto [buffer_index, relative_offset] = bind_buffer(packed_normal);
+        const AttribIndex attrib_index(vertex_normal_def.layout.location);
+
+        // only two components are stored, the shader decodes them
+        if (m_encoding.normal == NormalEncoding::octahedral_snorm16)
+            m_vertex_array.bindInterleavedAttribute<glm::vec2, glm::vec<2, std::int16_t>>(buffer_index, attrib_index,
+                                                                                         relative_offset, true);
+        else
+            m_vertex_array.bindInterleavedAttribute<glm::vec3, glm::vec3>(buffer_index, attrib_index,
+                                                                          relative_offset);
+    }
+
+    if (layout.strides[packed_uv])
+    {
+        const auto [buffer_index, relative_offset] = bind_buffer(packed_uv);
+        const AttribIndex attrib_index(vertex_uv_def.layout.location);
+
+        if (m_encoding.uv == UVEncoding::unorm16)
+        {
+            m_vertex_array.bindInterleavedAttribute<glm::vec2, glm::vec<2, std::uint16_t>>(buffer_index, attrib_index,
+                                                                                          relative_offset, true);
+        }
+        else if (m_encoding.uv == UVEncoding::float16)
+        {
+            m_vertex_array.bindAttribute(attrib_index, buffer_index);
+            m_vertex_array.setAttributeFormat<glm::vec2>(attrib_index, AttribType::_half_float, relative_offset);
+            m_vertex_array.enableAttribute(attrib_index);
+        }
+        else
+        {
+            m_vertex_array.bindInterleavedAttribute<glm::vec2, glm::vec2>(buffer_index, attrib_index,
+                                                                          relative_offset);
+        }
+    }
+}
+
 DrawElementsCommand Mesh::m_createDrawElementsCommand() const
 {
-    return {draw_mode, m_index_count, IndexType::unsigned_int,
-            m_vertex_buffer.getTypedRange<3>().offset.get()};
+    return {draw_mode, m_index_count, m_index_type, m_index_buffer_offset};
 }
 
 DrawArraysCommand Mesh::m_createDrawArraysCommand() const
@@ -0,0 +1,55 @@
+#include "simple_renderer/radix_sort.hpp"
+
+#include <array>
+#include <utility>
+
+namespace Simple::Renderer {
+
+constexpr std::size_t radix_bits = 8;
+constexpr std::size_t radix_size = 1u << radix_bits;
+constexpr std::size_t pass_count = sizeof(SortItem::key) * 8 / radix_bits;
+
+void radixSort(std::vector<SortItem> &items, std::vector<SortItem> &scratch)
+{
+    const std::size_t item_count = items.size();
+
+    if (item_count < 2)
+        return;
+
+    // build the histograms for all passes at once
+    std::array<std::array<std::size_t, radix_size>, pass_count> histograms{};
+
+    for (const SortItem &item: items)
+        for (std::size_t pass = 0; pass < pass_count; pass++)
+            histograms[pass][(item.key >> (pass * radix_bits)) & (radix_size - 1)]++;
+
+    scratch.resize(item_count);
+
+    SortItem *source = items.data();
+    SortItem *destination = scratch.data();
+
+    for (std::size_t pass = 0; pass < pass_count; pass++)
+    {
+        auto &histogram = histograms[pass];
+        const std::size_t shift = pass * radix_bits;
+
+        // all keys have the same digit: this pass would not change the order
+        if (histogram[(source->key >> shift) & (radix_size - 1)] == item_count)
+            continue;
+
+        // exclusive prefix sum: histogram[digit] becomes the index of the first item with that digit
+        std::size_t sum = 0;
+        for (std::size_t &count: histogram)
+            sum += std::exchange(count, sum);
+
+        for (const SortItem *item = source; item != source + item_count; item++)
+            destination[histogram[(item->key >> shift) & (radix_size - 1)]++] = *item;
+
+        std::swap(source, destination);
+    }
+
+    if (source != items.data())
+        items.swap(scratch);
+}
+
+} // Simple::Renderer
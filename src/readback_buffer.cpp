@@ -0,0 +1,180 @@
+#include "simple_renderer/readback_buffer.hpp"
+
+#include "simple_renderer/state_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace Simple::Renderer {
+
+///////////////////////////////////////////////// Readback /////////////////////////////////////////////////////////////
+
+ReadbackBuffer::Readback::Readback(Readback &&other) noexcept
+        : m_owner(std::exchange(other.m_owner, nullptr)), m_id(other.m_id),
+          m_fence(std::exchange(other.m_fence, nullptr)), m_data(other.m_data), m_size(other.m_size)
+{}
+
+auto ReadbackBuffer::Readback::operator=(Readback &&other) noexcept -> Readback &
+{
+    if (this != &other)
+    {
+        m_release();
+        m_owner = std::exchange(other.m_owner, nullptr);
+        m_id = other.m_id;
+        m_fence = std::exchange(other.m_fence, nullptr);
+        m_data = other.m_data;
+        m_size = other.m_size;
+    }
+    return *this;
+}
+
+ReadbackBuffer::Readback::~Readback()
+{
+    m_release();
+}
+
+void ReadbackBuffer::Readback::m_release() noexcept
+{
+    if (m_fence)
+        glDeleteSync(m_fence);
+
+    if (m_owner)
+        m_owner->m_release(m_id);
+
+    m_owner = nullptr;
+    m_fence = nullptr;
+}
+
+bool ReadbackBuffer::Readback::isReady() const
+{
+    if (!m_owner)
+        throw std::logic_error("invalid readback");
+
+    if (!m_fence)
+        return true;
+
+    // the flush makes sure the fence reaches the GPU, so that polling eventually succeeds
+    if (glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    glDeleteSync(m_fence);
+    m_fence = nullptr;
+    return true;
+}
+
+void ReadbackBuffer::Readback::wait() const
+{
+    if (isReady())
+        return;
+
+    constexpr GLuint64 timeout_ns = 1'000'000'000;
+    while (glClientWaitSync(m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns) == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(m_fence);
+    m_fence = nullptr;
+}
+
+const std::byte *ReadbackBuffer::Readback::getData() const
+{
+    wait();
+    return m_data;
+}
+
+void ReadbackBuffer::Readback::read(void *destination) const
+{
+    std::memcpy(destination, getData(), m_size);
+}
+
+///////////////////////////////////////////////// ReadbackBuffer ///////////////////////////////////////////////////////
+
+ReadbackBuffer::ReadbackBuffer(std::size_t capacity)
+        : m_capacity((capacity + s_alignment - 1) / s_alignment * s_alignment)
+{
+    if (m_capacity == 0)
+        throw std::logic_error("a readback buffer needs a non-zero capacity");
+
+    m_buffer = GL::Buffer();
+
+    // client storage hints that the buffer should live in host memory, which the CPU reads fastest
+    constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glNamedBufferStorage(m_buffer.getName(), static_cast<GLsizeiptr>(m_capacity), nullptr,
+                         flags | GL_CLIENT_STORAGE_BIT);
+    m_mapping = static_cast<const std::byte *>(glMapNamedBufferRange(m_buffer.getName(), 0,
+                                                                     static_cast<GLsizeiptr>(m_capacity), flags));
+
+    if (!m_mapping)
+        throw std::runtime_error("readback buffer mapping failed");
+
+    m_memory = TrackedMemory(MemoryCategory::staging, m_capacity);
+}
+
+ReadbackBuffer::~ReadbackBuffer()
+{
+    StateCache::get().forgetBuffer(m_buffer.getName());
+}
+
+auto ReadbackBuffer::tryReadAsync(RBufferRef source) -> std::optional<Readback>
+{
+    const auto offset = m_allocate(source.getSize());
+    if (!offset.has_value())
+        return {};
+
+    source.copyTo(WBufferRef(m_buffer, *offset, source.getSize()));
+
+    const std::uint64_t id = m_first_slot_id + m_slots.size() - 1;
+    return Readback(*this, id, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_mapping + *offset,
+                    source.getSize());
+}
+
+auto ReadbackBuffer::readAsync(RBufferRef source) -> Readback
+{
+    auto readback = tryReadAsync(source);
+    if (!readback.has_value())
+        throw std::logic_error("readback buffer is full");
+    return std::move(*readback);
+}
+
+std::optional<std::size_t> ReadbackBuffer::m_allocate(std::size_t size)
+{
+    size = std::max<std::size_t>((size + s_alignment - 1) / s_alignment * s_alignment, s_alignment);
+
+    if (m_slots.empty())
+        m_head = 0;
+
+    std::size_t offset;
+
+    // free space is [head, capacity) and [0, tail) if the used space doesn't wrap around, [head, tail) if it does
+    const std::size_t tail = m_slots.empty() ? 0 : m_slots.front().offset;
+    if (m_slots.empty() || m_head > tail)
+    {
+        if (m_head + size <= m_capacity)
+            offset = m_head;
+        else if (size <= tail)
+            offset = 0;
+        else
+            return {};
+    }
+    else if (m_head + size <= tail)
+        offset = m_head;
+    else
+        return {};
+
+    m_slots.push_back({offset, size, false});
+    m_head = offset + size;
+    return offset;
+}
+
+void ReadbackBuffer::m_release(std::uint64_t id) noexcept
+{
+    m_slots[static_cast<std::size_t>(id - m_first_slot_id)].released = true;
+
+    while (!m_slots.empty() && m_slots.front().released)
+    {
+        m_slots.pop_front();
+        m_first_slot_id++;
+    }
+}
+
+} // Simple::Renderer
@@ -0,0 +1,179 @@
+#include "simple_renderer/render_list.hpp"
+
+#include "simple_renderer/glsl_definitions.hpp"
+#include "simple_renderer/state_cache.hpp"
+
+#include "glutils/gl.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Simple::Renderer {
+
+RenderList::~RenderList()
+{
+    StateCache::get().forgetBuffer(m_model_matrix_buffer.getName());
+}
+
+RenderList::DrawHandle RenderList::add(const Drawable &drawable, const ShaderProgram &program,
+                                       const glm::mat4 &model_transform, std::uint8_t layer)
+{
+    DrawHandle handle;
+
+    if (m_free_handles.empty())
+    {
+        handle = static_cast<DrawHandle>(m_entries.size());
+        m_entries.emplace_back();
+        m_model_matrices.emplace_back();
+    }
+    else
+    {
+        handle = m_free_handles.back();
+        m_free_handles.pop_back();
+    }
+
+    const auto index = static_cast<std::size_t>(handle);
+
+    Entry &entry = m_entries[index];
+    entry.drawable = &drawable;
+    entry.program = &program;
+    entry.layer = layer;
+    entry.model_transform = model_transform;
+
+    m_model_matrices[index] = drawable.getModelMatrix(model_transform);
+    m_dirty_matrices.push_back(static_cast<std::uint32_t>(index));
+    m_markStale(handle);
+
+    return handle;
+}
+
+void RenderList::remove(DrawHandle handle)
+{
+    Entry &entry = m_getEntry(handle);
+
+    entry.drawable = nullptr;
+    entry.program = nullptr;
+    entry.command_queue.clear();
+
+    m_free_handles.push_back(handle);
+    m_command_sequence_dirty = true;
+}
+
+void RenderList::setTransform(DrawHandle handle, const glm::mat4 &model_transform)
+{
+    Entry &entry = m_getEntry(handle);
+    entry.model_transform = model_transform;
+
+    const auto index = static_cast<std::size_t>(handle);
+    m_model_matrices[index] = entry.drawable->getModelMatrix(model_transform);
+    m_dirty_matrices.push_back(static_cast<std::uint32_t>(index));
+}
+
+void RenderList::setProgram(DrawHandle handle, const ShaderProgram &program)
+{
+    Entry &entry = m_getEntry(handle);
+
+    if (entry.program == &program)
+        return;
+
+    entry.program = &program;
+    m_markStale(handle);
+}
+
+void RenderList::setDrawable(DrawHandle handle, const Drawable &drawable)
+{
+    Entry &entry = m_getEntry(handle);
+
+    if (entry.drawable == &drawable)
+        return;
+
+    entry.drawable = &drawable;
+    m_markStale(handle);
+
+    // the new drawable may have a different vertex transform
+    const auto index = static_cast<std::size_t>(handle);
+    m_model_matrices[index] = drawable.getModelMatrix(entry.model_transform);
+    m_dirty_matrices.push_back(static_cast<std::uint32_t>(index));
+}
+
+void RenderList::setLayer(DrawHandle handle, std::uint8_t layer)
+{
+    Entry &entry = m_getEntry(handle);
+
+    if (entry.layer == layer)
+        return;
+
+    // the commands are unchanged, only their keys
+    entry.layer = layer;
+    m_command_sequence_dirty = true;
+}
+
+void RenderList::invalidate(DrawHandle handle)
+{
+    m_getEntry(handle);
+    m_markStale(handle);
+}
+
+RenderList::Entry &RenderList::m_getEntry(DrawHandle handle)
+{
+    const auto index = static_cast<std::size_t>(handle);
+
+    if (index >= m_entries.size() || !m_entries[index].drawable)
+        throw std::logic_error("invalid handle");
+
+    return m_entries[index];
+}
+
+void RenderList::m_markStale(DrawHandle handle)
+{
+    m_stale_handles.push_back(handle);
+    m_command_sequence_dirty = true;
+}
+
+void RenderList::m_uploadModelMatrices()
+{
+    using UniformData = glm::mat4;
+
+    if (m_model_matrices.size() > m_model_matrix_capacity)
+    {
+        m_model_matrix_capacity = std::max({m_model_matrices.size(), m_model_matrix_capacity * 2, std::size_t(64)});
+
+        if (!m_model_matrix_buffer.getName())
+            m_model_matrix_buffer = GL::Buffer();
+
+        // the new storage is filled in full, so individual changes don't matter
+        glNamedBufferData(m_model_matrix_buffer.getName(),
+                          static_cast<GLsizeiptr>(m_model_matrix_capacity * sizeof(UniformData)), nullptr,
+                          GL_DYNAMIC_DRAW);
+        glNamedBufferSubData(m_model_matrix_buffer.getName(), 0,
+                             static_cast<GLsizeiptr>(m_model_matrices.size() * sizeof(UniformData)),
+                             m_model_matrices.data());
+        m_dirty_matrices.clear();
+    }
+
+    std::sort(m_dirty_matrices.begin(), m_dirty_matrices.end());
+
+    // runs separated by a few unchanged matrices are uploaded together, trading bandwidth for fewer calls
+    constexpr std::uint32_t max_gap = 4;
+
+    for (std::size_t i = 0; i < m_dirty_matrices.size();)
+    {
+        const std::uint32_t first = m_dirty_matrices[i];
+        std::uint32_t last = first;
+
+        for (; i < m_dirty_matrices.size() && m_dirty_matrices[i] <= last + max_gap; i++)
+            last = m_dirty_matrices[i];
+
+        glNamedBufferSubData(m_model_matrix_buffer.getName(), static_cast<GLintptr>(first * sizeof(UniformData)),
+                             static_cast<GLsizeiptr>((last - first + 1) * sizeof(UniformData)),
+                             m_model_matrices.data() + first);
+    }
+
+    m_dirty_matrices.clear();
+
+    StateCache::get().bindBufferRange(GL_SHADER_STORAGE_BUFFER, model_matrix_block_binding,
+                                      m_model_matrix_buffer.getName(), 0,
+                                      static_cast<GLsizeiptr>(m_model_matrices.size() * sizeof(UniformData)));
+}
+
+} // Simple::Renderer
@@ -1,27 +1,128 @@
 #include "simple_renderer/render_queue.hpp"
 
 #include "simple_renderer/glsl_definitions.hpp"
+#include "simple_renderer/state_cache.hpp"
+#include "simple_renderer/frame_capture.hpp"
 
 #include "glutils/gl.hpp"
 
-#include "glm/gtc/type_ptr.hpp"
-
 #include <algorithm>
+#include <cstring>
 #include <utility>
 
 namespace Simple::Renderer {
 
-void RenderQueue::draw(const Drawable &drawable, const ShaderProgram &program, const glm::mat4 &model_transform)
+// draw key layout, from most to least significant bits: | layer 8 | program 20 | vertex array 20 | depth 16 |
+// GL object names wider than their field are truncated; this may only make state changes less coherent, since the
+// state bound while executing the command sequence is tracked using the actual handles.
+constexpr unsigned int draw_key_depth_bits = 16;
+constexpr unsigned int draw_key_vertex_array_bits = 20;
+constexpr unsigned int draw_key_program_bits = 20;
+
+constexpr unsigned int draw_key_vertex_array_shift = draw_key_depth_bits;
+constexpr unsigned int draw_key_program_shift = draw_key_vertex_array_shift + draw_key_vertex_array_bits;
+constexpr unsigned int draw_key_layer_shift = draw_key_program_shift + draw_key_program_bits;
+
+static_assert(draw_key_layer_shift + 8 == 64);
+
+static constexpr std::uint64_t lowBitsMask(unsigned int bits)
+{
+    return (std::uint64_t(1) << bits) - 1;
+}
+
+/// Quantize a view space distance so that closer objects get lower values.
+static std::uint64_t makeDepthBucket(float distance)
+{
+    // the bit pattern of a non-negative IEEE float increases monotonically with its value
+    distance = std::max(distance, 0.0f);
+
+    std::uint32_t bits;
+    std::memcpy(&bits, &distance, sizeof(bits));
+
+    return bits >> (32 - draw_key_depth_bits);
+}
+
+static std::uint64_t makeDrawKey(std::uint8_t layer, GLuint program, GLuint vertex_array, float distance)
+{
+    return std::uint64_t(layer) << draw_key_layer_shift
+           | (program & lowBitsMask(draw_key_program_bits)) << draw_key_program_shift
+           | (vertex_array & lowBitsMask(draw_key_vertex_array_bits)) << draw_key_vertex_array_shift
+           | makeDepthBucket(distance);
+}
+
+/// Is GL_ARB_shader_draw_parameters, which the vertex shader prelude enables if available, supported?
+static bool hasShaderDrawParameters()
+{
+    static const bool supported = []
+    {
+        GLint extension_count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+
+        for (GLint i = 0; i < extension_count; i++)
+        {
+            const auto *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+            if (std::strcmp(name, "GL_ARB_shader_draw_parameters") == 0)
+                return true;
+        }
+
+        return false;
+    }();
+
+    return supported;
+}
+
+void RenderQueue::Recorder::draw(const Drawable &drawable, const ShaderProgram &program,
+                                 const glm::mat4 &model_transform, std::uint8_t layer)
+{
+    m_draw(drawable, s_getProgramHandle(program), model_transform, layer);
+}
+
+void RenderQueue::Recorder::m_draw(const Drawable &drawable, GL::ProgramHandle program,
+                                   const glm::mat4 &model_transform, std::uint8_t layer)
 {
+    if (drawable.isUploading())
+        return;
+
     const std::size_t uniform_data_index = m_uniform_data.size();
-    m_uniform_data.emplace_back(model_transform);
+    m_uniform_data.emplace_back(drawable.getModelMatrix(model_transform));
+    m_draw_layers.emplace_back(layer);
+
+    if (const auto &bounds = drawable.getBounds())
+        m_draw_bounds.push_back(*bounds, model_transform);
+    else
+        m_draw_bounds.pushUnbounded();
 
-    drawable.collectDrawCommands(CommandCollector(m_command_queue, uniform_data_index, program.m_program));
+    s_collectDrawCommands(drawable, program, m_command_queue, uniform_data_index);
+}
+
+void RenderQueue::s_collectDrawCommands(const Drawable &drawable, GL::ProgramHandle program,
+                                        RendererCommandQueue &command_queue, std::size_t uniform_data_index)
+{
+    drawable.collectDrawCommands(CommandCollector(command_queue, uniform_data_index, program));
+}
+
+void RenderQueue::Recorder::clear()
+{
+    m_command_queue.clear();
+    m_uniform_data.clear();
+    m_draw_layers.clear();
+    m_draw_bounds.clear();
+}
+
+void RenderQueue::setRecorderCount(std::size_t count)
+{
+    if (count < m_recorders.size())
+        m_recorders.resize(count);
+
+    while (m_recorders.size() < count)
+        m_recorders.push_back(std::make_unique<Recorder>());
 }
 
 struct RenderQueue::CommandSequenceBuilder
 {
-    CommandSequenceBuilder(RenderQueue &renderer) : renderer(renderer)
+    CommandSequenceBuilder(RenderQueue &renderer, const Recorder &recorder, std::size_t uniform_base_index,
+                           const glm::mat4 &view_matrix) :
+            renderer(renderer), recorder(recorder), uniform_base_index(uniform_base_index), view_matrix(view_matrix)
     {}
 
     template<typename Command>
@@ -30,58 +131,284 @@ struct RenderQueue::CommandSequenceBuilder
         for (const auto &[command, args]: command_vector)
         {
             const auto [uniform_index, program, vertex_array] = args;
-            renderer.m_command_sequence.emplace_back(program,
-                                                     vertex_array,
-                                                     &renderer.m_uniform_data[uniform_index],
-                                                     &command);
+
+            if (!recorder.m_draw_visibility[uniform_index])
+                continue;
+
+            const UniformData &uniform_data = recorder.m_uniform_data[uniform_index];
+
+            // the camera looks towards negative z in view space
+            const float distance = -(view_matrix * uniform_data[3]).z;
+
+            renderer.m_command_sequence.push(makeDrawKey(recorder.m_draw_layers[uniform_index], program.getName(),
+                                                         vertex_array.getName(), distance),
+                                             {program, vertex_array,
+                                              static_cast<std::uint32_t>(uniform_base_index + uniform_index),
+                                              command_type_tag<Command>, &command});
         }
     }
 
     RenderQueue &renderer;
+    const Recorder &recorder;
+    std::size_t uniform_base_index;
+    const glm::mat4 &view_matrix;
 };
 
-void RenderQueue::finishFrame(const Camera &camera)
+struct RenderQueue::RenderListSequenceBuilder
+{
+    template<typename Command>
+    void operator()(const RendererCommandQueue::CommandVector <Command> &command_vector) const
+    {
+        for (const auto &[command, args]: command_vector)
+        {
+            const auto [uniform_index, program, vertex_array] = args;
+
+            // the order of a render list doesn't depend on the camera, so depth is left out of the key
+            command_sequence.push(makeDrawKey(layer, program.getName(), vertex_array.getName(), 0.0f),
+                                  {program, vertex_array, static_cast<std::uint32_t>(uniform_index),
+                                   command_type_tag<Command>, &command});
+        }
+    }
+
+    CommandSequence &command_sequence;
+    std::uint8_t layer;
+};
+
+void RenderQueue::s_updateRenderList(RenderList &render_list)
+{
+    // draws of drawables that are still uploading stay stale, and are collected in a later frame
+    std::size_t still_stale = 0;
+
+    for (const RenderList::DrawHandle handle: render_list.m_stale_handles)
+    {
+        RenderList::Entry &entry = render_list.m_entries[static_cast<std::size_t>(handle)];
+
+        // the draw may have been removed after being marked
+        if (!entry.drawable)
+            continue;
+
+        entry.command_queue.clear();
+
+        if (entry.drawable->isUploading())
+        {
+            render_list.m_stale_handles[still_stale++] = handle;
+            continue;
+        }
+
+        s_collectDrawCommands(*entry.drawable, s_getProgramHandle(*entry.program), entry.command_queue,
+                              static_cast<std::size_t>(handle));
+        render_list.m_command_sequence_dirty = true;
+    }
+
+    render_list.m_stale_handles.resize(still_stale);
+
+    if (!render_list.m_command_sequence_dirty)
+        return;
+
+    render_list.m_command_sequence.clear();
+
+    for (RenderList::Entry &entry: render_list.m_entries)
+        if (entry.drawable)
+            entry.command_queue.forEachCommandType(RenderListSequenceBuilder{render_list.m_command_sequence,
+                                                                             entry.layer});
+
+    render_list.m_command_sequence.sort();
+    render_list.m_command_sequence_dirty = false;
+}
+
+RenderQueue::~RenderQueue() = default;
+
+void RenderQueue::m_uploadModelMatrices()
+{
+    const std::size_t size = m_uniform_data_count * sizeof(UniformData);
+
+    if (!m_storage_buffer_alignment)
+    {
+        GLint offset_alignment;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+        m_storage_buffer_alignment = static_cast<std::size_t>(offset_alignment);
+    }
+
+    m_model_matrix_stream.reserve(std::max(size, std::size_t(64) * sizeof(UniformData)));
+    const auto allocation = m_model_matrix_stream.allocate(size, m_storage_buffer_alignment);
+
+    // recorders' matrices are placed one after another, in the same order used to build the command sequence
+    std::byte *destination = allocation.data;
+    m_forEachRecorder([&destination](const Recorder &recorder)
+    {
+        const std::size_t recorder_size = recorder.m_uniform_data.size() * sizeof(UniformData);
+        std::memcpy(destination, recorder.m_uniform_data.data(), recorder_size);
+        destination += recorder_size;
+    });
+
+    StateCache::get().bindBufferRange(GL_SHADER_STORAGE_BUFFER, model_matrix_block_binding,
+                                      allocation.buffer.getName(), static_cast<GLintptr>(allocation.offset),
+                                      static_cast<GLsizeiptr>(size));
+}
+
+bool RenderQueue::usesMultiDrawIndirect() const
+{
+    return m_submission_mode == SubmissionMode::multi_draw_indirect && hasShaderDrawParameters();
+}
+
+void RenderQueue::m_cullDraws(const Camera &camera)
 {
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    //gl.PointSize(2.5f);
+    m_culling_stats = {};
 
-    m_command_queue.forEachCommandType(CommandSequenceBuilder(*this));
+    if (!m_frustum_culling)
+    {
+        m_forEachRecorder([this](Recorder &recorder)
+        {
+            recorder.m_draw_visibility.assign(recorder.m_uniform_data.size(), 1);
+            m_culling_stats.visible_draws += recorder.m_uniform_data.size();
+        });
+        return;
+    }
 
-    std::sort(m_command_sequence.begin(), m_command_sequence.end());
+    const Frustum frustum = Frustum::fromMatrix(camera.getProjectionMatrix() * camera.getViewMatrix());
 
-    camera.bindUniformBlock();
+    m_forEachRecorder([this, &frustum](Recorder &recorder)
+    {
+        const std::size_t visible_count = recorder.m_draw_bounds.cull(frustum, recorder.m_draw_visibility);
+        m_culling_stats.visible_draws += visible_count;
+        m_culling_stats.culled_draws += recorder.m_draw_bounds.size() - visible_count;
+    });
+}
+
+void RenderQueue::m_captureFrame(const Camera &camera)
+{
+    FrameCaptureWriter writer(*m_pending_capture);
+    m_pending_capture = nullptr;
 
-    GL::ProgramHandle bound_program{};
-    GL::VertexArrayHandle bound_vertex_array{};
-    const UniformData *bound_uniform{nullptr};
+    writer.setCamera(camera);
 
-    // iterate over commands in sequence, changing gl state when necessary
-    for (const auto &[program, vertex_array, uniform_data, command]: m_command_sequence)
+    for (RenderList *render_list: m_render_lists)
     {
-        if (program != bound_program)
+        for (std::size_t i = 0; i < render_list->m_entries.size(); i++)
         {
-            program.use();
-            bound_program = program;
+            RenderList::Entry &entry = render_list->m_entries[i];
+
+            if (!entry.drawable)
+                continue;
+
+            const std::uint32_t draw = writer.addDraw(s_getProgramHandle(*entry.program),
+                                                      render_list->m_model_matrices[i], entry.layer);
+
+            entry.command_queue.forEachCommandType([&writer, draw](const auto &command_vector)
+            {
+                for (const auto &[command, args]: command_vector)
+                    writer.addCommand(draw, command, std::get<GL::VertexArrayHandle>(args));
+            });
         }
+    }
+
+    static constexpr std::uint32_t no_draw = -1u;
+
+    // captured draw of each uniform index of a recorder
+    std::vector<std::uint32_t> draws;
 
-        if (vertex_array != bound_vertex_array)
+    m_forEachRecorder([&writer, &draws](Recorder &recorder)
+    {
+        draws.assign(recorder.m_uniform_data.size(), no_draw);
+
+        recorder.m_command_queue.forEachCommandType([&](const auto &command_vector)
         {
-            vertex_array.bind();
-            bound_vertex_array = vertex_array;
+            for (const auto &[command, args]: command_vector)
+            {
+                const auto [uniform_index, program, vertex_array] = args;
+
+                if (!recorder.m_draw_visibility[uniform_index])
+                    continue;
+
+                if (draws[uniform_index] == no_draw)
+                    draws[uniform_index] = writer.addDraw(program, recorder.m_uniform_data[uniform_index],
+                                                          recorder.m_draw_layers[uniform_index]);
+
+                writer.addCommand(draws[uniform_index], command, vertex_array);
+            }
+        });
+    });
+}
+
+void RenderQueue::finishFrame(const Camera &camera)
+{
+    m_profiler.beginFrame();
+
+    {
+        const auto timer = m_profiler.time(FramePhase::submit);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        //gl.PointSize(2.5f);
+        camera.bindUniformBlock();
+    }
+
+    const bool use_indirect_batches = usesMultiDrawIndirect();
+
+    for (RenderList *render_list: m_render_lists)
+    {
+        {
+            const auto timer = m_profiler.time(FramePhase::build);
+            s_updateRenderList(*render_list);
         }
 
-        if (uniform_data != bound_uniform)
+        if (render_list->m_command_sequence.empty())
+            continue;
+
         {
-            glUniformMatrix4fv(model_matrix_def.layout.location, 1, false, glm::value_ptr(*uniform_data));
-            bound_uniform = uniform_data;
+            const auto timer = m_profiler.time(FramePhase::upload);
+            render_list->m_uploadModelMatrices();
+
+            if (use_indirect_batches)
+                render_list->m_command_sequence.buildIndirectBatches();
         }
 
-        (*command)();
+        const auto timer = m_profiler.time(FramePhase::submit);
+        render_list->m_command_sequence.execute(use_indirect_batches);
     }
 
-    m_command_queue.clear();
+    {
+        const auto timer = m_profiler.time(FramePhase::cull);
+        m_cullDraws(camera);
+    }
+
+    {
+        const auto timer = m_profiler.time(FramePhase::build);
+        m_uniform_data_count = 0;
+        m_forEachRecorder([this, &camera](Recorder &recorder)
+        {
+            recorder.m_command_queue.forEachCommandType(
+                    CommandSequenceBuilder(*this, recorder, m_uniform_data_count, camera.getViewMatrix()));
+            m_uniform_data_count += recorder.m_uniform_data.size();
+        });
+    }
+
+    {
+        const auto timer = m_profiler.time(FramePhase::sort);
+        m_command_sequence.sort();
+    }
+
+    if (!m_command_sequence.empty())
+    {
+        {
+            const auto timer = m_profiler.time(FramePhase::upload);
+            m_uploadModelMatrices();
+
+            if (use_indirect_batches)
+                m_command_sequence.buildIndirectBatches();
+        }
+
+        const auto timer = m_profiler.time(FramePhase::submit);
+        m_command_sequence.execute(use_indirect_batches);
+        m_model_matrix_stream.finishFrame();
+    }
+
+    if (m_pending_capture)
+        m_captureFrame(camera);
+
+    m_forEachRecorder([](Recorder &recorder) { recorder.clear(); });
     m_command_sequence.clear();
-    m_uniform_data.clear();
+    m_render_lists.clear();
+
+    m_profiler.endFrame();
 }
 
-} // Simple::Renderer
\ No newline at end of file
+} // Simple::Renderer
@@ -1,5 +1,7 @@
 #include "simple_renderer/renderer.hpp"
 
+#include "simple_renderer/texture_2d.hpp"
+
 #include "glutils/gl.hpp"
 
 namespace Simple::Renderer {
@@ -7,21 +9,42 @@ namespace Simple::Renderer {
 void loadGL(glLoader loader)
 {
     GL::loadContext(loader);
+    StateCache::get().invalidate();
 }
 
 void setViewport(glm::ivec2 lower_left, glm::ivec2 top_right)
 {
-    glViewport(lower_left.x, lower_left.y, top_right.x, top_right.y);
+    StateCache::get().setViewport(lower_left, top_right);
 }
 
 void enable(Capability capability)
 {
-    glEnable(static_cast<GLenum>(capability));
+    StateCache::get().setCapability(static_cast<GLenum>(capability), true);
 }
 
 void disable(Capability capability)
 {
-    glDisable(static_cast<GLenum>(capability));
+    StateCache::get().setCapability(static_cast<GLenum>(capability), false);
+}
+
+void setDepthFunction(DepthFunction function)
+{
+    StateCache::get().setDepthFunction(static_cast<GLenum>(function));
+}
+
+void setDepthWrite(bool enabled)
+{
+    StateCache::get().setDepthMask(enabled);
+}
+
+void setBlendFunction(BlendFactor source_factor, BlendFactor destination_factor)
+{
+    StateCache::get().setBlendFunction(static_cast<GLenum>(source_factor), static_cast<GLenum>(destination_factor));
+}
+
+void bindTexture(std::uint32_t unit, const Texture2D &texture)
+{
+    StateCache::get().bindTextureUnit(unit, texture.getGLObject().getName());
 }
 
-} // Simple::Renderer
\ No newline at end of file
+} // Simple::Renderer
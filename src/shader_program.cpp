@@ -19,16 +19,28 @@ namespace Simple::Renderer {
                     << vertex_position_def << '\n'
                     << vertex_normal_def << '\n'
                     << vertex_uv_def << '\n'
+                    << octahedral_normal_glsl_c_str
             ).str()
         };
         return str;
     }
 
-    static auto getUniformDefString() -> const std::string &
+    static auto getVertexUniformDefString() -> const std::string &
     {
         static const auto str {
             ( std::ostringstream()
-                    << model_matrix_def << '\n'
+                    << model_matrix_glsl_c_str
+                    << camera_uniform_block_def << '\n'
+            ).str()
+        };
+        return str;
+    }
+
+    static auto getFragmentUniformDefString() -> const std::string &
+    {
+        static const auto str {
+            ( std::ostringstream()
+                    << model_matrix_fragment_glsl_c_str
                     << camera_uniform_block_def << '\n'
             ).str()
         };
@@ -47,9 +59,11 @@ namespace Simple::Renderer {
         {   // vertex shader compilation
             std::array strings {
                     glsl_version_c_str,
+                    glsl_vertex_extensions_c_str,
                     getVertexAttribDefString().c_str(),
-                    getUniformDefString().c_str(),
-                    vert_src
+                    getVertexUniformDefString().c_str(),
+                    vert_src,
+                    model_matrix_vertex_main_glsl_c_str
             };
 
             vert.setSource(strings.size(), strings.data());
@@ -62,7 +76,7 @@ namespace Simple::Renderer {
         {   // fragment shader compilation
             std::array strings {
                     glsl_version_c_str,
-                    getUniformDefString().c_str(),
+                    getFragmentUniformDefString().c_str(),
                     getFragOutDefString().c_str(),
                     frag_src
             };
@@ -77,6 +91,9 @@ namespace Simple::Renderer {
 
         m_program.attachShader(vert);
         m_program.attachShader(frag);
+
+        // without the hint, the implementation may not keep a binary for FrameCaptureWriter to read back
+        glProgramParameteri(m_program.getName(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
         m_program.link();
         m_program.detachShader(vert);
         m_program.detachShader(frag);
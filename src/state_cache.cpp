@@ -0,0 +1,141 @@
+#include "simple_renderer/state_cache.hpp"
+
+namespace Simple::Renderer {
+
+StateCache &StateCache::get()
+{
+    thread_local StateCache cache;
+    return cache;
+}
+
+void StateCache::invalidate()
+{
+    const Stats stats = m_stats;
+    *this = StateCache();
+    m_stats = stats;
+}
+
+void StateCache::forgetBuffer(GLuint buffer)
+{
+    for (IndexedBinding &binding: m_indexed_bindings)
+        if (binding.range && binding.range->buffer == buffer)
+            binding.range.reset();
+
+    for (Binding &binding: m_bindings)
+        if (binding.buffer == buffer)
+            binding.buffer.reset();
+}
+
+void StateCache::forgetTexture(GLuint texture)
+{
+    for (std::optional<GLuint> &bound_texture: m_texture_units)
+        if (bound_texture == texture)
+            bound_texture.reset();
+}
+
+void StateCache::setCapability(GLenum capability, bool enabled)
+{
+    auto iter = m_capabilities.begin();
+    while (iter != m_capabilities.end() && iter->capability != capability)
+        ++iter;
+
+    if (iter == m_capabilities.end())
+        iter = m_capabilities.insert(iter, {capability, std::nullopt});
+
+    if (!m_update(iter->enabled, enabled))
+        return;
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void StateCache::setViewport(glm::ivec2 lower_left, glm::ivec2 size)
+{
+    if (m_update(m_viewport, glm::ivec4(lower_left.x, lower_left.y, size.x, size.y)))
+        glViewport(lower_left.x, lower_left.y, size.x, size.y);
+}
+
+void StateCache::bindTextureUnit(GLuint unit, GLuint texture)
+{
+    if (unit >= m_texture_units.size())
+        m_texture_units.resize(unit + 1);
+
+    if (m_update(m_texture_units[unit], texture))
+        glBindTextureUnit(unit, texture);
+}
+
+std::optional<StateCache::BufferRange> &StateCache::m_getIndexedBinding(GLenum target, GLuint index)
+{
+    for (IndexedBinding &binding: m_indexed_bindings)
+        if (binding.target == target && binding.index == index)
+            return binding.range;
+
+    m_indexed_bindings.push_back({target, index, std::nullopt});
+    return m_indexed_bindings.back().range;
+}
+
+void StateCache::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    if (!m_update(m_getIndexedBinding(target, index), BufferRange{buffer, offset, size}))
+        return;
+
+    glBindBufferRange(target, index, buffer, offset, size);
+
+    // indexed binding functions also bind the buffer to the generic binding point
+    for (Binding &binding: m_bindings)
+        if (binding.target == target)
+            binding.buffer = buffer;
+}
+
+void StateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    if (!m_update(m_getIndexedBinding(target, index), BufferRange{buffer, 0, 0}))
+        return;
+
+    glBindBufferBase(target, index, buffer);
+
+    for (Binding &binding: m_bindings)
+        if (binding.target == target)
+            binding.buffer = buffer;
+}
+
+void StateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+    auto iter = m_bindings.begin();
+    while (iter != m_bindings.end() && iter->target != target)
+        ++iter;
+
+    if (iter == m_bindings.end())
+        iter = m_bindings.insert(iter, {target, std::nullopt});
+
+    if (m_update(iter->buffer, buffer))
+        glBindBuffer(target, buffer);
+}
+
+void StateCache::setBlendFunction(GLenum source_factor, GLenum destination_factor)
+{
+    if (m_update(m_blend_function, BlendFunction{source_factor, destination_factor}))
+        glBlendFunc(source_factor, destination_factor);
+}
+
+void StateCache::setBlendEquation(GLenum mode)
+{
+    if (m_update(m_blend_equation, mode))
+        glBlendEquation(mode);
+}
+
+void StateCache::setDepthFunction(GLenum function)
+{
+    if (m_update(m_depth_function, function))
+        glDepthFunc(function);
+}
+
+void StateCache::setDepthMask(bool enabled)
+{
+    if (m_update(m_depth_mask, enabled))
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+} // Simple::Renderer
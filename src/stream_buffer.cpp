@@ -0,0 +1,136 @@
+#include "simple_renderer/stream_buffer.hpp"
+
+#include "simple_renderer/state_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace Simple::Renderer {
+
+/// Block until the GPU has signaled @p fence, then delete it.
+static void waitAndDeleteFence(GLsync &fence)
+{
+    if (!fence)
+        return;
+
+    constexpr GLuint64 timeout_ns = 1'000'000'000;
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns) == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+StreamBuffer::StreamBuffer(std::size_t region_size, std::size_t region_count, MemoryCategory category)
+        : m_memory(category, 0), m_fences(region_count, nullptr)
+{
+    if (region_count == 0)
+        throw std::logic_error("a stream buffer needs at least one region");
+
+    if (region_size > 0)
+        reserve(region_size);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (GLsync fence: m_fences)
+        glDeleteSync(fence);
+
+    StateCache::get().forgetBuffer(m_buffer.getName());
+}
+
+void StreamBuffer::reserve(std::size_t region_size)
+{
+    if (region_size <= m_region_size)
+        return;
+
+    // the buffer's storage is immutable; regions still in use must be finished before it is replaced.
+    for (GLsync &fence: m_fences)
+        waitAndDeleteFence(fence);
+
+    std::size_t new_size = std::max(m_region_size * 2, region_size);
+    new_size = (new_size + s_region_alignment - 1) / s_region_alignment * s_region_alignment;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const auto buffer_size = static_cast<GLsizeiptr>(new_size * m_fences.size());
+
+    StateCache::get().forgetBuffer(m_buffer.getName());
+    m_buffer = GL::Buffer();
+    glNamedBufferStorage(m_buffer.getName(), buffer_size, nullptr, flags);
+    m_mapping = static_cast<std::byte *>(glMapNamedBufferRange(m_buffer.getName(), 0, buffer_size, flags));
+    m_memory.resize(static_cast<std::size_t>(buffer_size));
+
+    if (!m_mapping)
+        throw std::runtime_error("stream buffer mapping failed");
+
+    m_region_size = new_size;
+    m_region = 0;
+    m_used_size = 0;
+    m_region_ready = true;
+}
+
+void StreamBuffer::m_waitForRegion()
+{
+    if (m_region_ready)
+        return;
+
+    waitAndDeleteFence(m_fences[m_region]);
+    m_region_ready = true;
+}
+
+auto StreamBuffer::tryAllocate(std::size_t size, std::size_t alignment) -> std::optional<Allocation>
+{
+    const std::size_t region_offset = m_region * m_region_size;
+    const std::size_t offset = (region_offset + m_used_size + alignment - 1) / alignment * alignment;
+
+    if (offset + size > region_offset + m_region_size)
+        return {};
+
+    m_waitForRegion();
+    m_used_size = offset + size - region_offset;
+
+    return Allocation{m_mapping + offset, m_buffer, offset, size};
+}
+
+auto StreamBuffer::allocate(std::size_t size, std::size_t alignment) -> Allocation
+{
+    const auto allocation = tryAllocate(size, alignment);
+    if (!allocation.has_value())
+        throw std::logic_error("stream buffer region is full");
+    return *allocation;
+}
+
+auto StreamBuffer::write(const void *data, std::size_t size, std::size_t alignment) -> Allocation
+{
+    const Allocation allocation = allocate(size, alignment);
+    std::memcpy(allocation.data, data, size);
+    return allocation;
+}
+
+void StreamBuffer::upload(WBufferRef destination, const void *data)
+{
+    const auto allocation = tryAllocate(destination.getSize());
+
+    if (!allocation.has_value())
+    {
+        destination.write(data);
+        return;
+    }
+
+    std::memcpy(allocation->data, data, allocation->size);
+    destination.copyFrom(allocation->getReadRef());
+}
+
+void StreamBuffer::finishFrame()
+{
+    // an unused region may stay current
+    if (m_used_size == 0)
+        return;
+
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % m_fences.size();
+    m_used_size = 0;
+    m_region_ready = false;
+}
+
+} // Simple::Renderer
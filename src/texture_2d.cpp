@@ -1,9 +1,11 @@
 #include "simple_renderer/texture_2d.hpp"
 #include "simple_renderer/image_data.hpp"
+#include "simple_renderer/state_cache.hpp"
 
 #include "glm/common.hpp"
 
 #include <utility>
+#include <vector>
 #include <stdexcept>
 
 namespace Simple {
@@ -38,6 +40,16 @@ int calculateMipmapLevels(glm::uvec2 image_size)
     return mipmap_levels;
 }
 
+/// Size of the storage of a texture, including all of its mipmap levels.
+std::size_t calculateStorageSize(glm::uvec2 image_size, int mipmap_levels, std::size_t texel_size)
+{
+    std::size_t storage_size = 0;
+    glm::uvec2 size = image_size;
+    for (int level = 0; level < mipmap_levels; level++, size = glm::max({1, 1}, size / 2u))
+        storage_size += std::size_t(size.x) * size.y * texel_size;
+    return storage_size;
+}
+
 Texture2D::Texture2D(const ImageData &image, bool generate_mipmaps)
     : m_texture(GL::Texture::Type::_2d), m_size(image.getSize())
 {
@@ -46,10 +58,69 @@ Texture2D::Texture2D(const ImageData &image, bool generate_mipmaps)
     const auto [internal_format, data_format] = parseFormat(image.getChannels());
 
     m_texture.setStorage2D(mipmap_levels, internal_format, image.getSize().x, image.getSize().y);
+    m_memory = Renderer::TrackedMemory(Renderer::MemoryCategory::texture,
+                                       calculateStorageSize(m_size, mipmap_levels,
+                                                            static_cast<std::size_t>(image.getChannels())));
+
     m_texture.updateImage2D(0, 0, 0, image.getSize().x, image.getSize().y, data_format,
                             GL::Texture::DataType::ubyte, image.getDataPtr());
 
     if (generate_mipmaps)
         m_texture.generateMipmap();
 }
+
+Texture2D::Texture2D(const ImageData &image, Renderer::UploadQueue &upload_queue, bool generate_mipmaps)
+    : m_texture(GL::Texture::Type::_2d), m_size(image.getSize())
+{
+    const int mipmap_levels = generate_mipmaps ? calculateMipmapLevels(image.getSize()) : 1;
+
+    const auto [internal_format, data_format] = parseFormat(image.getChannels());
+
+    m_texture.setStorage2D(mipmap_levels, internal_format, image.getSize().x, image.getSize().y);
+    m_memory = Renderer::TrackedMemory(Renderer::MemoryCategory::texture,
+                                       calculateStorageSize(m_size, mipmap_levels,
+                                                            static_cast<std::size_t>(image.getChannels())));
+
+    const std::size_t size = std::size_t(m_size.x) * m_size.y * static_cast<std::size_t>(image.getChannels());
+    std::vector<std::byte> data(image.getDataPtr(), image.getDataPtr() + size);
+
+    // the staged image is read from the pixel unpack buffer; the data pointer becomes an offset into it
+    const GLuint texture = m_texture.getName();
+    const glm::uvec2 image_size = m_size;
+    const auto format = static_cast<GLenum>(data_format);
+
+    m_upload_ticket = upload_queue.enqueue(std::move(data),
+                                           [texture, image_size, format, generate_mipmaps](RBufferRef staged)
+    {
+        auto &state_cache = Renderer::StateCache::get();
+        state_cache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, staged.getBuffer().getName());
+
+        glTextureSubImage2D(texture, 0, 0, 0, static_cast<GLsizei>(image_size.x), static_cast<GLsizei>(image_size.y),
+                            format, GL_UNSIGNED_BYTE, reinterpret_cast<const void *>(staged.getOffset()));
+
+        state_cache.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (generate_mipmaps)
+            glGenerateTextureMipmap(texture);
+    });
+}
+
+Texture2D &Texture2D::operator=(Texture2D &&other) noexcept
+{
+    if (this != &other)
+    {
+        Renderer::StateCache::get().forgetTexture(m_texture.getName());
+        m_texture = std::move(other.m_texture);
+        m_size = other.m_size;
+        m_upload_ticket = other.m_upload_ticket;
+        m_memory = std::move(other.m_memory);
+    }
+
+    return *this;
+}
+
+Texture2D::~Texture2D()
+{
+    Renderer::StateCache::get().forgetTexture(m_texture.getName());
+}
 } // simple
\ No newline at end of file
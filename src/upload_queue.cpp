@@ -0,0 +1,149 @@
+#include "simple_renderer/upload_queue.hpp"
+
+#include "simple_renderer/buffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace Simple::Renderer {
+
+/// Staged data is aligned to this, which is enough for any texel or vertex component type.
+constexpr std::size_t staging_alignment = 4;
+
+/// Size taken by @p size bytes of staged data.
+static std::size_t alignSize(std::size_t size)
+{ return (size + staging_alignment - 1) / staging_alignment * staging_alignment; }
+
+UploadQueue::UploadQueue(std::size_t byte_budget) : m_byte_budget(byte_budget)
+{}
+
+UploadQueue::~UploadQueue()
+{
+    for (const Batch &batch: m_batches)
+        glDeleteSync(batch.fence);
+}
+
+auto UploadQueue::enqueue(WBufferRef destination, const void *data) -> Ticket
+{
+    const auto *bytes = static_cast<const std::byte *>(data);
+    return enqueue(destination, std::vector<std::byte>(bytes, bytes + destination.getSize()));
+}
+
+auto UploadQueue::enqueue(WBufferRef destination, std::vector<std::byte> data) -> Ticket
+{
+    if (data.size() != destination.getSize())
+        throw std::logic_error("upload data size does not match the destination buffer range size");
+
+    m_pending_size += data.size();
+    m_jobs.push_back({std::move(data), destination, nullptr, ++m_last_ticket});
+    return static_cast<Ticket>(m_last_ticket);
+}
+
+auto UploadQueue::enqueue(std::vector<std::byte> data, CopyFunction copy) -> Ticket
+{
+    m_pending_size += data.size();
+    m_jobs.push_back({std::move(data), std::nullopt, std::move(copy), ++m_last_ticket});
+    return static_cast<Ticket>(m_last_ticket);
+}
+
+void UploadQueue::update()
+{
+    m_retireBatches(false);
+    m_submit();
+}
+
+void UploadQueue::finish()
+{
+    while (!m_jobs.empty())
+        m_submit();
+
+    m_retireBatches(true);
+}
+
+void UploadQueue::m_submit()
+{
+    if (m_jobs.empty())
+        return;
+
+    // staged sizes are aligned, so a budget that's a multiple of the alignment is never exceeded
+    const std::size_t byte_budget = std::max(m_byte_budget / staging_alignment * staging_alignment, staging_alignment);
+    m_staging.reserve(byte_budget);
+
+    std::size_t staged_size = 0;
+
+    while (!m_jobs.empty() && staged_size < byte_budget)
+    {
+        Job &job = m_jobs.front();
+        const std::size_t available = byte_budget - staged_size;
+
+        if (job.destination)
+        {
+            const std::size_t size = std::min(job.data.size() - job.staged_size, available);
+            const auto allocation = m_staging.write(job.data.data() + job.staged_size, size, staging_alignment);
+
+            WBufferRef chunk(job.destination->getBuffer(), job.destination->getOffset() + job.staged_size, size);
+            chunk.copyFrom(allocation.getReadRef());
+
+            job.staged_size += size;
+            staged_size += alignSize(size);
+            m_pending_size -= size;
+
+            if (job.staged_size < job.data.size())
+                break;
+        }
+        else if (alignSize(job.data.size()) <= available)
+        {
+            const auto allocation = m_staging.write(job.data.data(), job.data.size(), staging_alignment);
+            job.copy(allocation.getReadRef());
+
+            staged_size += alignSize(job.data.size());
+            m_pending_size -= job.data.size();
+        }
+        else if (staged_size == 0)
+        {
+            // the buffer is only deleted once the GPU is done with the copy
+            const Buffer temporary(job.data.size(), job.data.data(), MemoryCategory::staging);
+            job.copy(RBufferRef(temporary.getGLHandle(), 0, job.data.size()));
+
+            staged_size = byte_budget;
+            m_pending_size -= job.data.size();
+        }
+        else
+        {
+            break;
+        }
+
+        m_jobs.pop_front();
+    }
+
+    m_staging.finishFrame();
+
+    // every job before the first pending one has been issued
+    const std::uint64_t last_ticket = m_jobs.empty() ? m_last_ticket : m_jobs.front().ticket - 1;
+    m_batches.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), last_ticket});
+}
+
+void UploadQueue::m_retireBatches(bool wait)
+{
+    while (!m_batches.empty())
+    {
+        Batch &batch = m_batches.front();
+
+        if (wait)
+        {
+            constexpr GLuint64 timeout_ns = 1'000'000'000;
+            while (glClientWaitSync(batch.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns) == GL_TIMEOUT_EXPIRED);
+        }
+        else if (glClientWaitSync(batch.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            // later batches can't have completed either
+            break;
+        }
+
+        glDeleteSync(batch.fence);
+        m_completed_ticket.store(batch.last_ticket, std::memory_order_release);
+        m_batches.pop_front();
+    }
+}
+
+} // Simple::Renderer
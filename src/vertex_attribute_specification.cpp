@@ -15,6 +15,22 @@ void VertexAttributeSpecification::unbindAttribute(std::uint32_t attribute_locat
     m_attribute_bindings[attribute_location] = s_no_binding_index;
 }
 
+void VertexAttributeSpecification::rebindSection(const VertexBuffer &vertex_buffer,
+                                                 const VertexBufferSectionDescriptor &section, std::uint64_t old_offset)
+{
+    const auto stride = section.attributes.getStride();
+
+    for (std::size_t binding_index = 0; binding_index < m_vertex_buffer_bindings.size(); binding_index++)
+    {
+        auto &binding = m_vertex_buffer_bindings[binding_index];
+        if (!(binding == std::make_tuple(old_offset, stride, binding.divisor, vertex_buffer.getBufferHandle())))
+            continue;
+
+        binding.offset = section.buffer_offset;
+        m_vertex_array.bindVertexBuffer(binding_index, binding.buffer, binding.offset, binding.stride);
+    }
+}
+
 void VertexAttributeSpecification::bindIndexBuffer(const VertexBuffer &vertex_buffer)
 {
     m_vertex_array.bindElementBuffer(vertex_buffer.getBufferHandle());
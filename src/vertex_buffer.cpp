@@ -1,5 +1,9 @@
 #include "simple_renderer/vertex_buffer.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
 namespace Simple {
 
 ///////////////////////////////////////////////// VertexAttributeSequence //////////////////////////////////////////////
@@ -26,7 +30,8 @@ void VertexAttributeSequence::clear()
 
 ///////////////////////////////////////////////// Vertex buffer ////////////////////////////////////////////////////////
 
-VertexBuffer::VertexBuffer(VertexBuffer::size_uint size) : m_allocator(size), m_size(size)
+VertexBuffer::VertexBuffer(VertexBuffer::size_uint size, Renderer::MemoryCategory category)
+        : m_allocator(size), m_size(size), m_memory(category, size)
 {
     m_buffer.allocateImmutable(size, GL::Buffer::StorageFlags::dynamic_storage);
 }
@@ -42,6 +47,7 @@ VertexBuffer::tryAddAttributeData(const std::function<void(WBufferRef)> &initial
         return nullptr;
 
     initializer({m_buffer, *offset_opt, size});
+    m_compaction_order.clear();
 
     return &m_sections.emplace_back(attribute_sequence, vertex_count, *offset_opt);
 }
@@ -93,6 +99,18 @@ const VertexBufferSectionDescriptor &VertexBuffer::addAttributeData(const void *
     return checkSectionCreationSuccess(tryAddAttributeData(vertex_data, vertex_count, std::move(sequence)));
 }
 
+const VertexBufferSectionDescriptor &VertexBuffer::addAttributeData(const void *vertex_data,
+                                                                    VertexBuffer::size_uint vertex_count,
+                                                                    VertexAttributeSequence sequence,
+                                                                    Renderer::UploadQueue &upload_queue)
+{
+    if (!vertex_data)
+        throw std::logic_error("can't upload vertex buffer section from null pointer");
+
+    const auto initializer = [vertex_data, &upload_queue](WBufferRef ref) { upload_queue.enqueue(ref, vertex_data); };
+    return addAttributeData(initializer, vertex_count, std::move(sequence));
+}
+
 const VertexBufferSectionDescriptor &
 VertexBuffer::addAttributeData(GL::BufferHandle read_buffer, VertexBuffer::size_uint read_offset,
                                VertexBuffer::size_uint vertex_count, VertexAttributeSequence sequence)
@@ -113,6 +131,12 @@ void VertexBuffer::updateAttributeData(VertexBuffer::size_uint index, const void
 {
     const auto &descriptor = getSectionDescriptor(index);
     m_buffer.write(descriptor.buffer_offset, descriptor.getSize(), data);
+
+    if (SectionShadow *shadow = m_getShadow(index))
+    {
+        std::memcpy(shadow->data.data(), data, shadow->data.size());
+        shadow->dirty_ranges.clear();
+    }
 }
 
 void VertexBuffer::updateAttributeData(VertexBuffer::size_uint index, GL::BufferHandle read_buffer,
@@ -122,6 +146,13 @@ void VertexBuffer::updateAttributeData(VertexBuffer::size_uint index, GL::Buffer
     GL::Buffer::copy(read_buffer, m_buffer, read_offset, descriptor.buffer_offset, descriptor.getSize());
 }
 
+void VertexBuffer::updateAttributeData(VertexBuffer::size_uint index, const void *data,
+                                       Renderer::StreamBuffer &stream_buffer) const
+{
+    const auto &descriptor = getSectionDescriptor(index);
+    stream_buffer.upload({m_buffer, descriptor.buffer_offset, descriptor.getSize()}, data);
+}
+
 void
 VertexBuffer::updateAttributeData(VertexBuffer::size_uint index, const std::function<void(WBufferRef)> &initializer)
 {
@@ -136,6 +167,190 @@ void VertexBuffer::discardAttributeData(VertexBuffer::size_uint index)
 
     m_allocator.deallocate(m_sections[index].buffer_offset);
     m_sections.erase(m_sections.begin() + index);
+    m_compaction_order.clear();
+
+    if (index < m_shadows.size())
+        m_shadows.erase(m_shadows.begin() + index);
+}
+
+///////////////////////////////////////////////// Shadow copies ////////////////////////////////////////////////////////
+
+void VertexBuffer::enableShadowCopy(size_uint index)
+{
+    const auto &descriptor = getSectionDescriptor(index);
+
+    if (m_getShadow(index))
+        return;
+
+    if (m_shadows.size() <= index)
+        m_shadows.resize(index + 1);
+
+    auto shadow = std::make_unique<SectionShadow>();
+    shadow->data.resize(descriptor.getSize());
+    m_buffer.read(descriptor.buffer_offset, descriptor.getSize(), shadow->data.data());
+
+    m_shadows[index] = std::move(shadow);
+}
+
+void VertexBuffer::disableShadowCopy(size_uint index)
+{
+    if (index < m_shadows.size())
+        m_shadows[index].reset();
+}
+
+auto VertexBuffer::m_getExistingShadow(size_uint index) const -> SectionShadow &
+{
+    SectionShadow *shadow = m_getShadow(index);
+    if (!shadow)
+        throw std::logic_error("section has no shadow copy");
+    return *shadow;
+}
+
+std::byte *VertexBuffer::getShadowCopy(size_uint index)
+{
+    return m_getExistingShadow(index).data.data();
+}
+
+void VertexBuffer::markDirty(size_uint index, size_uint first_vertex, size_uint vertex_count)
+{
+    SectionShadow &shadow = m_getExistingShadow(index);
+    const size_uint stride = getSectionDescriptor(index).attributes.getStride();
+
+    if ((first_vertex + vertex_count) * stride > shadow.data.size())
+        throw std::logic_error("vertex range out of section bounds");
+
+    shadow.dirty_ranges.add(first_vertex * stride, (first_vertex + vertex_count) * stride);
+}
+
+void VertexBuffer::updateVertices(size_uint index, size_uint first_vertex, size_uint vertex_count, const void *data)
+{
+    markDirty(index, first_vertex, vertex_count);
+
+    const size_uint stride = getSectionDescriptor(index).attributes.getStride();
+    std::memcpy(getShadowCopy(index) + first_vertex * stride, data, vertex_count * stride);
+}
+
+void VertexBuffer::flushDirtyRanges(size_uint merge_gap)
+{
+    for (size_uint i = 0; i < m_shadows.size(); i++)
+    {
+        SectionShadow *shadow = m_shadows[i].get();
+        if (!shadow || shadow->dirty_ranges.empty())
+            continue;
+
+        shadow->dirty_ranges.coalesce(merge_gap);
+
+        const size_uint section_offset = m_sections[i].buffer_offset;
+        for (const auto &range: shadow->dirty_ranges.getRanges())
+            m_buffer.write(section_offset + range.begin, range.size(), shadow->data.data() + range.begin);
+
+        shadow->dirty_ranges.clear();
+    }
+}
+
+void VertexBuffer::flushDirtyRanges(Renderer::StreamBuffer &stream_buffer, size_uint merge_gap)
+{
+    size_uint dirty_size = 0;
+    for (const auto &shadow: m_shadows)
+    {
+        if (!shadow)
+            continue;
+
+        shadow->dirty_ranges.coalesce(merge_gap);
+        dirty_size += shadow->dirty_ranges.getSize();
+    }
+
+    if (dirty_size == 0)
+        return;
+
+    const auto allocation = stream_buffer.tryAllocate(dirty_size);
+    if (!allocation.has_value())
+    {
+        flushDirtyRanges(merge_gap);
+        return;
+    }
+
+    size_uint staged_offset = 0;
+    for (size_uint i = 0; i < m_shadows.size(); i++)
+    {
+        SectionShadow *shadow = m_shadows[i].get();
+        if (!shadow)
+            continue;
+
+        const size_uint section_offset = m_sections[i].buffer_offset;
+        for (const auto &range: shadow->dirty_ranges.getRanges())
+        {
+            std::memcpy(allocation->data + staged_offset, shadow->data.data() + range.begin, range.size());
+            GL::Buffer::copy(allocation->buffer, m_buffer, allocation->offset + staged_offset,
+                             section_offset + range.begin, range.size());
+            staged_offset += range.size();
+        }
+
+        shadow->dirty_ranges.clear();
+    }
+}
+
+bool VertexBuffer::compact(size_uint byte_budget,
+                           const std::function<void(size_uint section_index, size_uint old_offset)> &on_section_moved)
+{
+    if (m_compaction_order.size() != m_sections.size())
+    {
+        m_compaction_order.resize(m_sections.size());
+        std::iota(m_compaction_order.begin(), m_compaction_order.end(), 0);
+        std::sort(m_compaction_order.begin(), m_compaction_order.end(), [this](size_uint a, size_uint b)
+        { return m_sections[a].buffer_offset < m_sections[b].buffer_offset; });
+        m_compacted_count = 0;
+    }
+
+    size_uint bytes_moved = 0;
+
+    for (; m_compacted_count < m_compaction_order.size(); m_compacted_count++)
+    {
+        const auto index = m_compaction_order[m_compacted_count];
+        auto &section = m_sections[index];
+        const size_uint old_offset = section.buffer_offset;
+
+        // sections before this one are packed, so any space right before it is free
+        if (!m_allocator.canMoveDown(old_offset))
+            continue;
+
+        const size_uint size = section.getSize();
+        if (bytes_moved > 0 && bytes_moved + size > byte_budget)
+            return false;
+
+        const size_uint new_offset = *m_allocator.tryMoveDown(old_offset);
+        m_moveData(old_offset, new_offset, size);
+
+        section.buffer_offset = new_offset;
+        bytes_moved += size;
+
+        on_section_moved(index, old_offset);
+    }
+
+    m_compaction_scratch = GL::Buffer(GL::BufferHandle());
+    m_compaction_scratch_memory = {};
+
+    return true;
+}
+
+void VertexBuffer::m_moveData(size_uint old_offset, size_uint new_offset, size_uint size)
+{
+    if (old_offset - new_offset >= size)
+    {
+        GL::Buffer::copy(m_buffer, m_buffer, old_offset, new_offset, size);
+        return;
+    }
+
+    // the ranges overlap, so copy through the scratch buffer: two copies, however small the gap
+    if (m_compaction_scratch_memory.getSize() < size)
+    {
+        m_compaction_scratch = GL::Buffer();
+        m_compaction_scratch.allocateImmutable(size, GL::Buffer::StorageFlags::none);
+        m_compaction_scratch_memory = Renderer::TrackedMemory(Renderer::MemoryCategory::staging, size);
+    }
+
+    GL::Buffer::copy(m_buffer, m_compaction_scratch, old_offset, 0, size);
+    GL::Buffer::copy(m_compaction_scratch, m_buffer, 0, new_offset, size);
 }
 
 std::function<void (WBufferRef)>
@@ -0,0 +1,146 @@
+#include "simple_renderer/vertex_encoding.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Simple::Renderer {
+
+/// Conversion of normalized 16-bit integers as done by OpenGL.
+static std::int16_t toSnorm16(float value)
+{ return static_cast<std::int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f)); }
+
+static float fromSnorm16(std::int16_t value)
+{ return std::max(static_cast<float>(value) / 32767.0f, -1.0f); }
+
+/// Like std::copysign(1, value), but without NaN handling.
+static float signNotZero(float value)
+{ return value >= 0.0f ? 1.0f : -1.0f; }
+
+PositionQuantization PositionQuantization::fromBounds(const AxisAlignedBox &bounds)
+{
+    const glm::vec3 extents = bounds.getExtents();
+    const float scale = std::max({extents.x, extents.y, extents.z});
+
+    // a single point still needs a valid scale
+    return {bounds.getCenter(), scale > 0.0f ? scale : 1.0f};
+}
+
+glm::vec<4, std::int16_t> PositionQuantization::encode(const glm::vec3 &position) const
+{
+    const glm::vec3 normalized = (position - offset) / scale;
+    return {toSnorm16(normalized.x), toSnorm16(normalized.y), toSnorm16(normalized.z), 0};
+}
+
+glm::vec3 PositionQuantization::decode(const glm::vec<4, std::int16_t> &encoded) const
+{
+    return glm::vec3(fromSnorm16(encoded.x), fromSnorm16(encoded.y), fromSnorm16(encoded.z)) * scale + offset;
+}
+
+glm::mat4 PositionQuantization::getDequantizationTransform() const
+{
+    glm::mat4 transform(scale);
+    transform[3] = glm::vec4(offset, 1.0f);
+    return transform;
+}
+
+glm::vec<2, std::int16_t> encodeOctahedralNormal(const glm::vec3 &normal)
+{
+    // project onto the octahedron |x| + |y| + |z| = 1, then fold its lower half over the upper one
+    const float norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    float x = normal.x / norm;
+    float y = normal.y / norm;
+
+    if (normal.z < 0.0f)
+    {
+        const float folded_x = (1.0f - std::abs(y)) * signNotZero(x);
+        y = (1.0f - std::abs(x)) * signNotZero(y);
+        x = folded_x;
+    }
+
+    return {toSnorm16(x), toSnorm16(y)};
+}
+
+glm::vec3 decodeOctahedralNormal(const glm::vec<2, std::int16_t> &encoded)
+{
+    glm::vec3 normal(fromSnorm16(encoded.x), fromSnorm16(encoded.y), 0.0f);
+    normal.z = 1.0f - std::abs(normal.x) - std::abs(normal.y);
+
+    const float t = std::max(-normal.z, 0.0f);
+    normal.x += normal.x >= 0.0f ? -t : t;
+    normal.y += normal.y >= 0.0f ? -t : t;
+
+    return normal / std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+}
+
+glm::vec<2, std::uint16_t> encodeUnorm16(const glm::vec2 &uv)
+{
+    return {static_cast<std::uint16_t>(std::lround(std::clamp(uv.x, 0.0f, 1.0f) * 65535.0f)),
+            static_cast<std::uint16_t>(std::lround(std::clamp(uv.y, 0.0f, 1.0f) * 65535.0f))};
+}
+
+std::uint16_t encodeHalf(float value)
+{
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000u);
+    const std::uint32_t magnitude = bits & 0x7fffffffu;
+
+    // infinity and NaN, which stays a NaN
+    if (magnitude >= 0x7f800000u)
+        return static_cast<std::uint16_t>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x200u : 0u));
+
+    // 65520 and above round to infinity
+    if (magnitude >= 0x477ff000u)
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+
+    std::uint32_t result;
+    std::uint32_t remainder;
+    std::uint32_t halfway;
+
+    if (magnitude >= 0x38800000u)
+    {
+        // normal: rebias the exponent and drop 13 bits of mantissa; a carry correctly increments the exponent
+        result = (magnitude - 0x38000000u) >> 13;
+        remainder = magnitude & 0x1fffu;
+        halfway = 0x1000u;
+    }
+    else if (magnitude > 0x33000000u)
+    {
+        // subnormal: shift the mantissa, with its implicit bit, to units of 2^-24
+        const std::uint32_t shift = 126 - (magnitude >> 23);
+        const std::uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+        result = mantissa >> shift;
+        remainder = mantissa & ((1u << shift) - 1);
+        halfway = 1u << (shift - 1);
+    }
+    else
+    {
+        // at most half the smallest subnormal
+        return sign;
+    }
+
+    if (remainder > halfway || (remainder == halfway && (result & 1u)))
+        result++;
+
+    return static_cast<std::uint16_t>(sign | result);
+}
+
+float decodeHalf(std::uint16_t value)
+{
+    const int exponent = (value >> 10) & 0x1f;
+    const int mantissa = value & 0x3ff;
+
+    float magnitude;
+    if (exponent == 0)
+        magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+    else if (exponent == 0x1f)
+        magnitude = mantissa ? NAN : INFINITY;
+    else
+        magnitude = std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+
+    return value & 0x8000u ? -magnitude : magnitude;
+}
+
+} // Simple::Renderer
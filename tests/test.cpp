@@ -2,8 +2,42 @@
 #include "catch.hpp"
 
 #include "simple_renderer/vertex_buffer.hpp"
+#include "simple_renderer/dynamic_vertex_buffer.hpp"
+#include "simple_renderer/allocation_registry.hpp"
+#include "simple_renderer/dirty_range_set.hpp"
+#include "simple_renderer/radix_sort.hpp"
+#include "simple_renderer/frustum_culling.hpp"
+#include "simple_renderer/state_cache.hpp"
+#include "simple_renderer/frame_capture.hpp"
+#include "simple_renderer/memory_tracker.hpp"
+#include "simple_renderer/vertex_encoding.hpp"
+#include "simple_renderer/mesh.hpp"
+#include "simple_renderer/geometry_arena.hpp"
+#include "simple_renderer/instanced_mesh.hpp"
+#include "simple_renderer/render_queue.hpp"
+#include "simple_renderer/render_list.hpp"
+#include "simple_renderer/glsl_definitions.hpp"
+#include "simple_renderer/frame_profiler.hpp"
+#include "simple_renderer/renderer.hpp"
+#include "simple_renderer/camera.hpp"
+#include "simple_renderer/shader_program.hpp"
+#include "simple_renderer/readback_buffer.hpp"
+#include "simple_renderer/stream_buffer.hpp"
+#include "simple_renderer/upload_queue.hpp"
+#include "simple_renderer/vertex_attribute_specification.hpp"
 
 #include "glm/glm.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <thread>
 
 namespace Catch::Generators {
 
@@ -83,6 +117,37 @@ auto readSection(const Simple::Renderer::VertexBuffer<Ts...>& vertex_buffer)
     return values;
 }
 
+/// Shaders for tests which draw through a RenderQueue.
+constexpr auto test_vertex_shader = R"glsl(
+void main()
+{
+    gl_Position = proj_matrix * view_matrix * model_matrix * vec4(vertex_position, 1.0f);
+}
+)glsl";
+
+constexpr auto test_fragment_shader = R"glsl(
+void main()
+{
+    frag_color = vec4(1.0f);
+}
+)glsl";
+
+/// The model matrices in the buffer range bound to the model matrix block, as last bound by a RenderQueue.
+std::vector<glm::mat4> readBoundModelMatrices()
+{
+    GLint buffer = 0;
+    GLint64 offset = 0;
+    GLint64 size = 0;
+    glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, Simple::model_matrix_block_binding, &buffer);
+    glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_START, Simple::model_matrix_block_binding, &offset);
+    glGetInteger64i_v(GL_SHADER_STORAGE_BUFFER_SIZE, Simple::model_matrix_block_binding, &size);
+
+    std::vector<glm::mat4> matrices(static_cast<std::size_t>(size) / sizeof(glm::mat4));
+    glGetNamedBufferSubData(static_cast<GLuint>(buffer), offset, static_cast<GLsizeiptr>(size), matrices.data());
+
+    return matrices;
+}
+
 TEST_CASE("Single-type VertexBuffer")
 {
     auto values = GENERATE(take(1, chunk(100, vec3(random(std::numeric_limits<float>::lowest(),
@@ -111,4 +176,1493 @@ TEST_CASE("Multi-type VertexBuffer")
     CHECK(a_values == readSection<0>(vertex_buffer));
     CHECK(b_values == readSection<1>(vertex_buffer));
     CHECK(c_values == readSection<2>(vertex_buffer));
-}
\ No newline at end of file
+
+    Simple::Renderer::VertexBuffer<glm::vec2, glm::vec3, glm::ivec4> parallel_vertex_buffer
+    {
+        std::launch::async, a_values, b_values, c_values
+    };
+
+    CHECK(a_values == readSection<0>(parallel_vertex_buffer));
+    CHECK(b_values == readSection<1>(parallel_vertex_buffer));
+    CHECK(c_values == readSection<2>(parallel_vertex_buffer));
+}
+
+TEST_CASE("Dynamic VertexBuffer")
+{
+    auto values = GENERATE(take(1, chunk(300, random(std::numeric_limits<int>::lowest(),
+                                                     std::numeric_limits<int>::max()))));
+
+    const auto read = [](const Simple::Renderer::DynamicVertexBuffer<int> &buffer)
+    {
+        std::vector<int> result(buffer.size());
+        buffer.getBuffer().getGLHandle().read(0, result.size() * sizeof(int), result.data());
+        return result;
+    };
+
+    Simple::Renderer::DynamicVertexBuffer<int> buffer;
+    std::vector<int> expected;
+
+    // small appends make the storage grow several times
+    for (std::size_t i = 0; i < values.size(); i += 30)
+    {
+        const std::vector<int> part(values.begin() + i, values.begin() + i + 30);
+        CHECK(buffer.append(part) == expected.size());
+        expected.insert(expected.end(), part.begin(), part.end());
+    }
+
+    CHECK(buffer.capacity() >= buffer.size());
+    CHECK(read(buffer) == expected);
+
+    const std::vector<int> update(10, 7);
+    buffer.update(50, update);
+    std::copy(update.begin(), update.end(), expected.begin() + 50);
+    CHECK(read(buffer) == expected);
+
+    // both a short and a long tail after the erased range
+    buffer.erase(250, 20);
+    expected.erase(expected.begin() + 250, expected.begin() + 270);
+    buffer.erase(3, 5);
+    expected.erase(expected.begin() + 3, expected.begin() + 8);
+    CHECK(read(buffer) == expected);
+}
+
+TEST_CASE("Stream buffer")
+{
+    using Simple::WBufferRef;
+    using Simple::Renderer::StreamBuffer;
+
+    std::vector<std::byte> data(2048);
+    for (std::size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<std::byte>(i * 5 + 3);
+
+    GL::Buffer destination;
+    destination.allocateImmutable(static_cast<GLsizeiptr>(data.size()), GL::Buffer::StorageFlags::dynamic_storage);
+    const auto read_destination = [&destination](std::size_t offset, std::size_t size)
+    {
+        std::vector<std::byte> result(size);
+        destination.read(offset, size, result.data());
+        return result;
+    };
+    const auto slice = [&data](std::size_t offset, std::size_t size)
+    { return std::vector<std::byte>(data.begin() + offset, data.begin() + offset + size); };
+
+    // regions are rounded up to 256 bytes
+    StreamBuffer stream_buffer(100, 3);
+    REQUIRE(stream_buffer.getRegionSize() == 256);
+    CHECK(stream_buffer.getRegionCount() == 3);
+
+    SECTION("Allocation")
+    {
+        CHECK(stream_buffer.allocate(3).offset == 0);
+
+        const auto aligned = stream_buffer.allocate(8, 16);
+        CHECK(aligned.offset == 16);
+        CHECK(aligned.size == 8);
+        CHECK(stream_buffer.getUsedSize() == 24);
+
+        // the region is full
+        CHECK_FALSE(stream_buffer.tryAllocate(256 - 24 + 1).has_value());
+        CHECK_THROWS_AS(stream_buffer.allocate(256), std::logic_error);
+        CHECK(stream_buffer.getUsedSize() == 24);
+
+        CHECK(stream_buffer.allocate(256 - 24).offset == 24);
+        CHECK_FALSE(stream_buffer.tryAllocate(1).has_value());
+    }
+
+    SECTION("Upload")
+    {
+        // too big for a region: written directly
+        stream_buffer.upload(WBufferRef(destination, 0, 512), data.data());
+        CHECK(stream_buffer.getUsedSize() == 0);
+        CHECK(read_destination(0, 512) == slice(0, 512));
+
+        // staged and copied by the GPU
+        stream_buffer.upload(WBufferRef(destination, 512, 64), data.data() + 512);
+        CHECK(stream_buffer.getUsedSize() == 64);
+        CHECK(read_destination(512, 64) == slice(512, 64));
+    }
+
+    SECTION("Region rotation")
+    {
+        // an unused region stays current
+        stream_buffer.finishFrame();
+        CHECK(stream_buffer.allocate(4).offset == 0);
+
+        for (std::size_t frame = 1; frame <= 4; frame++)
+        {
+            stream_buffer.finishFrame();
+            CHECK(stream_buffer.getUsedSize() == 0);
+
+            // the third frame is back to the first region, which is reused once its fence is signaled
+            const std::size_t region = frame % 3;
+            const auto allocation = stream_buffer.write(data.data() + frame * 16, 16, 4);
+            CHECK(allocation.offset == region * 256);
+
+            WBufferRef(destination, frame * 16, 16).copyFrom(allocation.getReadRef());
+        }
+
+        CHECK(read_destination(16, 64) == slice(16, 64));
+    }
+
+    SECTION("Growth")
+    {
+        // a frame in flight when the buffer grows
+        stream_buffer.upload(WBufferRef(destination, 128, 64), data.data() + 128);
+        stream_buffer.finishFrame();
+        stream_buffer.upload(WBufferRef(destination, 256, 64), data.data() + 256);
+
+        stream_buffer.reserve(1000);
+        CHECK(stream_buffer.getRegionSize() == 1024);
+        CHECK(stream_buffer.getUsedSize() == 0);
+
+        stream_buffer.upload(WBufferRef(destination, 1024, 1000), data.data() + 1024);
+        CHECK(stream_buffer.getUsedSize() == 1000);
+
+        CHECK(read_destination(128, 64) == slice(128, 64));
+        CHECK(read_destination(256, 64) == slice(256, 64));
+        CHECK(read_destination(1024, 1000) == slice(1024, 1000));
+
+        // reserving less than the current size does nothing
+        stream_buffer.reserve(10);
+        CHECK(stream_buffer.getRegionSize() == 1024);
+        CHECK(stream_buffer.getUsedSize() == 1000);
+    }
+}
+
+TEST_CASE("Upload queue")
+{
+    using Simple::WBufferRef;
+    using Simple::Renderer::MemoryCategory;
+    using Simple::Renderer::MemoryTracker;
+    using Simple::Renderer::UploadQueue;
+
+    constexpr std::size_t byte_budget = 256;
+    const std::size_t base_staging_usage = MemoryTracker::get().getUsage(MemoryCategory::staging);
+
+    std::vector<std::byte> expected(2000);
+    for (std::size_t i = 0; i < expected.size(); i++)
+        expected[i] = static_cast<std::byte>(i * 7);
+
+    const Simple::Renderer::Buffer destination(expected.size());
+    const auto destination_range = [&destination](std::size_t offset, std::size_t size)
+    { return WBufferRef(destination.getGLHandle(), offset, size); };
+
+    UploadQueue queue(byte_budget);
+
+    // a big buffer upload, which is split, a small one, a small copy job and one bigger than the budget
+    const auto a = queue.enqueue(destination_range(0, 600), expected.data());
+    const auto b = queue.enqueue(destination_range(600, 300), expected.data() + 600);
+    const auto c = queue.enqueue(std::vector<std::byte>(expected.begin() + 900, expected.begin() + 1000),
+                                 [range = destination_range(900, 100)](Simple::RBufferRef staged) mutable
+                                 { range.copyFrom(staged); });
+    const auto d = queue.enqueue(std::vector<std::byte>(expected.begin() + 1000, expected.end()),
+                                 [range = destination_range(1000, 1000)](Simple::RBufferRef staged) mutable
+                                 { range.copyFrom(staged); });
+    CHECK(queue.getPendingSize() == expected.size());
+
+    std::vector<UploadQueue::Ticket> tickets {a, b, c, d};
+    for (std::size_t i = 1; i < tickets.size(); i++)
+        CHECK(tickets[i - 1] < tickets[i]);
+
+    std::size_t update_count = 0;
+    while (queue.getPendingSize() > 0)
+    {
+        const std::size_t pending_size = queue.getPendingSize();
+        queue.update();
+        update_count++;
+
+        // only the job bigger than the budget may exceed it, and the staging buffer never grows beyond it
+        CHECK((pending_size - queue.getPendingSize() <= byte_budget || pending_size == 1000));
+        CHECK(MemoryTracker::get().getUsage(MemoryCategory::staging) - base_staging_usage <= 3 * byte_budget);
+
+        // tickets complete in order
+        for (std::size_t i = 1; i < tickets.size(); i++)
+            CHECK((!queue.isComplete(tickets[i]) || queue.isComplete(tickets[i - 1])));
+    }
+
+    // 256 + 256 + (88 + 168) + (132 + 100) + 1000 bytes
+    CHECK(update_count == 5);
+
+    queue.finish();
+    for (const auto ticket: tickets)
+        CHECK(queue.isComplete(ticket));
+
+    std::vector<std::byte> result(expected.size());
+    destination.getGLHandle().read(0, result.size(), result.data());
+    CHECK(result == expected);
+}
+
+TEST_CASE("Readback buffer")
+{
+    using Simple::RBufferRef;
+    using Simple::Renderer::ReadbackBuffer;
+
+    constexpr std::size_t slot_size = 64;
+
+    std::vector<std::byte> contents(8 * slot_size);
+    for (std::size_t i = 0; i < contents.size(); i++)
+        contents[i] = static_cast<std::byte>(i * 13 + 1);
+
+    const Simple::Renderer::Buffer source(contents.size(), contents.data());
+    const auto source_slot = [&source](std::size_t index)
+    { return RBufferRef(source.getGLHandle(), index * slot_size, slot_size); };
+    const auto matches = [&contents](const ReadbackBuffer::Readback &readback, std::size_t index)
+    {
+        return readback.getSize() == slot_size &&
+               std::equal(readback.getData(), readback.getData() + slot_size, contents.begin() + index * slot_size);
+    };
+
+    ReadbackBuffer readback_buffer(4 * slot_size);
+    CHECK(readback_buffer.getCapacity() == 4 * slot_size);
+
+    SECTION("Data")
+    {
+        // an unaligned range
+        auto readback = readback_buffer.readAsync(RBufferRef(source.getGLHandle(), 3, 100));
+        std::vector<std::byte> result(readback.getSize());
+        readback.read(result.data());
+        CHECK(readback.isReady());
+        CHECK(std::equal(result.begin(), result.end(), contents.begin() + 3));
+    }
+
+    SECTION("Reuse")
+    {
+        std::vector<ReadbackBuffer::Readback> readbacks;
+        for (std::size_t i = 0; i < 4; i++)
+            readbacks.push_back(readback_buffer.readAsync(source_slot(i)));
+
+        CHECK_FALSE(readback_buffer.tryReadAsync(source_slot(4)).has_value());
+        CHECK_THROWS_AS(readback_buffer.readAsync(source_slot(4)), std::logic_error);
+
+        for (std::size_t i = 0; i < 4; i++)
+            CHECK(matches(readbacks[i], i));
+
+        const std::byte *first_data = readbacks[0].getData();
+        const std::byte *second_data = readbacks[1].getData();
+
+        // out of order: the space of the second readback is kept until the first one is released too
+        readbacks[1] = {};
+        CHECK_FALSE(readback_buffer.tryReadAsync(source_slot(4)).has_value());
+
+        readbacks[0] = {};
+        auto wrapped = readback_buffer.tryReadAsync(source_slot(4));
+        REQUIRE(wrapped.has_value());
+        CHECK(wrapped->getData() == first_data);
+        CHECK(matches(*wrapped, 4));
+
+        auto wrapped_next = readback_buffer.tryReadAsync(source_slot(5));
+        REQUIRE(wrapped_next.has_value());
+        CHECK(wrapped_next->getData() == second_data);
+        CHECK(matches(*wrapped_next, 5));
+
+        // the head has caught up with the third readback
+        CHECK_FALSE(readback_buffer.tryReadAsync(source_slot(6)).has_value());
+
+        // the space only frees up once every readback before it is released
+        readbacks[3] = {};
+        CHECK_FALSE(readback_buffer.tryReadAsync(source_slot(6)).has_value());
+
+        readbacks[2] = {};
+        auto after_release = readback_buffer.tryReadAsync(source_slot(6));
+        REQUIRE(after_release.has_value());
+        CHECK(matches(*after_release, 6));
+
+        // the readbacks are released before the buffer
+        wrapped.reset();
+        wrapped_next.reset();
+        after_release.reset();
+    }
+}
+
+TEST_CASE("VertexBuffer compaction")
+{
+    constexpr std::size_t section_count = 5;
+    constexpr std::size_t vertex_count = 100;
+    constexpr std::size_t section_size = vertex_count * sizeof(int);
+
+    std::vector<std::vector<int>> contents(section_count, std::vector<int>(vertex_count));
+    for (std::size_t i = 0; i < section_count; i++)
+        std::iota(contents[i].begin(), contents[i].end(), static_cast<int>(i * 1000));
+
+    Simple::VertexBuffer vertex_buffer(section_count * section_size);
+    Simple::VertexAttributeSpecification specification;
+
+    for (std::size_t i = 0; i < section_count; i++)
+    {
+        vertex_buffer.addAttributeData(contents[i].data(), vertex_count,
+                                       Simple::VertexAttributeSequence().addAttribute<int>());
+        specification.bindAttributes(vertex_buffer, vertex_buffer[i], std::array<int, 1>{static_cast<int>(i)});
+    }
+
+    const auto get_binding_offset = [&specification](GLuint binding_index)
+    {
+        GLint64 offset = -1;
+        glGetVertexArrayIndexed64iv(specification.getVertexArrayHandle().getName(), binding_index,
+                                    GL_VERTEX_BINDING_OFFSET, &offset);
+        return static_cast<std::uint64_t>(offset);
+    };
+
+    // discard a section in the middle; the following ones shift down by one index
+    vertex_buffer.discardAttributeData(1);
+    specification.unbindAttribute(1);
+    contents.erase(contents.begin() + 1);
+
+    const auto old_offsets = [&vertex_buffer]
+    {
+        std::vector<std::uint64_t> offsets;
+        for (const auto &section: vertex_buffer)
+            offsets.push_back(section.buffer_offset);
+        return offsets;
+    }();
+
+    // the budget only allows moving one section per call
+    std::size_t call_count = 0;
+    std::vector<std::size_t> moved_sections;
+    bool compacted = false;
+    while (!compacted && call_count < section_count)
+    {
+        const std::size_t moved_before = moved_sections.size();
+        compacted = vertex_buffer.compact(section_size, [&](std::uint64_t section_index, std::uint64_t old_offset)
+        {
+            CHECK(old_offset == old_offsets[section_index]);
+            specification.rebindSection(vertex_buffer, vertex_buffer[section_index], old_offset);
+            moved_sections.push_back(section_index);
+        });
+        call_count++;
+
+        CHECK(moved_sections.size() - moved_before <= 1);
+    }
+
+    CHECK(compacted);
+    CHECK(call_count == 3);
+    CHECK(moved_sections == std::vector<std::size_t>{1, 2, 3});
+    CHECK(vertex_buffer.getMaxNewSectionSize() == section_size);
+
+    for (std::size_t i = 0; i < contents.size(); i++)
+    {
+        const auto &section = vertex_buffer[i];
+        CHECK(section.buffer_offset == i * section_size);
+
+        std::vector<int> data(vertex_count);
+        vertex_buffer.getBufferHandle().read(section.buffer_offset, section_size, data.data());
+        CHECK(data == contents[i]);
+
+        // each section got its own buffer binding, in order; binding 1 belonged to the discarded one
+        const GLuint binding_index = i == 0 ? 0 : static_cast<GLuint>(i + 1);
+        CHECK(get_binding_offset(binding_index) == section.buffer_offset);
+    }
+
+    // a gap much smaller than the section that follows it
+    Simple::VertexBuffer small_gap_buffer(section_size + sizeof(int));
+    const int gap_value = -1;
+    small_gap_buffer.addAttributeData(&gap_value, 1, Simple::VertexAttributeSequence().addAttribute<int>());
+    small_gap_buffer.addAttributeData(contents[0].data(), vertex_count,
+                                      Simple::VertexAttributeSequence().addAttribute<int>());
+    small_gap_buffer.discardAttributeData(0);
+
+    CHECK(small_gap_buffer.compact(section_size, [](std::uint64_t, std::uint64_t) {}));
+    CHECK(small_gap_buffer[0].buffer_offset == 0);
+
+    std::vector<int> moved_data(vertex_count);
+    small_gap_buffer.getBufferHandle().read(0, section_size, moved_data.data());
+    CHECK(moved_data == contents[0]);
+}
+
+TEST_CASE("VertexBuffer shadow copies")
+{
+    constexpr std::size_t vertex_count = 64;
+    constexpr std::size_t section_size = vertex_count * sizeof(int);
+
+    std::vector<int> first_contents(vertex_count);
+    std::vector<int> second_contents(vertex_count);
+    std::iota(first_contents.begin(), first_contents.end(), 0);
+    std::iota(second_contents.begin(), second_contents.end(), 1000);
+
+    Simple::VertexBuffer vertex_buffer(2 * section_size);
+    vertex_buffer.addAttributeData(first_contents.data(), vertex_count,
+                                   Simple::VertexAttributeSequence().addAttribute<int>());
+    vertex_buffer.addAttributeData(second_contents.data(), vertex_count,
+                                   Simple::VertexAttributeSequence().addAttribute<int>());
+
+    const auto read_section = [&](std::size_t index)
+    {
+        std::vector<int> data(vertex_count);
+        vertex_buffer.getBufferHandle().read(vertex_buffer[index].buffer_offset, section_size, data.data());
+        return data;
+    };
+
+    vertex_buffer.enableShadowCopy(1);
+    REQUIRE(vertex_buffer.hasShadowCopy(1));
+    CHECK_FALSE(vertex_buffer.hasShadowCopy(0));
+    CHECK(std::memcmp(vertex_buffer.getShadowCopy(1), second_contents.data(), section_size) == 0);
+
+    // a few scattered edits
+    std::vector<int> expected = second_contents;
+    const std::array<int, 3> edit {-1, -2, -3};
+    vertex_buffer.updateVertices(1, 2, edit.size(), edit.data());
+    std::copy(edit.begin(), edit.end(), expected.begin() + 2);
+
+    reinterpret_cast<int *>(vertex_buffer.getShadowCopy(1))[40] = -40;
+    vertex_buffer.markDirty(1, 40, 1);
+    expected[40] = -40;
+
+    // nothing reaches the GPU before the flush
+    CHECK(read_section(1) == second_contents);
+
+    SECTION("Direct writes")
+    {
+        vertex_buffer.flushDirtyRanges();
+        CHECK(read_section(1) == expected);
+    }
+
+    SECTION("Stream buffer")
+    {
+        Simple::Renderer::StreamBuffer stream_buffer(256);
+        vertex_buffer.flushDirtyRanges(stream_buffer, 0);
+        CHECK(stream_buffer.getUsedSize() == (edit.size() + 1) * sizeof(int));
+        CHECK(read_section(1) == expected);
+    }
+
+    SECTION("Stream buffer full")
+    {
+        Simple::Renderer::StreamBuffer stream_buffer(256);
+        static_cast<void>(stream_buffer.allocate(stream_buffer.getRegionSize()));
+
+        vertex_buffer.flushDirtyRanges(stream_buffer);
+        CHECK(read_section(1) == expected);
+    }
+
+    SECTION("Merge gap")
+    {
+        // overwrite vertices between the two edits on the GPU only, to tell whether a flush writes them
+        const std::vector<int> sentinel(35, 7);
+        const auto write_sentinel = [&]
+        {
+            vertex_buffer.getBufferHandle().write(vertex_buffer[1].buffer_offset + 5 * sizeof(int),
+                                                  sentinel.size() * sizeof(int), sentinel.data());
+        };
+        write_sentinel();
+
+        // 35 vertices apart: not merged
+        vertex_buffer.flushDirtyRanges(34 * sizeof(int));
+        std::vector<int> unmerged = expected;
+        std::copy(sentinel.begin(), sentinel.end(), unmerged.begin() + 5);
+        CHECK(read_section(1) == unmerged);
+
+        // merged into a single write, which also restores the vertices in between
+        write_sentinel();
+        vertex_buffer.markDirty(1, 2, 3);
+        vertex_buffer.markDirty(1, 40, 1);
+        vertex_buffer.flushDirtyRanges(35 * sizeof(int));
+        CHECK(read_section(1) == expected);
+    }
+
+    // the section without a shadow copy is never written
+    CHECK(read_section(0) == first_contents);
+}
+
+TEST_CASE("Dynamic InstancedMesh")
+{
+    using namespace Simple::Renderer;
+
+    constexpr std::size_t max_value_count = 8;
+    constexpr std::size_t region_count = 3;
+    constexpr std::size_t region_size = 256;    // max_value_count * sizeof(glm::vec3), rounded up by StreamBuffer
+    constexpr std::uint32_t instance_binding = 3;
+
+    const ShaderProgram program(R"glsl(
+layout(location = 4) in vec3 a_offset;
+
+void main()
+{
+    gl_Position = proj_matrix * view_matrix * model_matrix * vec4(vertex_position + a_offset, 1.0f);
+}
+)glsl", R"glsl(
+void main()
+{
+    frag_color = vec4(1.0f);
+}
+)glsl");
+
+    const std::vector<glm::vec3> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+    InstancedMesh<glm::vec3> instanced_mesh(Mesh(positions, {}, {}), AttribIndex(4), max_value_count, 1,
+                                            region_count);
+    CHECK(instanced_mesh.isDynamic());
+
+    // the dequantization transform of compressed positions would also scale the instance attributes
+    const VertexEncoding snorm16_positions{PositionEncoding::snorm16};
+    CHECK_THROWS_AS(InstancedMesh<glm::vec3>(Mesh(positions, {}, {}, {}, MeshLayout::planar, snorm16_positions),
+                                             AttribIndex(4), max_value_count, 1, region_count), std::logic_error);
+
+    const Camera camera;
+    RenderQueue render_queue;
+    render_queue.setFrustumCulling(false);
+
+    const auto capture_frame = [&]
+    {
+        FrameCapture capture;
+        render_queue.captureNextFrame(capture);
+        render_queue.draw(instanced_mesh, program, glm::mat4(1.0f));
+        render_queue.finishFrame(camera);
+        return capture;
+    };
+
+    // nothing to draw before the first update
+    CHECK(capture_frame().commands.empty());
+
+    for (std::size_t frame = 0; frame < 2 * region_count + 1; frame++)
+    {
+        std::vector<glm::vec3> offsets(frame % max_value_count + 1);
+        for (std::size_t i = 0; i < offsets.size(); i++)
+            offsets[i] = glm::vec3(static_cast<float>(frame), static_cast<float>(i), 0.0f);
+
+        instanced_mesh.setInstanceData(offsets);
+        CHECK(instanced_mesh.getInstanceCount() == offsets.size());
+
+        const FrameCapture capture = capture_frame();
+        REQUIRE(capture.commands.size() == 1);
+        CHECK(capture.commands[0].instance_count == offsets.size());
+
+        // the instance buffer binding points at the region of this frame, which holds the new values
+        const auto &bindings = capture.vertex_arrays.at(capture.commands[0].vertex_array).bindings;
+        const auto binding = std::find_if(bindings.begin(), bindings.end(),
+                                          [](const auto &binding) { return binding.index == instance_binding; });
+        REQUIRE(binding != bindings.end());
+        CHECK(binding->stride == sizeof(glm::vec3));
+        CHECK(binding->divisor == 1);
+        CHECK(binding->offset == frame % region_count * region_size);
+
+        const auto &buffer_data = capture.buffers.at(binding->buffer).data;
+        REQUIRE(binding->offset + offsets.size() * sizeof(glm::vec3) <= buffer_data.size());
+        std::vector<glm::vec3> bound(offsets.size());
+        std::memcpy(bound.data(), buffer_data.data() + binding->offset, bound.size() * sizeof(glm::vec3));
+        CHECK(bound == offsets);
+    }
+}
+
+TEST_CASE("RenderList")
+{
+    using namespace Simple::Renderer;
+
+    const ShaderProgram program(test_vertex_shader, test_fragment_shader);
+    const std::vector<glm::vec3> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+    Mesh triangles(positions, {}, {});
+    const Mesh points(positions, {}, {});
+
+    const Camera camera;
+    RenderQueue render_queue;
+    RenderList render_list;
+
+    const auto capture_frame = [&]
+    {
+        FrameCapture capture;
+        render_queue.captureNextFrame(capture);
+        render_queue.draw(render_list);
+        render_queue.finishFrame(camera);
+        return capture;
+    };
+
+    const auto translation = [](std::size_t i)
+    { return glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i), 0.0f, 0.0f)); };
+
+    constexpr std::size_t draw_count = 20;
+    std::vector<RenderList::DrawHandle> handles;
+    for (std::size_t i = 0; i < draw_count; i++)
+        handles.push_back(render_list.add(triangles, program, translation(i)));
+
+    SECTION("Commands and their order are kept between frames")
+    {
+        const FrameCapture first = capture_frame();
+        REQUIRE(first.commands.size() == draw_count);
+        CHECK(first.commands[0].mode == GL_TRIANGLES);
+
+        // the commands of a drawable are only collected again when asked to
+        triangles.draw_mode = Simple::DrawMode::points;
+        render_list.setTransform(handles[0], translation(100));
+        render_list.setLayer(handles[1], 1);
+
+        const FrameCapture second = capture_frame();
+        REQUIRE(second.commands.size() == draw_count);
+        CHECK(second.commands[0].mode == GL_TRIANGLES);
+        CHECK(second.draws.at(second.commands[0].draw).model_matrix == translation(100));
+        CHECK(second.draws.at(second.commands[1].draw).layer == 1);
+
+        render_list.invalidate(handles[0]);
+
+        const FrameCapture third = capture_frame();
+        REQUIRE(third.commands.size() == draw_count);
+        CHECK(third.commands[0].mode == GL_POINTS);
+        CHECK(third.commands[1].mode == GL_TRIANGLES);
+    }
+
+    SECTION("Changing the drawable or removing a draw rebuilds the sequence")
+    {
+        const FrameCapture first = capture_frame();
+        REQUIRE(first.commands.size() == draw_count);
+
+        render_list.setDrawable(handles[0], points);
+        render_list.remove(handles[1]);
+        CHECK(render_list.size() == draw_count - 1);
+
+        const FrameCapture second = capture_frame();
+        REQUIRE(second.commands.size() == draw_count - 1);
+        CHECK(second.commands[0].vertex_array != second.commands[1].vertex_array);
+        CHECK(second.draws.at(second.commands[1].draw).model_matrix == translation(2));
+
+        // handles of removed draws are reused
+        CHECK(render_list.add(triangles, program, translation(1)) == handles[1]);
+        CHECK(capture_frame().commands.size() == draw_count);
+        CHECK_THROWS_AS(render_list.setTransform(static_cast<RenderList::DrawHandle>(draw_count), glm::mat4(1.0f)),
+                        std::logic_error);
+    }
+
+    SECTION("Changed model matrices are uploaded in runs")
+    {
+        capture_frame();
+
+        std::vector<glm::mat4> expected(draw_count);
+        for (std::size_t i = 0; i < draw_count; i++)
+            expected[i] = translation(i);
+        CHECK(readBoundModelMatrices() == expected);
+
+        // overwrite the uploaded matrices, to see which ones the next upload rewrites
+        GLint buffer = 0;
+        glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, Simple::model_matrix_block_binding, &buffer);
+        const std::vector<glm::mat4> overwritten(draw_count, glm::mat4(0.0f));
+        glNamedBufferSubData(static_cast<GLuint>(buffer), 0, static_cast<GLsizeiptr>(draw_count * sizeof(glm::mat4)),
+                             overwritten.data());
+
+        // 0 and 4 are within the gap of unchanged matrices uploaded together, 10 and 16 are not
+        for (const std::size_t i: {0, 4, 10, 16})
+        {
+            expected[i] = translation(i + 100);
+            render_list.setTransform(handles[i], expected[i]);
+        }
+        capture_frame();
+
+        const std::vector<glm::mat4> uploaded = readBoundModelMatrices();
+        REQUIRE(uploaded.size() == draw_count);
+        for (std::size_t i = 0; i < draw_count; i++)
+        {
+            const bool rewritten = i <= 4 || i == 10 || i == 16;
+            CHECK(uploaded[i] == (rewritten ? expected[i] : glm::mat4(0.0f)));
+        }
+    }
+
+    SECTION("The model matrix buffer grows")
+    {
+        capture_frame();
+
+        GLint buffer = 0;
+        GLint64 initial_size = 0;
+        glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, Simple::model_matrix_block_binding, &buffer);
+        glGetNamedBufferParameteri64v(static_cast<GLuint>(buffer), GL_BUFFER_SIZE, &initial_size);
+
+        const std::size_t grown_count = static_cast<std::size_t>(initial_size) / sizeof(glm::mat4) + 1;
+        for (std::size_t i = draw_count; i < grown_count; i++)
+            handles.push_back(render_list.add(triangles, program, translation(i)));
+        CHECK(capture_frame().commands.size() == grown_count);
+
+        GLint64 grown_size = 0;
+        glGetIntegeri_v(GL_SHADER_STORAGE_BUFFER_BINDING, Simple::model_matrix_block_binding, &buffer);
+        glGetNamedBufferParameteri64v(static_cast<GLuint>(buffer), GL_BUFFER_SIZE, &grown_size);
+        CHECK(static_cast<std::size_t>(grown_size) >= grown_count * sizeof(glm::mat4));
+
+        // the matrices of the existing draws are kept
+        const std::vector<glm::mat4> uploaded = readBoundModelMatrices();
+        REQUIRE(uploaded.size() == grown_count);
+        for (std::size_t i = 0; i < grown_count; i++)
+            CHECK(uploaded[i] == translation(i));
+    }
+}
+
+TEST_CASE("RenderQueue recorders")
+{
+    using namespace Simple::Renderer;
+
+    const ShaderProgram program(test_vertex_shader, test_fragment_shader);
+    const std::vector<glm::vec3> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+    const Mesh mesh(positions, {}, {});
+
+    const Camera camera;
+    RenderQueue render_queue;
+    render_queue.setFrustumCulling(false);
+
+    constexpr std::size_t recorder_count = 4;
+    constexpr std::size_t draws_per_recorder = 50;
+    render_queue.setRecorderCount(recorder_count);
+    REQUIRE(render_queue.getRecorderCount() == recorder_count);
+    CHECK_THROWS_AS(render_queue.getRecorder(recorder_count), std::out_of_range);
+
+    // the matrix of each draw identifies its recorder; the queue's own draw() comes first
+    const auto model_transform = [](std::size_t recorder, std::size_t draw)
+    {
+        return glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(recorder), static_cast<float>(draw),
+                                                         0.0f));
+    };
+
+    std::vector<glm::mat4> expected;
+    render_queue.draw(mesh, program, model_transform(0, 0));
+    expected.push_back(model_transform(0, 0));
+
+    std::vector<std::thread> threads;
+    for (std::size_t recorder = 0; recorder < recorder_count; recorder++)
+    {
+        threads.emplace_back([&, recorder]
+        {
+            RenderQueue::Recorder &target = render_queue.getRecorder(recorder);
+            for (std::size_t draw = 0; draw < draws_per_recorder; draw++)
+                target.draw(mesh, program, model_transform(recorder + 1, draw));
+        });
+    }
+    for (std::thread &thread: threads)
+        thread.join();
+
+    for (std::size_t recorder = 0; recorder < recorder_count; recorder++)
+        for (std::size_t draw = 0; draw < draws_per_recorder; draw++)
+            expected.push_back(model_transform(recorder + 1, draw));
+
+    FrameCapture capture;
+    render_queue.captureNextFrame(capture);
+    render_queue.finishFrame(camera);
+
+    // every draw is executed once, and the draws of each recorder follow those of the previous one
+    REQUIRE(capture.draws.size() == expected.size());
+    CHECK(capture.commands.size() == expected.size());
+    for (std::size_t i = 0; i < expected.size(); i++)
+        CHECK(capture.draws[i].model_matrix == expected[i]);
+
+    // model matrices are uploaded in the same order, which gives the index each command reads its matrix from
+    CHECK(readBoundModelMatrices() == expected);
+
+    // recorders are emptied by finishFrame(), and references to remaining recorders stay valid
+    RenderQueue::Recorder &first = render_queue.getRecorder(0);
+    render_queue.setRecorderCount(1);
+    CHECK(&render_queue.getRecorder(0) == &first);
+    CHECK_THROWS_AS(render_queue.getRecorder(1), std::out_of_range);
+
+    first.draw(mesh, program, model_transform(1, 0));
+    render_queue.captureNextFrame(capture);
+    render_queue.finishFrame(camera);
+    REQUIRE(capture.draws.size() == 1);
+    CHECK(capture.draws[0].model_matrix == model_transform(1, 0));
+}
+
+TEST_CASE("Frame profiler")
+{
+    using namespace Simple::Renderer;
+    using namespace std::chrono_literals;
+
+    FrameProfiler profiler;
+
+    SECTION("Nothing is timed while disabled")
+    {
+        profiler.beginFrame();
+        {
+            const auto timer = profiler.time(FramePhase::sort);
+            std::this_thread::sleep_for(1ms);
+        }
+        profiler.endFrame();
+
+        CHECK(profiler.getLastStats().getPhase(FramePhase::sort) == 0.0);
+        CHECK(profiler.getLastStats().cpu_ms == 0.0);
+    }
+
+    SECTION("CPU time is recorded for each phase")
+    {
+        profiler.setEnabled(true);
+
+        profiler.beginFrame();
+        {
+            const auto timer = profiler.time(FramePhase::sort);
+            std::this_thread::sleep_for(2ms);
+        }
+        for (int i = 0; i < 2; i++)
+        {
+            const auto timer = profiler.time(FramePhase::upload);
+            std::this_thread::sleep_for(1ms);
+        }
+        profiler.endFrame();
+
+        const FrameStats &stats = profiler.getLastStats();
+        CHECK(stats.getPhase(FramePhase::sort) >= 2.0);
+        CHECK(stats.getPhase(FramePhase::upload) >= 2.0);
+        CHECK(stats.getPhase(FramePhase::cull) == 0.0);
+        CHECK(stats.cpu_ms >= stats.getPhase(FramePhase::sort) + stats.getPhase(FramePhase::upload));
+
+        // a frame without the sort phase halves its average over the two frames
+        profiler.beginFrame();
+        profiler.endFrame();
+        CHECK(profiler.getLastStats().getPhase(FramePhase::sort) == 0.0);
+        CHECK(profiler.getAverageStats().getPhase(FramePhase::sort) ==
+              Approx(stats.getPhase(FramePhase::sort) / 2.0));
+    }
+
+    SECTION("GPU time is read once available, without waiting for it")
+    {
+        profiler.setEnabled(true);
+
+        profiler.beginFrame();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        profiler.endFrame();
+
+        // the result is only collected by a later frame
+        CHECK(profiler.getLastStats().gpu_ms == 0.0);
+
+        glFinish();
+        profiler.beginFrame();
+        profiler.endFrame();
+        CHECK(profiler.getLastStats().gpu_ms > 0.0);
+
+        // frames keep being timed on the CPU however far behind the GPU is
+        for (int i = 0; i < 10; i++)
+        {
+            profiler.beginFrame();
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            profiler.endFrame();
+            CHECK(profiler.getLastStats().cpu_ms > 0.0);
+        }
+    }
+
+    SECTION("RenderQueue times finishFrame()")
+    {
+        const Camera camera;
+        RenderQueue render_queue;
+        CHECK_FALSE(render_queue.getProfiling());
+        render_queue.setProfiling(true);
+
+        const ShaderProgram program(test_vertex_shader, test_fragment_shader);
+        const std::vector<glm::vec3> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+        const Mesh mesh(positions, {}, {});
+        render_queue.draw(mesh, program, glm::mat4(1.0f));
+        render_queue.finishFrame(camera);
+
+        const FrameStats &stats = render_queue.getFrameStats();
+        double phase_sum = 0.0;
+        for (const double phase_ms: stats.cpu_phase_ms)
+            phase_sum += phase_ms;
+
+        CHECK(stats.cpu_ms > 0.0);
+        CHECK(stats.getPhase(FramePhase::submit) > 0.0);
+        CHECK(phase_sum <= stats.cpu_ms);
+    }
+}
+
+TEST_CASE("Multi draw indirect submission")
+{
+    using namespace Simple::Renderer;
+
+    // both stages read model_matrix: the vertex stage places a quad on pixel column i, the fragment stage colors it
+    constexpr std::size_t draw_count = 8;
+    const ShaderProgram program(test_vertex_shader, R"glsl(
+void main()
+{
+    frag_color = vec4(model_matrix[3].x / 8.0f, 0.0f, 0.0f, 1.0f);
+}
+)glsl");
+
+    const std::vector<glm::vec3> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}};
+    const std::vector<unsigned int> indices {0, 1, 2, 2, 1, 3};
+    const Mesh quad(positions, {}, {}, indices);
+
+    Camera camera;
+    camera.setProjectionMatrix(glm::ortho(0.0f, static_cast<float>(draw_count), 0.0f, 1.0f, -1.0f, 1.0f));
+
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+    glTextureStorage2D(texture, 1, GL_RGBA8, draw_count, 1);
+    glCreateFramebuffers(1, &framebuffer);
+    glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    setViewport(glm::ivec2(0), glm::ivec2(draw_count, 1));
+
+    bool has_shader_draw_parameters = false;
+    GLint extension_count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extension_count);
+    for (GLint i = 0; i < extension_count; i++)
+    {
+        const auto *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        has_shader_draw_parameters |= std::strcmp(name, "GL_ARB_shader_draw_parameters") == 0;
+    }
+
+    const auto render = [&](SubmissionMode mode)
+    {
+        RenderQueue render_queue;
+        render_queue.setSubmissionMode(mode);
+
+        // without shader draw parameters, batched draws couldn't find their model matrix; they are drawn one by one
+        CHECK(render_queue.usesMultiDrawIndirect() ==
+              (mode == SubmissionMode::multi_draw_indirect && has_shader_draw_parameters));
+
+        for (std::size_t i = 0; i < draw_count; i++)
+            render_queue.draw(quad, program,
+                              glm::translate(glm::mat4(1.0f), glm::vec3(static_cast<float>(i), 0.0f, 0.0f)));
+        render_queue.finishFrame(camera);
+
+        std::vector<glm::vec<4, std::uint8_t>> pixels(draw_count);
+        glGetTextureImage(texture, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                          static_cast<GLsizei>(pixels.size() * sizeof(glm::vec<4, std::uint8_t>)), pixels.data());
+        return pixels;
+    };
+
+    const std::vector<glm::vec<4, std::uint8_t>> immediate = render(SubmissionMode::immediate);
+    for (std::size_t i = 0; i < draw_count; i++)
+        CHECK(std::abs(immediate[i].x - static_cast<int>(i * 255 / draw_count)) <= 1);
+
+    CHECK(render(SubmissionMode::multi_draw_indirect) == immediate);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    setViewport(glm::ivec2(0), glm::ivec2(10, 10));
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteTextures(1, &texture);
+}
+
+TEST_CASE("Geometry arena")
+{
+    using Simple::Renderer::GeometryArena;
+    using Simple::Renderer::MemoryCategory;
+    using Simple::Renderer::MemoryTracker;
+
+    const auto &tracker = MemoryTracker::get();
+    const std::size_t base_index_usage = tracker.getUsage(MemoryCategory::index);
+
+    constexpr std::uint32_t page_vertex_count = 64;
+    constexpr std::uint32_t page_index_count = 128;
+    GeometryArena arena(page_vertex_count, page_index_count);
+
+    const auto make_positions = [](std::size_t count, float z)
+    {
+        std::vector<glm::vec3> positions(count);
+        for (std::size_t i = 0; i < count; i++)
+            positions[i] = glm::vec3(static_cast<float>(i), 0.0f, z);
+        return positions;
+    };
+
+    // the buffers of a page, found through its vertex array
+    const auto read_page = [&arena](const GeometryArena::Allocation &allocation, GLenum binding, std::size_t size)
+    {
+        const GLuint vertex_array = arena.getVertexArray(allocation).getName();
+        GLint buffer = 0;
+        if (binding == GL_ELEMENT_ARRAY_BUFFER_BINDING)
+            glGetVertexArrayiv(vertex_array, binding, &buffer);
+        else
+            glGetVertexArrayIndexediv(vertex_array, 0, GL_VERTEX_BINDING_BUFFER, &buffer);
+
+        std::vector<std::byte> data(size);
+        glGetNamedBufferSubData(static_cast<GLuint>(buffer), 0, static_cast<GLsizeiptr>(size), data.data());
+        return data;
+    };
+    const auto read_positions = [&](const GeometryArena::Allocation &allocation)
+    {
+        const auto data = read_page(allocation, GL_VERTEX_BINDING_BUFFER,
+                                    (allocation.first_vertex + allocation.vertex_count) * sizeof(glm::vec3));
+        std::vector<glm::vec3> positions(allocation.vertex_count);
+        std::memcpy(positions.data(), data.data() + allocation.first_vertex * sizeof(glm::vec3),
+                    positions.size() * sizeof(glm::vec3));
+        return positions;
+    };
+    const auto read_indices = [&](const GeometryArena::Allocation &allocation)
+    {
+        const auto data = read_page(allocation, GL_ELEMENT_ARRAY_BUFFER_BINDING,
+                                    (allocation.first_index + allocation.index_count) * sizeof(unsigned int));
+        std::vector<unsigned int> indices(allocation.index_count);
+        std::memcpy(indices.data(), data.data() + allocation.first_index * sizeof(unsigned int),
+                    indices.size() * sizeof(unsigned int));
+        return indices;
+    };
+
+    // non-indexed geometry doesn't allocate index storage
+    const auto points = make_positions(16, 1.0f);
+    const auto non_indexed = arena.allocate(points, {}, {});
+    CHECK(arena.getPageCount() == 1);
+    CHECK(non_indexed.index_count == 0);
+    CHECK(read_positions(non_indexed) == points);
+    CHECK(tracker.getUsage(MemoryCategory::index) == base_index_usage);
+
+    // the first indexed geometry of the page does, once
+    const auto triangle_positions = make_positions(3, 2.0f);
+    const std::vector<unsigned int> triangle_indices {0, 1, 2, 2, 1, 0};
+    const auto indexed = arena.allocate(triangle_positions, {}, {}, triangle_indices);
+    CHECK(indexed.page == non_indexed.page);
+    CHECK(indexed.first_vertex >= non_indexed.first_vertex + non_indexed.vertex_count);
+    CHECK(tracker.getUsage(MemoryCategory::index) - base_index_usage == page_index_count * sizeof(unsigned int));
+
+    const auto other_indexed = arena.allocate(triangle_positions, {}, {}, triangle_indices);
+    CHECK(other_indexed.page == indexed.page);
+    CHECK(other_indexed.first_index >= indexed.first_index + indexed.index_count);
+    CHECK(tracker.getUsage(MemoryCategory::index) - base_index_usage == page_index_count * sizeof(unsigned int));
+
+    CHECK(read_positions(indexed) == triangle_positions);
+    CHECK(read_indices(indexed) == triangle_indices);
+    CHECK(read_indices(other_indexed) == triangle_indices);
+
+    // released ranges are reused
+    arena.deallocate(non_indexed);
+    const auto more_points = make_positions(16, 3.0f);
+    const auto reused_vertices = arena.allocate(more_points, {}, {});
+    CHECK(reused_vertices.page == non_indexed.page);
+    CHECK(reused_vertices.first_vertex == non_indexed.first_vertex);
+    CHECK(read_positions(reused_vertices) == more_points);
+
+    arena.deallocate(indexed);
+    const std::vector<unsigned int> reversed_indices {2, 1, 0, 0, 1, 2};
+    const auto reused_indices = arena.allocate(triangle_positions, {}, {}, reversed_indices);
+    CHECK(reused_indices.page == indexed.page);
+    CHECK(reused_indices.first_index == indexed.first_index);
+    CHECK(read_indices(reused_indices) == reversed_indices);
+    CHECK(read_indices(other_indexed) == triangle_indices);
+
+    // a different vertex format, and geometry bigger than a page, get new pages
+    const std::vector<glm::vec3> normals(3, glm::vec3(0.0f, 0.0f, 1.0f));
+    const auto with_normals = arena.allocate(triangle_positions, normals, {});
+    CHECK(with_normals.page != indexed.page);
+
+    const auto big = make_positions(page_vertex_count * 2, 4.0f);
+    const auto big_allocation = arena.allocate(big, {}, {});
+    CHECK(big_allocation.page != indexed.page);
+    CHECK(big_allocation.page != with_normals.page);
+    CHECK(arena.getPageCount() == 3);
+    CHECK(read_positions(big_allocation) == big);
+
+    // neither new page holds indexed geometry
+    CHECK(tracker.getUsage(MemoryCategory::index) - base_index_usage == page_index_count * sizeof(unsigned int));
+}
+
+TEST_CASE("Dirty range set")
+{
+    Simple::Renderer::DirtyRangeSet ranges;
+
+    ranges.add(100, 110);
+    ranges.add(10, 20);
+    ranges.add(50, 60);
+    ranges.add(15, 30);     // overlaps [10, 20)
+    ranges.add(30, 40);     // touches [10, 30)
+    ranges.add(70, 70);     // empty
+
+    using Pairs = std::vector<std::pair<std::size_t, std::size_t>>;
+    const auto get_pairs = [&ranges]
+    {
+        Pairs result;
+        for (const auto &range: ranges.getRanges())
+            result.emplace_back(range.begin, range.end);
+        return result;
+    };
+
+    CHECK(get_pairs() == Pairs{{10, 40}, {50, 60}, {100, 110}});
+    CHECK(ranges.getSize() == 50);
+
+    ranges.add(45, 105);
+    CHECK(get_pairs() == Pairs{{10, 40}, {45, 110}});
+
+    ranges.add(200, 210);
+    ranges.coalesce(5);
+    CHECK(get_pairs() == Pairs{{10, 110}, {200, 210}});
+
+    ranges.clear();
+    CHECK(ranges.empty());
+}
+
+TEST_CASE("Memory tracker")
+{
+    using Simple::Renderer::MemoryCategory;
+    using Simple::Renderer::TrackedMemory;
+
+    auto &tracker = Simple::Renderer::MemoryTracker::get();
+    const std::size_t base_usage = tracker.getUsage(MemoryCategory::staging);
+    const std::size_t base_total = tracker.getTotalUsage();
+
+    std::size_t callback_total = 0;
+    tracker.setBudget(base_total + 1000, [&callback_total](std::size_t total, std::size_t) { callback_total = total; });
+    tracker.resetPeakUsage();
+
+    {
+        TrackedMemory a(MemoryCategory::staging, 600);
+        CHECK(tracker.getUsage(MemoryCategory::staging) == base_usage + 600);
+        CHECK(callback_total == 0);
+
+        TrackedMemory b(MemoryCategory::staging, 300);
+        b.resize(500);
+        CHECK(callback_total == base_total + 1100);
+
+        a = std::move(b);
+        CHECK(tracker.getUsage(MemoryCategory::staging) == base_usage + 500);
+    }
+
+    CHECK(tracker.getUsage(MemoryCategory::staging) == base_usage);
+    CHECK(tracker.getTotalUsage() == base_total);
+    CHECK(tracker.getPeakUsage(MemoryCategory::staging) == base_usage + 1100);
+    CHECK(tracker.getPeakTotalUsage() == base_total + 1100);
+
+    tracker.setBudget(0, nullptr);
+}
+
+TEST_CASE("Vertex encoding")
+{
+    using namespace Simple::Renderer;
+
+    SECTION("half floats")
+    {
+        CHECK(encodeHalf(1.0f) == 0x3c00);
+        CHECK(encodeHalf(-2.0f) == 0xc000);
+        CHECK(encodeHalf(65504.0f) == 0x7bff);
+        CHECK(encodeHalf(65520.0f) == 0x7c00);          // rounds to infinity
+        CHECK(encodeHalf(std::ldexp(1.0f, -24)) == 1);   // smallest subnormal
+        CHECK(encodeHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3c00);  // ties to even
+
+        for (std::uint16_t value = 0; value < 0x7c00; value++)
+            CHECK(encodeHalf(decodeHalf(value)) == value);
+    }
+
+    SECTION("octahedral normals")
+    {
+        auto normal = GENERATE(take(100, vec3(random(-1.0f, 1.0f))));
+        if (glm::length(normal) < 0.01f)
+            normal = glm::vec3(0.0f, 0.0f, -1.0f);
+        normal = glm::normalize(normal);
+
+        CHECK(glm::dot(decodeOctahedralNormal(encodeOctahedralNormal(normal)), normal) > 0.99999f);
+    }
+
+    SECTION("positions")
+    {
+        const AxisAlignedBox bounds{glm::vec3(-1.0f, 2.0f, 0.0f), glm::vec3(3.0f, 4.0f, 1.0f)};
+        const auto quantization = PositionQuantization::fromBounds(bounds);
+        CHECK(quantization.scale == 2.0f);
+
+        for (const glm::vec3 &position: {bounds.min, bounds.max, glm::vec3(0.3f, 2.5f, 0.9f)})
+        {
+            const auto encoded = quantization.encode(position);
+            CHECK(glm::length(quantization.decode(encoded) - position) < 1e-4f);
+
+            const glm::vec3 normalized = glm::vec3(encoded) / 32767.0f;
+            const glm::vec4 restored = quantization.getDequantizationTransform() * glm::vec4(normalized, 1.0f);
+            CHECK(glm::length(glm::vec3(restored) - position) < 1e-4f);
+        }
+    }
+
+    CHECK(encodeUnorm16(glm::vec2(0.5f, 2.0f)) == glm::vec<2, std::uint16_t>(32768, 65535));
+}
+
+TEST_CASE("Interleaved Mesh")
+{
+    using namespace Simple::Renderer;
+
+    const bool has_normals = GENERATE(false, true);
+    const bool has_uvs = GENERATE(false, true);
+
+    const std::vector<glm::vec3> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}};
+    const std::vector<glm::vec3> normals(positions.size(), glm::vec3(0.0f, 0.0f, 1.0f));
+    const std::vector<glm::vec2> uvs {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+    const std::vector<unsigned int> indices {0, 1, 2, 2, 1, 3};
+
+    const Mesh mesh(positions, has_normals ? normals : std::vector<glm::vec3>(),
+                    has_uvs ? uvs : std::vector<glm::vec2>(), indices, MeshLayout::interleaved);
+    CHECK(mesh.getLayout() == MeshLayout::interleaved);
+
+    const ShaderProgram program(test_vertex_shader, test_fragment_shader);
+    const Camera camera;
+    RenderQueue render_queue;
+    render_queue.setFrustumCulling(false);
+
+    FrameCapture capture;
+    render_queue.captureNextFrame(capture);
+    render_queue.draw(mesh, program, glm::mat4(1.0f));
+    render_queue.finishFrame(camera);
+
+    REQUIRE(capture.commands.size() == 1);
+    CHECK(capture.commands[0].count == indices.size());
+    const FrameCapture::VertexArray &vertex_array = capture.vertex_arrays.at(capture.commands[0].vertex_array);
+
+    // every attribute is read from a single binding, at its offset within InterleavedVertex
+    REQUIRE(vertex_array.bindings.size() == 1);
+    const FrameCapture::VertexBufferBinding &binding = vertex_array.bindings[0];
+    CHECK(binding.stride == sizeof(InterleavedVertex));
+
+    REQUIRE(vertex_array.attributes.size() == 3);
+    for (const auto &attribute: vertex_array.attributes)
+        CHECK(attribute.binding == binding.index);
+
+    std::map<std::uint32_t, std::uint32_t> relative_offsets;
+    for (const auto &attribute: vertex_array.attributes)
+        relative_offsets[attribute.index] = attribute.relative_offset;
+    CHECK(relative_offsets[Simple::vertex_position_def.layout.location] == offsetof(InterleavedVertex, position));
+    CHECK(relative_offsets[Simple::vertex_normal_def.layout.location] == offsetof(InterleavedVertex, normal));
+    CHECK(relative_offsets[Simple::vertex_uv_def.layout.location] == offsetof(InterleavedVertex, uv));
+
+    // attributes the mesh doesn't have are zero
+    std::vector<InterleavedVertex> expected(positions.size());
+    for (std::size_t i = 0; i < positions.size(); i++)
+    {
+        expected[i].position = positions[i];
+        expected[i].normal = has_normals ? normals[i] : glm::vec3(0.0f);
+        expected[i].uv = has_uvs ? uvs[i] : glm::vec2(0.0f);
+    }
+
+    const auto &buffer_data = capture.buffers.at(binding.buffer).data;
+    const std::size_t vertices_size = expected.size() * sizeof(InterleavedVertex);
+    REQUIRE(binding.offset + vertices_size <= buffer_data.size());
+    CHECK(std::memcmp(buffer_data.data() + binding.offset, expected.data(), vertices_size) == 0);
+
+    // the indices follow the vertices in the same buffer
+    CHECK(vertex_array.element_buffer == binding.buffer);
+}
+
+TEST_CASE("Index narrowing")
+{
+    using Simple::IndexType;
+    using Simple::Renderer::IndexDataInitializer;
+
+    const std::vector<unsigned int> indices {0, 1, 2, 65535, 2, 1};
+    const IndexDataInitializer initializer(indices);
+    CHECK(initializer.size() == indices.size());
+
+    std::vector<std::uint16_t> narrowed(indices.size());
+    initializer(IndexType::unsigned_short, reinterpret_cast<std::byte *>(narrowed.data()));
+    CHECK(std::equal(narrowed.begin(), narrowed.end(), indices.begin()));
+
+    const std::vector<std::uint8_t> small_indices {0, 1, 2, 255};
+    const IndexDataInitializer small_initializer(small_indices);
+    std::vector<unsigned int> widened(small_indices.size());
+    small_initializer(IndexType::unsigned_int, reinterpret_cast<std::byte *>(widened.data()));
+    CHECK(std::equal(widened.begin(), widened.end(), small_indices.begin()));
+
+    CHECK(!IndexDataInitializer());
+
+    // a mesh with few vertices stores 16-bit indices, recorded as index memory apart from its vertices
+    using Simple::Renderer::MemoryCategory;
+    using Simple::Renderer::MemoryTracker;
+
+    const auto &tracker = MemoryTracker::get();
+    const std::size_t base_vertex_usage = tracker.getUsage(MemoryCategory::vertex);
+    const std::size_t base_index_usage = tracker.getUsage(MemoryCategory::index);
+    {
+        const std::vector<glm::vec3> positions {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0}};
+        const std::vector<unsigned int> quad_indices {0, 1, 2, 2, 1, 3};
+        const Simple::Renderer::Mesh mesh(positions, {}, {}, quad_indices);
+
+        CHECK(mesh.getIndexType() == IndexType::unsigned_short);
+        CHECK(tracker.getUsage(MemoryCategory::index) - base_index_usage ==
+              quad_indices.size() * sizeof(std::uint16_t));
+        CHECK(tracker.getUsage(MemoryCategory::vertex) - base_vertex_usage == positions.size() * sizeof(glm::vec3));
+    }
+    CHECK(tracker.getUsage(MemoryCategory::index) == base_index_usage);
+    CHECK(tracker.getUsage(MemoryCategory::vertex) == base_vertex_usage);
+}
+
+TEST_CASE("Radix sort")
+{
+    auto keys = GENERATE(take(3, chunk(1000, random(std::uint64_t(0), std::numeric_limits<std::uint64_t>::max()))));
+    auto shift = GENERATE(0, 32, 56);
+
+    std::vector<Simple::Renderer::SortItem> items;
+    for (std::uint64_t key : keys)
+        items.push_back({key >> shift, static_cast<std::uint32_t>(items.size())});
+
+    auto expected = items;
+    std::stable_sort(expected.begin(), expected.end(), [](const auto& l, const auto& r) { return l.key < r.key; });
+
+    std::vector<Simple::Renderer::SortItem> scratch;
+    Simple::Renderer::radixSort(items, scratch);
+
+    REQUIRE(items.size() == expected.size());
+    for (std::size_t i = 0; i < items.size(); i++)
+    {
+        CHECK(items[i].key == expected[i].key);
+        CHECK(items[i].payload == expected[i].payload);
+    }
+}
+
+TEST_CASE("Frustum culling")
+{
+    using namespace Simple::Renderer;
+
+    // the identity matrix gives the frustum -1 <= x, y, z <= 1, for which the box test is exact.
+    const Frustum frustum = Frustum::fromMatrix(glm::mat4(1.0f));
+
+    // counts around the SIMD width exercise both the vector loop and the scalar remainder
+    const std::size_t box_count = GENERATE(1, 3, 4, 7, 8, 9, 17, 1000);
+
+    std::mt19937 random{static_cast<std::uint32_t>(box_count)};
+    std::uniform_real_distribution<float> center_distribution{-3.0f, 3.0f};
+    std::uniform_real_distribution<float> extent_distribution{0.0f, 1.0f};
+
+    BoundingBoxArray boxes;
+    std::vector<std::uint8_t> expected;
+
+    for (std::size_t i = 0; i < box_count; i++)
+    {
+        const glm::vec3 center{center_distribution(random), center_distribution(random), center_distribution(random)};
+        const glm::vec3 extents{extent_distribution(random), extent_distribution(random), extent_distribution(random)};
+
+        // translate a box around the origin, to check that transforms are applied
+        boxes.push_back({-extents, extents}, glm::translate(glm::mat4(1.0f), center));
+
+        const glm::vec3 distance = glm::abs(center) - extents;
+        expected.push_back(distance.x <= 1.0f && distance.y <= 1.0f && distance.z <= 1.0f);
+    }
+
+    boxes.pushUnbounded();
+    expected.push_back(1);
+
+    std::vector<std::uint8_t> visibility;
+    const std::size_t visible_count = boxes.cull(frustum, visibility);
+
+    CHECK(visibility == expected);
+    CHECK(visible_count == static_cast<std::size_t>(std::count(expected.begin(), expected.end(), 1)));
+}
+
+TEST_CASE("State cache")
+{
+    using namespace Simple::Renderer;
+
+    StateCache &cache = StateCache::get();
+    cache.invalidate();
+    cache.resetStats();
+
+    cache.setCapability(GL_DEPTH_TEST, true);
+    cache.setCapability(GL_DEPTH_TEST, true);
+    cache.setCapability(GL_DEPTH_TEST, false);
+    cache.setDepthFunction(GL_LESS);
+    cache.setDepthFunction(GL_LESS);
+
+    CHECK(cache.getStats().issued_calls == 3);
+    CHECK(cache.getStats().skipped_calls == 2);
+
+    cache.invalidate();
+    cache.setDepthFunction(GL_LESS);
+
+    CHECK(cache.getStats().issued_calls == 4);
+}
+
+TEST_CASE("Frame capture serialization")
+{
+    using namespace Simple::Renderer;
+
+    FrameCapture capture;
+    capture.view_matrix = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+    capture.buffers.push_back({{std::byte{1}, std::byte{2}, std::byte{3}}});
+    capture.vertex_arrays.push_back({{{0, 0, 0, 3, GL_FLOAT, 0, 0, 1}}, {{0, 0, 48, 12, 0}}, 0});
+    capture.programs.push_back({1, {std::byte{4}}, {{2, GL_FLOAT_VEC2, {5, 6}}}});
+    capture.draws.push_back({glm::mat4(2.0f), 0, 7});
+    capture.commands.push_back({0, 0, 1, GL_TRIANGLES, 0, 36, GL_UNSIGNED_INT, 16, 0, -4});
+
+    std::stringstream stream;
+    capture.write(stream);
+
+    // every field is written at its own size, without padding
+    const std::size_t header_size = 4 + 4 + 2 * 64;
+    const std::size_t buffers_size = 8 + 8 + 3;
+    const std::size_t vertex_arrays_size = 8 + (8 + 23) + (8 + 24) + 4;
+    const std::size_t programs_size = 8 + 4 + (8 + 1) + (8 + 4 + 4 + 8 + 2 * 4);
+    const std::size_t draws_size = 8 + 64 + 4 + 1;
+    const std::size_t commands_size = 8 + 41;
+    CHECK(stream.str().size() ==
+          header_size + buffers_size + vertex_arrays_size + programs_size + draws_size + commands_size);
+
+    const FrameCapture result = FrameCapture::read(stream);
+
+    CHECK(result.view_matrix == capture.view_matrix);
+    CHECK(result.buffers.at(0).data == capture.buffers[0].data);
+    CHECK(result.vertex_arrays.at(0).attributes.at(0).type == GL_FLOAT);
+    CHECK(result.vertex_arrays[0].attributes[0].long_ == 1);
+    CHECK(result.vertex_arrays[0].bindings.at(0).offset == 48);
+    CHECK(result.vertex_arrays[0].bindings[0].stride == 12);
+    CHECK(result.vertex_arrays[0].element_buffer == 0);
+    CHECK(result.programs.at(0).binary == capture.programs[0].binary);
+    CHECK(result.programs[0].uniforms.at(0).components == capture.programs[0].uniforms[0].components);
+    CHECK(result.draws.at(0).model_matrix == capture.draws[0].model_matrix);
+    CHECK(result.draws[0].layer == 7);
+    CHECK(result.commands.at(0).count == 36);
+    CHECK(result.commands[0].offset == 16);
+    CHECK(result.commands[0].base_vertex == -4);
+
+    // references to missing objects are rejected
+    capture.draws[0].program = 1;
+    std::stringstream invalid_stream;
+    capture.write(invalid_stream);
+    CHECK_THROWS_AS(FrameCapture::read(invalid_stream), std::runtime_error);
+}
+
+TEST_CASE("Allocation registry")
+{
+    using Simple::AllocationRegistry;
+
+    constexpr std::size_t registry_size = 1 << 16;
+    AllocationRegistry registry(registry_size);
+
+    CHECK(registry.getMaxAllocation() == registry_size);
+
+    // offset -> size of each live allocation
+    std::map<std::size_t, std::size_t> allocations;
+    std::mt19937 random(GENERATE(1u, 2u, 3u));
+    std::uniform_int_distribution<std::size_t> size_distribution(1, 2048);
+
+    for (int i = 0; i < 5000; i++)
+    {
+        if (allocations.empty() || random() % 3 != 0)
+        {
+            const std::size_t size = size_distribution(random);
+            const std::size_t max_allocation = registry.getMaxAllocation();
+            const auto offset = registry.tryAllocate(size);
+
+            REQUIRE(offset.has_value() == (size <= max_allocation));
+            if (!offset)
+                continue;
+
+            REQUIRE(*offset + size <= registry_size);
+
+            // must not overlap the neighbouring allocations
+            const auto next = allocations.lower_bound(*offset);
+            if (next != allocations.end())
+                REQUIRE(*offset + size <= next->first);
+            if (next != allocations.begin())
+                REQUIRE(std::prev(next)->first + std::prev(next)->second <= *offset);
+
+            allocations.emplace(*offset, size);
+        }
+        else
+        {
+            auto iter = allocations.begin();
+            std::advance(iter, random() % allocations.size());
+            REQUIRE(registry.tryDeallocate(iter->first));
+            REQUIRE_FALSE(registry.tryDeallocate(iter->first));
+            allocations.erase(iter);
+        }
+    }
+
+    std::size_t used_bytes = 0;
+    for (const auto &[offset, size]: allocations)
+        used_bytes += size;
+
+    const auto report = registry.getFragmentationReport();
+    CHECK(report.free_bytes == registry_size - used_bytes);
+    CHECK(report.used_block_count == allocations.size());
+    CHECK(report.largest_free_block == registry.getMaxAllocation());
+
+    // moving every block down in order of offset packs them at the start
+    std::map<std::size_t, std::size_t> moved_allocations;
+    std::size_t packed_end = 0;
+    for (const auto &[offset, size]: allocations)
+    {
+        const auto new_offset = registry.tryMoveDown(offset);
+        REQUIRE(new_offset.has_value() == (offset != packed_end));
+        CHECK(new_offset.value_or(offset) == packed_end);
+        CHECK_FALSE(registry.canMoveDown(packed_end));
+
+        moved_allocations.emplace(packed_end, size);
+        packed_end += size;
+    }
+    allocations = std::move(moved_allocations);
+
+    CHECK(registry.getMaxAllocation() == registry_size - used_bytes);
+    CHECK(registry.getFragmentationReport().free_block_count == (used_bytes < registry_size ? 1 : 0));
+
+    // freed blocks are merged, so all the space is available again
+    for (const auto &[offset, size]: allocations)
+        registry.deallocate(offset);
+
+    CHECK(registry.getMaxAllocation() == registry_size);
+    CHECK(registry.getFragmentationReport().free_block_count == 1);
+    CHECK(registry.getFragmentationReport().external_fragmentation == 0.0);
+}